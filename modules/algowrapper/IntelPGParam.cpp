@@ -34,10 +34,47 @@ IntelPGParam::IntelPGParam(int pgId, int cameraId, TuningMode tuningMode)
           mPgManifest(nullptr),
           mProcessGroup(nullptr),
           mProgramControlInitTerminalIndex(-1),
-          mProcessGroupMemory(nullptr) {
+          mProcessGroupMemory(nullptr),
+          mEncodeCacheValid(false),
+          mPalHash(0),
+          mPalSize(0),
+          mEncodeCount(0),
+          mEncodeSkipCount(0) {
     UNUSED(cameraId);
     UNUSED(tuningMode);
     CLEAR(mP2pCacheBuffer);
+    CLEAR(mEncodedPayloads);
+    CLEAR(mVolatileTerminals);
+
+    // The payloads of these pairs are swapped and written by HW
+    std::vector<TerminalPair> pairs;
+    PGUtils::getTerminalPairs(pgId, PGUtils::TERMINAL_PAIR_DVS, &pairs);
+    PGUtils::getTerminalPairs(pgId, PGUtils::TERMINAL_PAIR_TNR_SIM, &pairs);
+    for (auto& pair : pairs) {
+        if (pair.inId >= 0 && pair.inId < IPU_MAX_TERMINAL_COUNT) {
+            mVolatileTerminals[pair.inId] = true;
+        }
+        if (pair.outId >= 0 && pair.outId < IPU_MAX_TERMINAL_COUNT) {
+            mVolatileTerminals[pair.outId] = true;
+        }
+    }
+}
+
+// FNV-1a on 64-bit words, the tail bytes are hashed one by one
+static uint64_t hashPalData(const ia_binary_data* data) {
+    const uint64_t kPrime = 1099511628211ULL;
+    uint64_t hash = 14695981039346656037ULL;
+    const uint8_t* ptr = static_cast<const uint8_t*>(data->data);
+    uint32_t i = 0;
+    for (; i + sizeof(uint64_t) <= data->size; i += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        MEMCPY_S(&word, sizeof(word), ptr + i, sizeof(word));
+        hash = (hash ^ word) * kPrime;
+    }
+    for (; i < data->size; i++) {
+        hash = (hash ^ ptr[i]) * kPrime;
+    }
+    return hash;
 }
 
 IntelPGParam::~IntelPGParam() {
@@ -143,6 +180,8 @@ int IntelPGParam::prepare(const ia_binary_data* ipuParameters, const ia_css_rbm_
     int8_t termIndex;
     int kernelId = 0;
 
+    // The terminal requirements are queried again, so the encoded payloads are out of date
+    mEncodeCacheValid = false;
     ia_err err = ia_p2p_parse(mP2pHandle, ipuParameters, mP2pCacheBuffer.data);
     CheckAndLogError(err != ia_err_none, UNKNOWN_ERROR, "Failed to parse PAL data.");
 
@@ -411,6 +450,7 @@ void IntelPGParam::destroyPGBuffer() {
 int IntelPGParam::setPGAndPrepareProgram(ia_css_process_group_t* pg) {
     CheckAndLogError(!pg, UNKNOWN_ERROR, "input pg nullptr!");
     mProcessGroup = pg;
+    mEncodeCacheValid = false;
 
     int ret = OK;
     int terminalCount = ia_css_process_group_get_terminal_count(mProcessGroup);
@@ -476,6 +516,7 @@ void IntelPGParam::destroyPayloads() {
 int IntelPGParam::updatePALAndEncode(const ia_binary_data* ipuParams, int payloadCount,
                                      ia_binary_data* payloads) {
     LOG1("@%s", __func__);
+    CheckAndLogError(!ipuParams || !ipuParams->data, UNKNOWN_ERROR, "no PAL data for encode.");
     ia_err err = ia_p2p_parse(mP2pHandle, ipuParams, mP2pCacheBuffer.data);
     CheckAndLogError(err != ia_err_none, UNKNOWN_ERROR, "Failed to parse PAL data.");
 
@@ -484,6 +525,11 @@ int IntelPGParam::updatePALAndEncode(const ia_binary_data* ipuParams, int payloa
                      "small payload count %d, should be %d", payloadCount, mTerminalCount);
     CheckAndLogError(!mProcessGroup, INVALID_OPERATION, "Can't encode due to null pg.");
 
+    uint64_t palHash = hashPalData(ipuParams);
+    bool palChanged = !mEncodeCacheValid || palHash != mPalHash || ipuParams->size != mPalSize;
+    // Set it again when all the terminals are encoded successfully
+    mEncodeCacheValid = false;
+
     int ret = OK;
     int terminalCount = ia_css_process_group_get_terminal_count(mProcessGroup);
     ia_css_terminal_t* programControlInitTerminal = nullptr;
@@ -500,19 +546,43 @@ int IntelPGParam::updatePALAndEncode(const ia_binary_data* ipuParams, int payloa
             continue;
         }
 
+        if (isTerminalEncoded(terminal->tm_index, payloads[terminal->tm_index], palChanged)) {
+            continue;
+        }
         ret = encodeTerminal(terminal, payloads[terminal->tm_index]);
         CheckAndLogError(ret != OK, ret, "Failed to encode for terminal %d.", terminal->tm_index);
+        mEncodedPayloads[terminal->tm_index] = payloads[terminal->tm_index].data;
     }
     if (programControlInitTerminal) {
-        ret = encodeTerminal(programControlInitTerminal,
-                             payloads[programControlInitTerminal->tm_index]);
-        CheckAndLogError(ret != OK, ret, "Failed to encode for program control init terminal %d.",
-                         programControlInitTerminal->tm_index);
+        int index = programControlInitTerminal->tm_index;
+        if (!isTerminalEncoded(index, payloads[index], palChanged)) {
+            ret = encodeTerminal(programControlInitTerminal, payloads[index]);
+            CheckAndLogError(ret != OK, ret,
+                             "Failed to encode for program control init terminal %d.", index);
+            mEncodedPayloads[index] = payloads[index].data;
+        }
     }
 
+    mEncodeCacheValid = true;
+    mPalHash = palHash;
+    mPalSize = ipuParams->size;
+    LOG2("%s, pg %d, encoded %lu, skipped %lu", __func__, mPgId, mEncodeCount, mEncodeSkipCount);
+
     return ret;
 }
 
+bool IntelPGParam::isTerminalEncoded(int terminalIndex, const ia_binary_data& payload,
+                                     bool palChanged) {
+    if (palChanged || mVolatileTerminals[terminalIndex] ||
+        mEncodedPayloads[terminalIndex] != payload.data) {
+        mEncodeCount++;
+        return false;
+    }
+
+    mEncodeSkipCount++;
+    return true;
+}
+
 int IntelPGParam::encodeTerminal(ia_css_terminal_t* terminal, ia_binary_data payload) {
     int ret = OK;
 
@@ -750,6 +820,9 @@ int IntelPGParam::serializeDecodeCache(ia_binary_data* result) {
 }
 
 void IntelPGParam::deinit() {
+    uint64_t total = mEncodeCount + mEncodeSkipCount;
+    LOG1("%s, pg %d, terminal encode %lu, skipped %lu (%lu%%)", __func__, mPgId, mEncodeCount,
+         mEncodeSkipCount, total ? mEncodeSkipCount * 100 / total : 0);
     ia_p2p_deinit(mP2pHandle);
     if (mP2pCacheBuffer.data) {
         CIPR::freeMemory(mP2pCacheBuffer.data);
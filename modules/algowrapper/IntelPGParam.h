@@ -67,6 +67,9 @@ namespace icamera {
  *      decode();
  *    }
  * 8. deinit();
+ *
+ * The encoded payloads are reused if the PAL data is same as the last encoded one, except
+ * the terminals whose payloads are written by HW, such as the DVS and TNR SIM pairs.
  */
 class IntelPGParam {
  public:
@@ -195,6 +198,15 @@ class IntelPGParam {
     std::vector<ia_binary_data> mAllocatedPayloads;
     void* mProcessGroupMemory;
 
+    // Encode cache, it's invalid until the first encode after prepare()
+    bool mEncodeCacheValid;
+    uint64_t mPalHash;
+    uint32_t mPalSize;
+    void* mEncodedPayloads[IPU_MAX_TERMINAL_COUNT];  // payload data of the last encode
+    bool mVolatileTerminals[IPU_MAX_TERMINAL_COUNT];  // always encoded
+    uint64_t mEncodeCount;
+    uint64_t mEncodeSkipCount;
+
  private:
     int getKernelIdByBitmap(ia_css_kernel_bitmap_t bitmap);
     ia_css_kernel_bitmap_t getCachedTerminalKernelBitmap(
@@ -224,6 +236,8 @@ class IntelPGParam {
 
     void dumpFragmentDesc(int fragmentCount);
     int encodeTerminal(ia_css_terminal_t* terminal, ia_binary_data payload);
+    // Return true if the payload of the terminal is still valid, otherwise encode it
+    bool isTerminalEncoded(int terminalIndex, const ia_binary_data& payload, bool palChanged);
     int decodeTerminal(ia_css_terminal_t* terminal, ia_binary_data payload);
     int serializeDecodeCache(ia_binary_data* result);
 
@@ -19,7 +19,11 @@
 #include "modules/algowrapper/graph/GraphConfigImpl.h"
 
 #include <GCSSParser.h>
+#include <fcntl.h>
 #include <graph_query_manager.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <unordered_map>
@@ -42,13 +46,13 @@ namespace icamera {
 
 Mutex GraphConfigImpl::sLock;
 std::unordered_map<int32_t, GraphConfigNodes*> GraphConfigImpl::mGraphNode;
+std::map<std::pair<size_t, uint64_t>, std::shared_ptr<GCSS::IGraphConfig>>
+    GraphConfigImpl::sParsedXml;
+std::unordered_map<GCSS::IGraphConfig*, camera_resolution_t> GraphConfigImpl::sRawInputSizes;
 
-GraphConfigNodes::GraphConfigNodes() : mDesc(nullptr), mSettings(nullptr) {}
+GraphConfigNodes::GraphConfigNodes() {}
 
-GraphConfigNodes::~GraphConfigNodes() {
-    delete mDesc;
-    delete mSettings;
-}
+GraphConfigNodes::~GraphConfigNodes() {}
 
 GraphConfigImpl::GraphConfigImpl()
         : mCameraId(-1),
@@ -71,8 +75,8 @@ GraphConfigImpl::GraphConfigImpl(int32_t camId, ConfigMode mode, GraphSettingTyp
     CheckAndLogError(!nodes, VOID_VALUE, "Failed to allocate Graph Query Manager");
 
     mGraphQueryManager = std::unique_ptr<GCSS::GraphQueryManager>(new GraphQueryManager());
-    mGraphQueryManager->setGraphDescriptor(nodes->mDesc);
-    mGraphQueryManager->setGraphSettings(nodes->mSettings);
+    mGraphQueryManager->setGraphDescriptor(nodes->mDesc.get());
+    mGraphQueryManager->setGraphSettings(nodes->mSettings.get());
 }
 
 GraphConfigImpl::~GraphConfigImpl() {}
@@ -105,6 +109,62 @@ void GraphConfigImpl::addCustomKeyMap() {
     ItemUID::addCustomKeyMap(CUSTOM_GRAPH_KEYS);
 }
 
+/**
+ * Parse the XML data, or return the tree parsed from the same content before.
+ */
+std::shared_ptr<GCSS::IGraphConfig> GraphConfigImpl::parseXmlData(char* data, size_t size) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    }
+    std::pair<size_t, uint64_t> key(size, hash);
+
+    {
+        AutoMutex lock(sLock);
+        auto it = sParsedXml.find(key);
+        if (it != sParsedXml.end()) {
+            LOG2("%s, reuse the tree parsed from the same content, size %zu", __func__, size);
+            return it->second;
+        }
+    }
+
+    GCSSParser parser;
+    GCSS::IGraphConfig* node = nullptr;
+    parser.parseGCSSXmlData(data, size, &node);
+    if (!node) return nullptr;
+
+    std::shared_ptr<GCSS::IGraphConfig> tree(node);
+    AutoMutex lock(sLock);
+    // Keep the first one if the same content is parsed at the same time
+    return sParsedXml.emplace(key, tree).first->second;
+}
+
+/**
+ * Map the XML file and parse it with parseXmlData.
+ */
+std::shared_ptr<GCSS::IGraphConfig> GraphConfigImpl::parseXmlFile(const char* fileName) {
+    int fd = open(fileName, O_RDONLY);
+    CheckAndLogError(fd < 0, nullptr, "Failed to open %s", fileName);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        LOGE("Failed to get the size of %s", fileName);
+        close(fd);
+        return nullptr;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    // Private and writable, since the parser takes a non const buffer
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    CheckAndLogError(data == MAP_FAILED, nullptr, "Failed to map %s", fileName);
+
+    std::shared_ptr<GCSS::IGraphConfig> tree = parseXmlData(static_cast<char*>(data), size);
+    munmap(data, size);
+    return tree;
+}
+
 /**
  * Method to parse the XML graph configurations and settings
  *
@@ -127,18 +187,17 @@ status_t GraphConfigImpl::parse(int cameraId, const char* graphDescFile, const c
         }
     }
 
-    GCSSParser parser;
     GraphConfigNodes* nodes = new GraphConfigNodes;
     LOG2("<id%d>, Start to parse graph config file", cameraId);
 
-    parser.parseGCSSXmlFile(graphDescFile, &nodes->mDesc);
+    nodes->mDesc = parseXmlFile(graphDescFile);
     if (!nodes->mDesc) {
         LOGE("Failed to parse graph descriptor from %s", graphDescFile);
         delete nodes;
         return UNKNOWN_ERROR;
     }
 
-    parser.parseGCSSXmlFile(settingsFile, &nodes->mSettings);
+    nodes->mSettings = parseXmlFile(settingsFile);
     if (!nodes->mSettings) {
         LOGE("Failed to parse graph settings from %s", settingsFile);
         delete nodes;
@@ -176,18 +235,17 @@ status_t GraphConfigImpl::parse(int cameraId, char* graphDescData, size_t descDa
         }
     }
 
-    GCSSParser parser;
     GraphConfigNodes* nodes = new GraphConfigNodes;
     LOG2("<id%d>, Start to parse graph config data", cameraId);
 
-    parser.parseGCSSXmlData(graphDescData, descDataSize, &nodes->mDesc);
+    nodes->mDesc = parseXmlData(graphDescData, descDataSize);
     if (!nodes->mDesc) {
         LOGE("Failed to parse graph descriptor addr: %p, size: %zu", graphDescData, descDataSize);
         delete nodes;
         return UNKNOWN_ERROR;
     }
 
-    parser.parseGCSSXmlData(settingsData, settingsDataSize, &nodes->mSettings);
+    nodes->mSettings = parseXmlData(settingsData, settingsDataSize);
     if (!nodes->mSettings) {
         LOGE("Failed to parse graph settings addr: %p, size: %zu", settingsData, settingsDataSize);
         delete nodes;
@@ -210,6 +268,8 @@ void GraphConfigImpl::releaseGraphNodes() {
         delete nodes.second;
     }
     mGraphNode.clear();
+    sParsedXml.clear();
+    sRawInputSizes.clear();
 }
 
 /**
@@ -346,6 +406,15 @@ status_t GraphConfigImpl::createQueryRule(const vector<HalStream*>& activeStream
 status_t GraphConfigImpl::getRawInputSize(GCSS::IGraphConfig* query, camera_resolution_t* reso) {
     CheckAndLogError(!reso, UNKNOWN_ERROR, "%s, The reso is nullptr", __func__);
 
+    {
+        AutoMutex lock(sLock);
+        auto it = sRawInputSizes.find(query);
+        if (it != sRawInputSizes.end()) {
+            *reso = it->second;
+            return OK;
+        }
+    }
+
     GCSS::IGraphConfig* result = nullptr;
     css_err_t ret = mGraphQueryManager->createGraph(query, &result);
     std::unique_ptr<GCSS::IGraphConfig> graphResult(result);
@@ -362,6 +431,8 @@ status_t GraphConfigImpl::getRawInputSize(GCSS::IGraphConfig* query, camera_reso
         GCSS::IGraphConfig* isysNode = graphResult->getDescendantByString(item.c_str());
         if (isysNode != nullptr) {
             GCSS::GraphCameraUtil::getDimensions(isysNode, &(reso->width), &(reso->height));
+            AutoMutex lock(sLock);
+            sRawInputSizes[query] = *reso;
             return OK;
         }
     }
@@ -378,6 +449,15 @@ status_t GraphConfigImpl::queryAllMatchedResults(
     status_t ret = createQueryRule(activeStreams, dummyStillSink);
     CheckAndLogError(ret != OK, ret, "Failed to create the query rule");
 
+    QueryCacheKey cacheKey;
+    getQueryCacheKey(&cacheKey);
+    auto cached = mQueryCache.find(cacheKey);
+    if (cached != mQueryCache.end()) {
+        LOG2("%s, Use the cached results of the same query", __func__);
+        *queryResults = cached->second;
+        return OK;
+    }
+
     LOG2("%s, The mQuery size: %zu", __func__, mQuery.size());
     for (auto& query : mQuery) {
         mFirstQueryResults.clear();
@@ -401,9 +481,24 @@ status_t GraphConfigImpl::queryAllMatchedResults(
         LOG2("%s, There isn't matched result after filtering with first query rule", __func__);
         return UNKNOWN_ERROR;
     }
+
+    if (mQueryCache.size() >= kMaxQueryCacheSize) mQueryCache.clear();
+    mQueryCache[cacheKey] = *queryResults;
     return OK;
 }
 
+/*
+ * The sink formats are part of the key since selectSetting filters the results with them.
+ */
+void GraphConfigImpl::getQueryCacheKey(QueryCacheKey* key) {
+    key->first = mQuery;
+    for (auto const& useCase : mStreamToSinkIdMap) {
+        for (auto const& item : useCase.second) {
+            key->second[useCase.first][item.second] = item.first->format();
+        }
+    }
+}
+
 bool GraphConfigImpl::queryGraphSettings(const std::vector<HalStream*>& activeStreams) {
     std::map<int, std::vector<GCSS::IGraphConfig*>> useCaseToQueryResults;
     status_t ret = queryAllMatchedResults(activeStreams, false, &useCaseToQueryResults);
@@ -18,6 +18,7 @@
 
 #include <gcss.h>
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -57,8 +58,9 @@ class GraphConfigNodes {
     ~GraphConfigNodes();
 
  public:
-    GCSS::IGraphConfig* mDesc;
-    GCSS::IGraphConfig* mSettings;
+    // The trees may be shared by the cameras with the same XML content
+    std::shared_ptr<GCSS::IGraphConfig> mDesc;
+    std::shared_ptr<GCSS::IGraphConfig> mSettings;
 
  private:
     // Disable copy constructor and assignment operator
@@ -84,6 +86,14 @@ class GraphConfigNodes {
  */
 class GraphConfigImpl {
  public:
+    /**
+     * The query rules and the sink formats of one stream configuration, the setting
+     * selection only depends on them for a given config mode.
+     */
+    typedef std::pair<std::map<int, std::map<GCSS::ItemUID, std::string>>,
+                      std::map<int, std::map<uid_t, int>>>
+        QueryCacheKey;
+
     GraphConfigImpl();
     GraphConfigImpl(int32_t camId, ConfigMode mode, GraphSettingType type);
     virtual ~GraphConfigImpl();
@@ -119,6 +129,7 @@ class GraphConfigImpl {
     status_t queryGraphs(const std::vector<HalStream*>& activeStreams, bool dummyStillSink);
     status_t createQueryRule(const std::vector<HalStream*>& activeStreams, bool dummyStillSink);
     status_t getRawInputSize(GCSS::IGraphConfig* query, camera_resolution_t* reso);
+    void getQueryCacheKey(QueryCacheKey* key);
 
     status_t queryAllMatchedResults(const std::vector<HalStream*>& activeStreams,
                                     bool dummyStillSink,
@@ -135,12 +146,23 @@ class GraphConfigImpl {
     std::string format2GraphStr(int format);
     std::string format2GraphBpp(int format);
 
+    static std::shared_ptr<GCSS::IGraphConfig> parseXmlFile(const char* fileName);
+    static std::shared_ptr<GCSS::IGraphConfig> parseXmlData(char* data, size_t size);
+
     // Debug helper
     void dumpQuery(int useCase, const std::map<GCSS::ItemUID, std::string>& query);
 
  private:
     static Mutex sLock;
     static std::unordered_map<int32_t, GraphConfigNodes*> mGraphNode;
+    /**
+     * The parsed XML trees keyed by the content size and hash, so the graph descriptor and
+     * the graph settings used by several cameras are parsed only once.
+     */
+    static std::map<std::pair<size_t, uint64_t>, std::shared_ptr<GCSS::IGraphConfig>>
+        sParsedXml;
+    // The isys output resolution of the settings nodes, each one needs to create a graph
+    static std::unordered_map<GCSS::IGraphConfig*, camera_resolution_t> sRawInputSizes;
     /**
      * Pair of ItemUIDs to store the width and height of a stream
      * first item is for width, second for height
@@ -179,6 +201,10 @@ class GraphConfigImpl {
     // The stream useCase to result map
     std::map<int, GCSS::IGraphConfig*> mQueryResult;
 
+    // The matched results of the stream configurations queried before
+    static const size_t kMaxQueryCacheSize = 16;
+    std::map<QueryCacheKey, std::map<int, std::vector<GCSS::IGraphConfig*>>> mQueryCache;
+
     // The stream useCase to GraphConfigPipe map
     std::map<int, std::shared_ptr<GraphConfigPipe>> mGraphConfigPipe;
 
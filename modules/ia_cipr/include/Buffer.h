@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <unordered_set>
 
 #include "Types.h"
@@ -35,12 +36,17 @@ class Buffer {
     Result getMemoryCpuPtr(void** ptr);
     Result getMemorySize(int* size);
     Result attatchDevice(Context* ctx);
+    // The cache flush of a registered buffer is skipped if CPU hasn't written it since the last
+    // flush, the owner marks it clean once the flush is done.
+    void setCpuDirty(bool dirty) { mCpuDirty = dirty; }
+    bool isCpuDirty() const { return mCpuDirty; }
 
  private:
     MemoryDesc mMemoryDesc;
     uint32_t mOffset = 0;
     std::unordered_set<Buffer*> mRegions;
     bool mInitialized = false;
+    std::atomic<bool> mCpuDirty{true};
     Context* mContext;
 
  private:
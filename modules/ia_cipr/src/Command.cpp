@@ -183,6 +183,9 @@ Result Command::grokBuffers(const PSysCommandConfig& cfg) {
         mCmd->iocCmd.buffers[i] = *current->mMemoryDesc.sysBuff;
         mCmd->iocCmd.buffers[i].data_offset = current->mOffset;
         mCmd->iocCmd.buffers[i].bytes_used = current->mMemoryDesc.size;
+        if (!cfg.buffers[i]->isCpuDirty()) {
+            mCmd->iocCmd.buffers[i].flags |= IPU_BUFFER_FLAG_NO_FLUSH;
+        }
     }
 
     return Result::OK;
@@ -26,6 +26,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "SysCall.h"
 #include "iutils/CameraLog.h"
 #include "iutils/Utils.h"
 
@@ -97,7 +98,7 @@ Result Context::destroy(MemoryDesc* mem) {
 Context::Context() {
     mInitialized = false;
 
-    mFd = open(DRIVER_NAME, 0, O_RDWR | O_NONBLOCK);
+    mFd = SysCall::getInstance()->open(DRIVER_NAME, 0);
     CheckAndLogError(mFd < 0, VOID_VALUE, "Failed to open PSYS, error: %s", strerror(errno));
 
     mInitialized = true;
@@ -106,7 +107,7 @@ Context::Context() {
 Context::~Context() {
     if (!mInitialized) return;
 
-    int rv = ::close(mFd);
+    int rv = SysCall::getInstance()->close(mFd);
     CheckAndLogError(rv < 0, VOID_VALUE, "Close returned error: %s", strerror(errno));
 }
 
@@ -149,11 +150,7 @@ Result Context::getManifest(uint32_t index, uint32_t* mainfestSize, void* manife
 }
 
 Result Context::doIoctl(int request, void* ptr) {
-#ifdef ANDROID
-    int res = ::ioctl(mFd, request, ptr);
-#else
-    int res = ::ioctl(mFd, (unsigned int)request, ptr);
-#endif
+    int res = SysCall::getInstance()->ioctl(mFd, request, ptr);
     if (res < 0) {
         int errnoCopy = errno;
         // Some are not real errors, so don't print error here
@@ -299,7 +296,7 @@ int ContextPoller::poll() {
     fds.fd = mFd;
     fds.events = mEvents;
 
-    return ::poll(&fds, 1, mTimeout);
+    return SysCall::getInstance()->poll(&fds, 1, mTimeout);
 }
 
 }  // namespace CIPR
@@ -167,11 +167,7 @@ const AiqResult* AiqResultStorage::getAiqResult(int64_t sequence) {
 void AiqResultStorage::updateDvsRunMap(int64_t sequence) {
     AutoWMutex wlock(mDataLock);
 
-    mDvsRunMap[sequence] = true;
-
-    if (mDvsRunMap.size() > kDvsRunMapSize) {
-        mDvsRunMap.erase(mDvsRunMap.begin());
-    }
+    mDvsRunMap.insert(sequence, true);
 }
 
 void AiqResultStorage::clearDvsRunMap() {
@@ -183,11 +179,7 @@ void AiqResultStorage::clearDvsRunMap() {
 bool AiqResultStorage::isDvsRun(int64_t sequence) {
     AutoWMutex rlock(mDataLock);
 
-    if (mDvsRunMap.find(sequence) != mDvsRunMap.end()) {
-        return true;
-    }
-
-    return false;
+    return mDvsRunMap.contains(sequence);
 }
 
 }  // namespace icamera
@@ -30,6 +30,7 @@
 #include "iutils/Utils.h"
 #include "iutils/Thread.h"
 #include "iutils/RWLock.h"
+#include "iutils/SequenceRing.h"
 
 namespace icamera {
 
@@ -151,8 +152,8 @@ class AiqResultStorage {
     AiqStatistics mAiqStatistics[kAiqStatsStorageSize];
 
     static const int kDvsRunMapSize = 15;
-    // first: sequence id, second: true
-    std::map<int64_t, bool> mDvsRunMap;
+    // key: sequence id, value: true
+    SequenceRing<bool, kDvsRunMapSize> mDvsRunMap;
 };
 
 }  // namespace icamera
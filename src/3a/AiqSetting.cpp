@@ -118,6 +118,8 @@ void AiqSetting::updateFrameUsage(const stream_config_t* streamList) {
 
 int AiqSetting::setParameters(const Parameters& params) {
     AutoWMutex wlock(mParamLock);
+    // Lock the params once for all the getters below
+    ParameterHelper::ReadView view(params);
 
     // Update AE related parameters
     params.getAeMode(mAiqParam.aeMode);
@@ -149,8 +149,10 @@ int AiqUnit::configure(const stream_config_t* streamList) {
     return OK;
 }
 
-void AiqUnit::resetIntelCcaHandle(const std::vector<ConfigMode>& configModes) {
+bool AiqUnit::isIntelCcaReinitNeeded(const std::vector<ConfigMode>& configModes,
+                                     size_t* activeStreamCount) {
     bool reinit = false;
+    *activeStreamCount = mActiveStreamCount;
     if ((PlatformData::supportUpdateTuning(mCameraId) || PlatformData::isDvsSupported(mCameraId)) &&
         !configModes.empty()) {
         std::shared_ptr<IGraphConfig> graphConfig =
@@ -162,7 +164,7 @@ void AiqUnit::resetIntelCcaHandle(const std::vector<ConfigMode>& configModes) {
             if (streamIds.size() != mActiveStreamCount) {
                 LOG1("%s, the pipe count(%zu) changed, need to re-init CCA", __func__,
                      streamIds.size());
-                mActiveStreamCount = streamIds.size();
+                *activeStreamCount = streamIds.size();
                 reinit = true;
             }
         }
@@ -190,6 +192,24 @@ void AiqUnit::resetIntelCcaHandle(const std::vector<ConfigMode>& configModes) {
         }
     }
 
+    return reinit;
+}
+
+bool AiqUnit::willReinitIntelCca(const stream_config_t* streamList) {
+    CheckAndLogError(streamList == nullptr, false, "streamList is nullptr");
+
+    AutoMutex l(mAiqUnitLock);
+    if (!mCcaInitialized) return false;
+
+    std::vector<ConfigMode> configModes;
+    PlatformData::getConfigModesByOperationMode(mCameraId, streamList->operation_mode, configModes);
+    size_t activeStreamCount = 0;
+    return isIntelCcaReinitNeeded(configModes, &activeStreamCount);
+}
+
+void AiqUnit::resetIntelCcaHandle(const std::vector<ConfigMode>& configModes) {
+    bool reinit = isIntelCcaReinitNeeded(configModes, &mActiveStreamCount);
+
     if (reinit) deinitIntelCcaHandle();
 }
 
@@ -76,6 +76,8 @@ class AiqUnitBase {
 
     virtual int setParameters(const Parameters& /*params*/) { return OK; }
 
+    virtual bool willReinitIntelCca(const stream_config_t* /*streamList*/) { return false; }
+
  private:
     DISALLOW_COPY_AND_ASSIGN(AiqUnitBase);
 };
@@ -154,10 +156,18 @@ class AiqUnit : public AiqUnitBase {
      */
     int setParameters(const Parameters& params);
 
+    /**
+     * \brief Check if configure() with the stream configuration releases the current
+     * IntelCca instances and creates new ones, the graph config must be configured already.
+     */
+    bool willReinitIntelCca(const stream_config_t* streamList);
+
  private:
     DISALLOW_COPY_AND_ASSIGN(AiqUnit);
 
  private:
+    bool isIntelCcaReinitNeeded(const std::vector<ConfigMode>& configModes,
+                                size_t* activeStreamCount);
     void resetIntelCcaHandle(const std::vector<ConfigMode>& configModes);
     int initIntelCcaHandle(const std::vector<ConfigMode>& configModes);
     void deinitIntelCcaHandle();
@@ -58,19 +58,13 @@ void LensManager::handleSofEvent(EventData eventData) {
     if (eventData.type == EVENT_ISYS_SOF) {
         mLastSofSequence = eventData.data.sync.sequence;
 
-        if (mSeqToPositionMap.find(mLastSofSequence) != mSeqToPositionMap.end()) {
-            setFocusPosition(static_cast<int>(mSeqToPositionMap[mLastSofSequence]));
-            mSeqToPositionMap.erase(mLastSofSequence);
+        const int* position = mSeqToPositionMap.find(mLastSofSequence);
+        if (position) {
+            setFocusPosition(*position);
         }
 
         // remove previous focus result for just SOF missing
-        for (auto it = mSeqToPositionMap.begin(); it != mSeqToPositionMap.end(); it++) {
-            if (it->second <= mLastSofSequence) {
-                mSeqToPositionMap.erase(it->second);
-            } else {
-                break;
-            }
-        }
+        mSeqToPositionMap.eraseUntil(mLastSofSequence);
     }
 }
 
@@ -89,7 +83,7 @@ int LensManager::setLensResult(const cca::cca_af_results& afResults, int64_t seq
         case LENS_VCM_HW:
             if (aiqParam.afMode == AF_MODE_OFF && aiqParam.focusDistance > 0.0f) {
                 // The manual focus setting requires perframe control
-                mSeqToPositionMap[sequence] = afResults.next_lens_position;
+                mSeqToPositionMap.insert(sequence, afResults.next_lens_position);
             } else {
                 // Ignore auto focus result if there is manual settings before.
                 if (!mSeqToPositionMap.empty()) return OK;
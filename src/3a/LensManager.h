@@ -23,6 +23,7 @@
 #include "LensHw.h"
 #include "AiqSetting.h"
 #include "CameraEventType.h"
+#include "iutils/SequenceRing.h"
 
 namespace icamera {
 
@@ -82,8 +83,9 @@ class LensManager {
 
     // Guard for LensManager public API.
     Mutex mLock;
-    // first: sequence id, second: focus position
-    std::map<int64_t, int> mSeqToPositionMap;
+    static const int kFocusPositionQueueSize = 16;
+    // key: sequence id, value: focus position
+    SequenceRing<int, kFocusPositionQueueSize> mSeqToPositionMap;
     int64_t mLastSofSequence;
 };
 
@@ -167,23 +167,28 @@ int SensorManager::setAWB(float r_per_g, float b_per_g) {
 // HDR_FEATURE_E
 
 void SensorManager::handleSensorExposure() {
-    if (mExposureDataMap.find(mLastSofSequence) != mExposureDataMap.end()) {
-        const ExposureData& exposureData = mExposureDataMap[mLastSofSequence];
-        mSensorHwCtrl->setFrameDuration(exposureData.lineLengthPixels,
-                                        exposureData.frameLengthLines);
-        mSensorHwCtrl->setExposure(exposureData.coarseExposures, exposureData.fineExposures);
+    // Write the controls of this SOF together, to apply them as early as possible.
+    mSensorHwCtrl->beginControls();
+    const ExposureData* exposureData = mExposureDataMap.find(mLastSofSequence);
+    if (exposureData) {
+        mSensorHwCtrl->setFrameDuration(exposureData->lineLengthPixels,
+                                        exposureData->frameLengthLines);
+        mSensorHwCtrl->setExposure(exposureData->coarseExposures, exposureData->fineExposures);
         mExposureDataMap.erase(mLastSofSequence);
     }
 
-    if (mAnalogGainMap.find(mLastSofSequence) != mAnalogGainMap.end()) {
-        mSensorHwCtrl->setAnalogGains(mAnalogGainMap[mLastSofSequence]);
+    const std::vector<int>* analogGains = mAnalogGainMap.find(mLastSofSequence);
+    if (analogGains) {
+        mSensorHwCtrl->setAnalogGains(*analogGains);
         mAnalogGainMap.erase(mLastSofSequence);
     }
 
-    if (mDigitalGainMap.find(mLastSofSequence) != mDigitalGainMap.end()) {
-        mSensorHwCtrl->setDigitalGains(mDigitalGainMap[mLastSofSequence]);
+    const std::vector<int>* digitalGains = mDigitalGainMap.find(mLastSofSequence);
+    if (digitalGains) {
+        mSensorHwCtrl->setDigitalGains(*digitalGains);
         mDigitalGainMap.erase(mLastSofSequence);
     }
+    mSensorHwCtrl->commitControls();
 }
 
 int SensorManager::getCurrentExposureAppliedDelay() {
@@ -226,6 +231,7 @@ uint32_t SensorManager::updateSensorExposure(SensorExpGroup sensorExposures, int
         digitalGains.push_back(digitalGain);
     }
 
+    mSensorHwCtrl->beginControls();
     if (effectSeq > 0) {
         int sensorSeq = mLastSofSequence + mExposureDataMap.size() + 1;
         if (applyingSeq > 0 && applyingSeq == mLastSofSequence) {
@@ -234,18 +240,18 @@ uint32_t SensorManager::updateSensorExposure(SensorExpGroup sensorExposures, int
                                             exposureData.frameLengthLines);
             mSensorHwCtrl->setExposure(exposureData.coarseExposures, exposureData.fineExposures);
         } else {
-            mExposureDataMap[sensorSeq] = exposureData;
+            mExposureDataMap.insert(sensorSeq, exposureData);
         }
 
         if ((sensorSeq + mAnalogGainDelay) == mLastSofSequence) {
             mSensorHwCtrl->setAnalogGains(analogGains);
         } else {
-            mAnalogGainMap[sensorSeq + mAnalogGainDelay] = analogGains;
+            mAnalogGainMap.insert(sensorSeq + mAnalogGainDelay, analogGains);
         }
         if ((sensorSeq + mDigitalGainDelay) == mLastSofSequence) {
             mSensorHwCtrl->setDigitalGains(digitalGains);
         } else {
-            mDigitalGainMap[sensorSeq + mDigitalGainDelay] = digitalGains;
+            mDigitalGainMap.insert(sensorSeq + mDigitalGainDelay, digitalGains);
         }
         effectSeq += mExposureDataMap.size();
     } else if (PlatformData::isIsysEnabled(mCameraId)) {
@@ -255,6 +261,7 @@ uint32_t SensorManager::updateSensorExposure(SensorExpGroup sensorExposures, int
         mSensorHwCtrl->setAnalogGains(analogGains);
         mSensorHwCtrl->setDigitalGains(digitalGains);
     }
+    mSensorHwCtrl->commitControls();
 
     if (effectSeq == 0) {
         effectSeq = PlatformData::getInitialSkipFrame(mCameraId);
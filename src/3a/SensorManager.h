@@ -20,6 +20,7 @@
 
 #include "ia_aiq.h"
 
+#include "iutils/SequenceRing.h"
 #include "iutils/Thread.h"
 #include "CameraEventType.h"
 #include "SensorHwCtrl.h"
@@ -105,18 +106,20 @@ class SensorManager {
 
     int mAnalogGainDelay;   // Analog gain delay comparing exposure
     int mDigitalGainDelay;  // Digital gain delay comparing exposure
-    // fisrt: sequence id, second: analog gain vector
-    std::map<int64_t, std::vector<int>> mAnalogGainMap;
-    // fisrt: sequence id, second: digital gain vector
-    std::map<int64_t, std::vector<int>> mDigitalGainMap;
+    // The pending sensor settings, far more than the sensor exposure lag.
+    static const int kSensorSettingQueueSize = 16;
+    // key: sequence id, value: analog gain vector
+    SequenceRing<std::vector<int>, kSensorSettingQueueSize> mAnalogGainMap;
+    // key: sequence id, value: digital gain vector
+    SequenceRing<std::vector<int>, kSensorSettingQueueSize> mDigitalGainMap;
     typedef struct {
         std::vector<int> coarseExposures;
         std::vector<int> fineExposures;
         int lineLengthPixels;
         int frameLengthLines;
     } ExposureData;
-    // first: sequence id, second: exposure data
-    std::map<int64_t, ExposureData> mExposureDataMap;
+    // key: sequence id, value: exposure data
+    SequenceRing<ExposureData, kSensorSettingQueueSize> mExposureDataMap;
 
     std::vector<SofEventInfo> mSofEventInfo;
 };
@@ -18,6 +18,9 @@
 
 #include "BufferQueue.h"
 
+#include <tuple>
+#include <utility>
+
 #include "PlatformData.h"
 #include "iutils/CameraLog.h"
 
@@ -29,6 +32,8 @@ BufferProducer::BufferProducer(int memType) : mMemType(memType) {
 
 BufferQueue::BufferQueue()
         : mBufferProducer(nullptr),
+          mInputWaiters(0),
+          mOutputWaiters(0),
           mProcessThread(nullptr),
           mThreadRunning(false) {
     LOG1("@%s BufferQueue %p created", __func__, this);
@@ -38,25 +43,48 @@ BufferQueue::~BufferQueue() {}
 
 int BufferQueue::queueInputBuffer(Port port, const std::shared_ptr<CameraBuffer>& camBuffer) {
     // If it's not in mInputQueue, then it's not for this processor.
-    if (mInputQueue.find(port) == mInputQueue.end()) {
+    auto input = mInputQueue.find(port);
+    if (input == mInputQueue.end()) {
         return OK;
     }
 
     LOG2("%s CameraBuffer %p for port:%d", __func__, camBuffer.get(), port);
 
-    CameraBufQ& input = mInputQueue[port];
-    bool needSignal = input.empty();
-    input.push(camBuffer);
-    if (needSignal) {
-        mFrameAvailableSignal.signal();
+    return queueBuffer(&input->second, &mInputWaiters, &mFrameAvailableSignal, camBuffer);
+}
+
+int BufferQueue::queueBuffer(CameraBufRing* ring, std::atomic<int>* waiters, Condition* signal,
+                             const std::shared_ptr<CameraBuffer>& camBuffer) {
+    ring->push(camBuffer);
+
+    // Pairs with the fence in waitBufferSignal(): either the consumer sees the new buffer,
+    // or the producer sees the waiter and wakes it up under the lock.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters->load() > 0) {
+        AutoMutex l(mBufferQueueLock);
+        signal->signal();
     }
 
     return OK;
 }
 
-int BufferQueue::onFrameAvailable(Port port, const std::shared_ptr<CameraBuffer>& camBuffer) {
-    AutoMutex l(mBufferQueueLock);
+int BufferQueue::waitBufferSignal(ConditionLock& lock, CameraBufRing* ring,
+                                  std::atomic<int>* waiters, Condition* signal,
+                                  int64_t timeout) {
+    waiters->fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int ret = OK;
+    // Check it again after announcing the waiter, buffers are pushed without the lock.
+    if (ring->empty()) {
+        ret = signal->waitRelative(lock, timeout);
+    }
+    waiters->fetch_sub(1);
 
+    return ret;
+}
+
+int BufferQueue::onFrameAvailable(Port port, const std::shared_ptr<CameraBuffer>& camBuffer) {
     return queueInputBuffer(port, camBuffer);
 }
 
@@ -105,44 +133,45 @@ int BufferQueue::qbuf(Port port, const std::shared_ptr<CameraBuffer>& camBuffer)
     LOG2("%s CameraBuffer %p for port:%d", __func__, camBuffer.get(), port);
 
     // Enqueue buffer to internal pool
-    AutoMutex l(mBufferQueueLock);
     if (camBuffer != nullptr && camBuffer->getStreamType() == CAMERA_STREAM_INPUT) {
         return queueInputBuffer(port, camBuffer);
     }
 
-    CheckAndLogError(mOutputQueue.find(port) == mOutputQueue.end(), BAD_VALUE,
-                     "Not supported port:%d", port);
+    auto output = mOutputQueue.find(port);
+    CheckAndLogError(output == mOutputQueue.end(), BAD_VALUE, "Not supported port:%d", port);
 
-    CameraBufQ& output = mOutputQueue[port];
-    bool needSignal = output.empty();
-    output.push(camBuffer);
-    if (needSignal) {
-        mOutputAvailableSignal.signal();
-    }
+    return queueBuffer(&output->second, &mOutputWaiters, &mOutputAvailableSignal, camBuffer);
+}
 
-    return OK;
+void BufferQueue::resetBufferQueue(std::map<Port, CameraBufRing>* queue,
+                                   const std::map<Port, stream_t>& frameInfo) {
+    queue->clear();
+    for (const auto& item : frameInfo) {
+        queue->emplace(std::piecewise_construct, std::forward_as_tuple(item.first),
+                       std::forward_as_tuple());
+    }
 }
 
 void BufferQueue::clearBufferQueues() {
     AutoMutex l(mBufferQueueLock);
 
-    mInputQueue.clear();
-    for (const auto& input : mInputFrameInfo) {
-        mInputQueue[input.first] = CameraBufQ();
+    for (auto& input : mInputQueue) {
+        input.second.clear();
     }
-
-    mOutputQueue.clear();
-    for (const auto& output : mOutputFrameInfo) {
-        mOutputQueue[output.first] = CameraBufQ();
+    for (auto& output : mOutputQueue) {
+        output.second.clear();
     }
 }
 
 void BufferQueue::setFrameInfo(const std::map<Port, stream_t>& inputInfo,
                                const std::map<Port, stream_t>& outputInfo) {
+    AutoMutex l(mBufferQueueLock);
     mInputFrameInfo = inputInfo;
     mOutputFrameInfo = outputInfo;
 
-    clearBufferQueues();
+    // It's called when configuring the streams, no producer is running
+    resetBufferQueue(&mInputQueue, mInputFrameInfo);
+    resetBufferQueue(&mOutputQueue, mOutputFrameInfo);
 }
 
 void BufferQueue::getFrameInfo(std::map<Port, stream_t>& inputInfo,
@@ -151,7 +180,7 @@ void BufferQueue::getFrameInfo(std::map<Port, stream_t>& inputInfo,
     outputInfo = mOutputFrameInfo;
 }
 
-bool BufferQueue::waitBufferQueue(ConditionLock& lock, std::map<Port, CameraBufQ>& queue,
+bool BufferQueue::waitBufferQueue(ConditionLock& lock, std::map<Port, CameraBufRing>& queue,
                                   int64_t timeout) {
     LOG2("@%s waiting buffers", __func__);
     for (auto& bufQ : queue) {
@@ -161,7 +190,8 @@ bool BufferQueue::waitBufferQueue(ConditionLock& lock, std::map<Port, CameraBufQ
                 LOG1("@%s: inactive while waiting for buffers", __func__);
                 return false;
             }
-            mFrameAvailableSignal.waitRelative(lock, timeout * SLOWLY_MULTIPLIER);
+            waitBufferSignal(lock, &bufQ.second, &mInputWaiters, &mFrameAvailableSignal,
+                             timeout * SLOWLY_MULTIPLIER);
         }
         if (bufQ.second.empty()) return false;
     }
@@ -184,10 +214,11 @@ int BufferQueue::waitFreeBuffersInQueue(ConditionLock& lock,
     LOG2("@%s start waiting the input and output buffers", __func__);
     for (auto& input : mInputQueue) {
         Port port = input.first;
-        CameraBufQ& inputQueue = input.second;
+        CameraBufRing& inputQueue = input.second;
         while (inputQueue.empty()) {
             LOG2("%s: wait input port %d", __func__, port);
-            ret = mFrameAvailableSignal.waitRelative(lock, timeout);
+            ret = waitBufferSignal(lock, &inputQueue, &mInputWaiters, &mFrameAvailableSignal,
+                                   timeout);
 
             // Thread was stopped during wait
             if (!mThreadRunning) {
@@ -205,10 +236,11 @@ int BufferQueue::waitFreeBuffersInQueue(ConditionLock& lock,
 
     for (auto& output : mOutputQueue) {
         Port port = output.first;
-        CameraBufQ& outputQueue = output.second;
+        CameraBufRing& outputQueue = output.second;
         while (outputQueue.empty()) {
             LOG2("%s: wait output port %d", __func__, port);
-            ret = mOutputAvailableSignal.waitRelative(lock, timeout);
+            ret = waitBufferSignal(lock, &outputQueue, &mOutputWaiters, &mOutputAvailableSignal,
+                                   timeout);
 
             // Thread was stopped during wait
             if (!mThreadRunning) {
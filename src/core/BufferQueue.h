@@ -16,11 +16,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <vector>
 
 #include "CameraBuffer.h"
 #include "CameraEvent.h"
+#include "iutils/BufferRing.h"
 #include "iutils/Errors.h"
 #include "iutils/Thread.h"
 
@@ -31,6 +33,8 @@ namespace icamera {
 
 class BufferProducer;
 
+typedef BufferRing<std::shared_ptr<CameraBuffer> > CameraBufRing;
+
 /**
  * BufferConsumer listens on the onFrameAvailable event from the producer by
  * calling setBufferProducer
@@ -70,7 +74,8 @@ class BufferQueue : public BufferConsumer, public BufferProducer, public EventLi
     /**
      * \brief the notify when poll one frame buffer
      *
-     * Push the CameraBuffer to InputQueue and send a signal if needed
+     * Push the CameraBuffer to InputQueue and send a signal if needed.
+     * It doesn't take mBufferQueueLock unless the consumer is waiting.
      */
     virtual int onFrameAvailable(Port port, const std::shared_ptr<CameraBuffer>& camBuffer);
 
@@ -146,7 +151,9 @@ class BufferQueue : public BufferConsumer, public BufferProducer, public EventLi
     virtual int processNewFrame() = 0;
 
     /**
-     * \brief Clear and initialize input and output buffer queues.
+     * \brief Drop the buffers in the input and output buffer queues.
+     *
+     * The queues of the ports are kept, producers may still push to them.
      */
     void clearBufferQueues();
     /**
@@ -154,7 +161,8 @@ class BufferQueue : public BufferConsumer, public BufferProducer, public EventLi
      *
      * No waiting if timeout value is zero
      */
-    bool waitBufferQueue(ConditionLock& lock, std::map<Port, CameraBufQ>& queue, int64_t timeout);
+    bool waitBufferQueue(ConditionLock& lock, std::map<Port, CameraBufRing>& queue,
+                         int64_t timeout);
     /**
      * \brief Wait for available input and output buffers.
      *
@@ -196,8 +204,13 @@ class BufferQueue : public BufferConsumer, public BufferProducer, public EventLi
     std::map<Port, stream_t> mInputFrameInfo;
     std::map<Port, stream_t> mOutputFrameInfo;
 
-    std::map<Port, CameraBufQ> mInputQueue;
-    std::map<Port, CameraBufQ> mOutputQueue;
+    /*
+     * The port maps are only built in setFrameInfo() when there is no producer, the other
+     * places only reset the rings in place. Pushing to the rings is lock-free,
+     * front()/pop()/clear() MUST be protected by mBufferQueueLock.
+     */
+    std::map<Port, CameraBufRing> mInputQueue;
+    std::map<Port, CameraBufRing> mOutputQueue;
 
     // For internal buffers allocation for producer
     std::map<Port, CameraBufVector> mInternalBuffers;
@@ -206,6 +219,9 @@ class BufferQueue : public BufferConsumer, public BufferProducer, public EventLi
     Mutex mBufferQueueLock;
     Condition mFrameAvailableSignal;
     Condition mOutputAvailableSignal;
+    // Number of consumers waiting on the signals, producers only lock to wake them up
+    std::atomic<int> mInputWaiters;
+    std::atomic<int> mOutputWaiters;
 
     // for the thread loop
     ProcessThread* mProcessThread;
@@ -213,6 +229,12 @@ class BufferQueue : public BufferConsumer, public BufferProducer, public EventLi
 
  private:
     int queueInputBuffer(Port port, const std::shared_ptr<CameraBuffer>& camBuffer);
+    int queueBuffer(CameraBufRing* ring, std::atomic<int>* waiters, Condition* signal,
+                    const std::shared_ptr<CameraBuffer>& camBuffer);
+    int waitBufferSignal(ConditionLock& lock, CameraBufRing* ring, std::atomic<int>* waiters,
+                         Condition* signal, int64_t timeout);
+    void resetBufferQueue(std::map<Port, CameraBufRing>* queue,
+                          const std::map<Port, stream_t>& frameInfo);
 };
 
 }  // namespace icamera
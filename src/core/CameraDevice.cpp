@@ -419,7 +419,7 @@ int CameraDevice::configure(stream_config_t* streamList) {
     CheckAndLogError(ret != OK, ret, "@%s, analyzeStream failed", __func__);
 
     deleteStreams();
-    mProcessorManager->deleteProcessors();
+    mProcessorManager->deleteProcessors(true);
     // Clear all previous added listeners.
     mProducer->removeAllFrameAvailableListener();
 
@@ -472,11 +472,14 @@ int CameraDevice::configure(stream_config_t* streamList) {
     ret = mSofSource->configure();
     CheckAndLogError(ret != OK, ret, "@%s failed to configure SOF source device", __func__);
 
+    // The cached Psys pipelines use the IntelCca instances which are released by re-init
+    if (m3AControl->willReinitIntelCca(streamList)) mProcessorManager->releaseCachedPipelines();
     m3AControl->configure(streamList);
 
     if (needProcessor) {
         mProcessors = mProcessorManager->createProcessors(producerConfigs, mStreamIdToPortMap,
-                                                          streamList, mParamGenerator);
+                                                          streamList, configModes,
+                                                          mParamGenerator);
         ret = mProcessorManager->configureProcessors(configModes, mProducer, mParameter);
         CheckAndLogError(ret != OK, ret, "@%s configure post processor failed with:%d", __func__,
                          ret);
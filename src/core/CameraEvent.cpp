@@ -18,6 +18,8 @@
 
 #include "CameraEvent.h"
 
+#include <algorithm>
+
 #include "iutils/CameraLog.h"
 
 namespace icamera {
@@ -30,43 +32,76 @@ void EventSource::registerListener(EventType eventType, EventListener* eventList
 
     AutoMutex l(mListenersLock);
 
-    std::set<EventListener*> listenersOfType;
-    if (mListeners.find(eventType) != mListeners.end()) {
-        listenersOfType = mListeners[eventType];
+    std::shared_ptr<ListenerMap> listeners =
+        std::make_shared<ListenerMap>(*std::atomic_load(&mListeners));
+
+    std::vector<EventListener*>& listenersOfType = (*listeners)[eventType];
+    if (std::find(listenersOfType.begin(), listenersOfType.end(), eventListener) !=
+        listenersOfType.end()) {
+        return;
     }
 
-    listenersOfType.insert(eventListener);
-    mListeners[eventType] = listenersOfType;
+    listenersOfType.push_back(eventListener);
+    std::atomic_store(&mListeners, std::shared_ptr<const ListenerMap>(listeners));
 }
 
 void EventSource::removeListener(EventType eventType, EventListener* eventListener) {
     LOG1("@%s eventType: %d, listener: %p", __func__, eventType, eventListener);
     AutoMutex l(mListenersLock);
 
-    if (mListeners.find(eventType) == mListeners.end()) {
+    std::shared_ptr<const ListenerMap> oldListeners = std::atomic_load(&mListeners);
+    if (oldListeners->find(eventType) == oldListeners->end()) {
         LOG1("%s: no listener found for event type %d", __func__, eventType);
         return;
     }
 
-    std::set<EventListener*> listenersOfType = mListeners[eventType];
-    listenersOfType.erase(eventListener);
-    mListeners[eventType] = listenersOfType;
+    std::shared_ptr<ListenerMap> listeners = std::make_shared<ListenerMap>(*oldListeners);
+    std::vector<EventListener*>& listenersOfType = (*listeners)[eventType];
+    listenersOfType.erase(
+        std::remove(listenersOfType.begin(), listenersOfType.end(), eventListener),
+        listenersOfType.end());
+    if (listenersOfType.empty()) listeners->erase(eventType);
+
+    std::atomic_store(&mListeners, std::shared_ptr<const ListenerMap>(listeners));
+
+    /*
+     * The listener may be released after return, wait for the dispatches started before it's
+     * removed, the later ones have loaded the new listeners.
+     */
+    ConditionLock lock(mDispatchLock);
+    uint64_t removedSeq = mNextDispatchSeq;
+    while (!mActiveDispatches.empty() && *mActiveDispatches.begin() < removedSeq) {
+        mDispatchDoneSignal.wait(lock);
+    }
 }
 
 void EventSource::notifyListeners(EventData eventData) {
     LOG2("@%s eventType: %d", __func__, eventData.type);
-    AutoMutex l(mListenersLock);
+    // Take the sequence before loading the listeners, see removeListener().
+    uint64_t seq = 0;
+    {
+        AutoMutex l(mDispatchLock);
+        seq = mNextDispatchSeq++;
+        mActiveDispatches.insert(seq);
+    }
+    std::shared_ptr<const ListenerMap> listeners = std::atomic_load(&mListeners);
 
-    if (mListeners.find(eventData.type) == mListeners.end()) {
+    auto listenersOfType = listeners->find(eventData.type);
+    if (listenersOfType == listeners->end()) {
         LOG2("%s: no listener found for event type %d", __func__, eventData.type);
-        return;
+    } else {
+        for (auto listener : listenersOfType->second) {
+            LOG2("%s: send event data to listener %p for event type %d", __func__, listener,
+                 eventData.type);
+            listener->handleEvent(eventData);
+        }
     }
 
-    for (auto listener : mListeners[eventData.type]) {
-        LOG2("%s: send event data to listener %p for event type %d", __func__, listener,
-             eventData.type);
-        listener->handleEvent(eventData);
-    }
+    AutoMutex l(mDispatchLock);
+    bool oldest = (*mActiveDispatches.begin() == seq);
+    mActiveDispatches.erase(seq);
+    // Only the oldest dispatch done may release the waiters in removeListener().
+    if (oldest) mDispatchDoneSignal.broadcast();
 }
 
 }  // namespace icamera
@@ -16,8 +16,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <set>
+#include <vector>
 
 #include "CameraEventType.h"
 #include "iutils/Thread.h"
@@ -33,13 +36,31 @@ class EventListener {
 
 class EventSource {
  private:
-    std::map<EventType, std::set<EventListener*>> mListeners;
+    typedef std::map<EventType, std::vector<EventListener*>> ListenerMap;
 
-    // Guard for EventSource public API to protect mListeners.
+    /*
+     * Immutable snapshot of the listeners, it is replaced as a whole when the listeners
+     * change, so notifyListeners() dispatches the events without any lock.
+     * Access it with std::atomic_load/std::atomic_store only.
+     */
+    std::shared_ptr<const ListenerMap> mListeners;
+
+    // Serialize the updates of mListeners.
     Mutex mListenersLock;
 
+    /*
+     * The sequences of the notifyListeners() in progress. removeListener() waits only for
+     * the ones started before the listener is removed, so that the removed listener isn't
+     * called after it returns, while the new dispatches don't hold it back.
+     * Guarded by mDispatchLock.
+     */
+    uint64_t mNextDispatchSeq;
+    std::set<uint64_t> mActiveDispatches;
+    Mutex mDispatchLock;
+    Condition mDispatchDoneSignal;
+
  public:
-    EventSource() {}
+    EventSource() : mListeners(std::make_shared<ListenerMap>()), mNextDispatchSeq(0) {}
     virtual ~EventSource() {}
     virtual void registerListener(EventType eventType, EventListener* eventListener);
     virtual void removeListener(EventType eventType, EventListener* eventListener);
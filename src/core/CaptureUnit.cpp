@@ -20,6 +20,7 @@
 
 #include <fcntl.h>
 #include <poll.h>
+#include <sys/epoll.h>
 
 #include "MediaControl.h"
 #include "PlatformData.h"
@@ -32,8 +33,21 @@ using std::vector;
 
 namespace icamera {
 
+// Normally set the timeout threshold to 1s
+static int getPollTimeout() {
+    return gSlowlyRunRatio ? (gSlowlyRunRatio * 100000) : 1000;
+}
+
+static int getPollTimeoutCount() {
+    const int poll_timeout_count = 10;
+    return (PlatformData::getMaxIsysTimeout() > 0) ? PlatformData::getMaxIsysTimeout() :
+                                                     poll_timeout_count;
+}
+
 CaptureUnit::CaptureUnit(int cameraId, int memType)
         : StreamSource(memType),
+          mReactorHandler(this),
+          mUseEventReactor(false),
           mCameraId(cameraId),
           mMaxBufferNum(PlatformData::getMaxRawDataNum(cameraId)),
           mState(CAPTURE_UNINIT),
@@ -193,15 +207,32 @@ int CaptureUnit::start() {
         return ret;
     }
 
-    if (mFlushFd[0] != -1) {
-        // read pipe just in case there is data in pipe.
-        char readBuf;
-        int readSize = read(mFlushFd[0], reinterpret_cast<void*>(&readBuf), sizeof(char));
-        LOG1("%s, readSize %d", __func__, readSize);
+    mExitPending = false;
+    mUseEventReactor = PlatformData::isIsysEventReactorEnabled(mCameraId);
+    if (mUseEventReactor) {
+        std::vector<V4L2Device*> devices;
+        for (const auto& device : mDevices) {
+            devices.push_back(device->getV4l2Device());
+        }
+        ret = V4l2EventReactor::getInstance()->addHandler(&mReactorHandler, devices,
+                                                          getPollTimeout() * getPollTimeoutCount());
+        if (ret != OK) {
+            LOGW("<id%d>%s, failed to use the event reactor, use poll thread", mCameraId,
+                 __func__);
+            mUseEventReactor = false;
+        }
+    }
+
+    if (!mUseEventReactor) {
+        if (mFlushFd[0] != -1) {
+            // read pipe just in case there is data in pipe.
+            char readBuf;
+            int readSize = read(mFlushFd[0], reinterpret_cast<void*>(&readBuf), sizeof(char));
+            LOG1("%s, readSize %d", __func__, readSize);
+        }
+        mPollThread->run("CaptureUnit", PRIORITY_URGENT_AUDIO);
     }
-    mPollThread->run("CaptureUnit", PRIORITY_URGENT_AUDIO);
     mState = CAPTURE_START;
-    mExitPending = false;
     LOG2("@%s: automation checkpoint: flag: poll_started", __func__);
 
     return OK;
@@ -222,15 +253,21 @@ int CaptureUnit::stop() {
     CheckWarning(mState != CAPTURE_START, OK, "@%s: device not started", __func__);
 
     mExitPending = true;
-    if (mFlushFd[1] != -1) {
-        char buf = 0xf;  // random value to write to flush fd.
-        int size = write(mFlushFd[1], &buf, sizeof(char));
-        LOG1("%s, write size %d", __func__, size);
-    }
+    if (mUseEventReactor) {
+        streamOff();
+        // Wait for the running dequeue before resetting the buffers
+        V4l2EventReactor::getInstance()->removeHandler(&mReactorHandler);
+    } else {
+        if (mFlushFd[1] != -1) {
+            char buf = 0xf;  // random value to write to flush fd.
+            int size = write(mFlushFd[1], &buf, sizeof(char));
+            LOG1("%s, write size %d", __func__, size);
+        }
 
-    mPollThread->requestExit();
-    streamOff();
-    mPollThread->requestExitAndWait();
+        mPollThread->requestExit();
+        streamOff();
+        mPollThread->requestExitAndWait();
+    }
 
     AutoMutex l(mLock);
     mState = CAPTURE_STOP;
@@ -378,16 +415,13 @@ int CaptureUnit::processPendingBuffers() {
 int CaptureUnit::poll() {
     PERF_CAMERA_ATRACE();
     int ret = 0;
-    const int poll_timeout_count = 10;
-    // Normally set the timeout threshold to 1s
-    const int poll_timeout = gSlowlyRunRatio ? (gSlowlyRunRatio * 100000) : 1000;
+    const int poll_timeout = getPollTimeout();
 
     LOG2("<id%d>%s", mCameraId, __func__);
     CheckAndLogError((mState != CAPTURE_CONFIGURE && mState != CAPTURE_START), INVALID_OPERATION,
                      "@%s: poll buffer in wrong state %d", __func__, mState);
 
-    int timeOutCount = (PlatformData::getMaxIsysTimeout() > 0) ? PlatformData::getMaxIsysTimeout() :
-                                                                 poll_timeout_count;
+    int timeOutCount = getPollTimeoutCount();
     std::vector<V4L2Device*> pollDevs, readyDevices;
     for (const auto& device : mDevices) {
         pollDevs.push_back(device->getV4l2Device());
@@ -415,40 +449,65 @@ int CaptureUnit::poll() {
     }
     CheckAndLogError(ret < 0, UNKNOWN_ERROR, "%s: Poll error, ret:%d", __func__, ret);
     if (ret == 0) {
-#ifdef HAVE_CHROME_OS
-        LOGI("<id%d>%s, timeout happens, buffer in device: %d. wait recovery", mCameraId, __func__,
-             mDevices.front()->getBufferNumInDevice());
-#else
-        LOG1("<id%d>%s, timeout happens, buffer in device: %d. wait recovery", mCameraId, __func__,
-             mDevices.front()->getBufferNumInDevice());
-#endif
-        if (PlatformData::getMaxIsysTimeout() > 0 && mDevices.front()->getBufferNumInDevice() > 0) {
-            EventData errorData;
-            errorData.type = EVENT_ISYS_ERROR;
-            errorData.buffer = nullptr;
-            notifyListeners(errorData);
-        }
-
+        handlePollTimeout();
         return OK;
     }
 
     for (const auto& readyDevice : readyDevices) {
-        for (auto device : mDevices) {
-            if (device->getV4l2Device() == readyDevice) {
-                int ret = device->dequeueBuffer();
-                if (mExitPending) return -1;
+        if (handleReadyDevice(readyDevice) != OK) return -1;
+    }
 
-                if (ret != OK) {
-                    LOGE("Device:%s grab frame failed:%d", device->getName(), ret);
-                }
-                break;
+    return OK;
+}
+
+int CaptureUnit::handleReadyDevice(V4L2Device* readyDevice) {
+    for (auto device : mDevices) {
+        if (device->getV4l2Device() == readyDevice) {
+            int ret = device->dequeueBuffer();
+            if (mExitPending) return -1;
+
+            if (ret != OK) {
+                LOGE("Device:%s grab frame failed:%d", device->getName(), ret);
             }
+            break;
         }
     }
 
     return OK;
 }
 
+void CaptureUnit::handlePollTimeout() {
+#ifdef HAVE_CHROME_OS
+    LOGI("<id%d>%s, timeout happens, buffer in device: %d. wait recovery", mCameraId, __func__,
+         mDevices.front()->getBufferNumInDevice());
+#else
+    LOG1("<id%d>%s, timeout happens, buffer in device: %d. wait recovery", mCameraId, __func__,
+         mDevices.front()->getBufferNumInDevice());
+#endif
+    if (PlatformData::getMaxIsysTimeout() > 0 && mDevices.front()->getBufferNumInDevice() > 0) {
+        EventData errorData;
+        errorData.type = EVENT_ISYS_ERROR;
+        errorData.buffer = nullptr;
+        notifyListeners(errorData);
+    }
+}
+
+bool CaptureUnit::ReactorHandler::onDeviceReady(V4L2Device* device, uint32_t events) {
+    // In case the device is ready after stream off
+    if (mCaptureU->mExitPending) return false;
+
+    CheckAndLogError(events & EPOLLERR, false, "<id%d>%s: Poll error, events:0x%x",
+                     mCaptureU->mCameraId, __func__, events);
+    return mCaptureU->handleReadyDevice(device) == OK;
+}
+
+bool CaptureUnit::ReactorHandler::onDeviceTimeout() {
+    if (mCaptureU->mExitPending) return false;
+
+    mCaptureU->handlePollTimeout();
+    return true;
+}
+
 void CaptureUnit::addFrameAvailableListener(BufferConsumer* listener) {
     AutoMutex l(mLock);
     for (auto device : mDevices) {
@@ -22,6 +22,7 @@
 #include "CameraBuffer.h"
 #include "DeviceBase.h"
 #include "StreamSource.h"
+#include "V4l2EventReactor.h"
 #include "iutils/Thread.h"
 
 namespace icamera {
@@ -140,6 +141,8 @@ class CaptureUnit : public StreamSource, public DeviceCallback {
     int streamOn();
     void streamOff();
     int poll();
+    int handleReadyDevice(V4L2Device* readyDevice);
+    void handlePollTimeout();
 
     int processPendingBuffers();
     int queueAllBuffers();
@@ -160,6 +163,22 @@ class CaptureUnit : public StreamSource, public DeviceCallback {
     PollThread* mPollThread;
     int mFlushFd[2];  // Flush file descriptor
 
+    /**
+     * \brief Dequeue the frame buffers in the shared event reactor instead of mPollThread
+     */
+    class ReactorHandler : public V4l2EventReactor::Handler {
+        CaptureUnit* mCaptureU;
+
+     public:
+        explicit ReactorHandler(CaptureUnit* hw) : mCaptureU(hw) {}
+
+        virtual bool onDeviceReady(V4L2Device* device, uint32_t events);
+        virtual bool onDeviceTimeout();
+    };
+
+    ReactorHandler mReactorHandler;
+    bool mUseEventReactor;
+
     // Guard for mCaptureUnit public API except dqbuf and qbuf
     Mutex mLock;
 
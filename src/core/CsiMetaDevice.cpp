@@ -19,6 +19,7 @@
 #include "CsiMetaDevice.h"
 
 #include <poll.h>
+#include <sys/epoll.h>
 
 #include "PlatformData.h"
 #include "iutils/CameraDump.h"
@@ -33,7 +34,9 @@ using std::vector;
 namespace icamera {
 
 CsiMetaDevice::CsiMetaDevice(int cameraId)
-        : mCameraId(cameraId),
+        : mReactorHandler(this),
+          mUseEventReactor(false),
+          mCameraId(cameraId),
           mCsiMetaDevice(nullptr),
           mIsCsiMetaEnabled(false),
           mCsiMetaBufferDQIndex(0),
@@ -197,7 +200,19 @@ int CsiMetaDevice::start() {
     CheckAndLogError(ret < 0, ret, "failed to stream on csi meta device, ret = %d", ret);
 
     mExitPending = false;
-    mPollThread->run("CsiMetaDevice", PRIORITY_URGENT_AUDIO);
+    mUseEventReactor = PlatformData::isIsysEventReactorEnabled(mCameraId);
+    if (mUseEventReactor) {
+        std::vector<V4L2Device*> devices(mConfiguredDevices.begin(), mConfiguredDevices.end());
+        // The poll thread doesn't report the timeout either
+        ret = V4l2EventReactor::getInstance()->addHandler(&mReactorHandler, devices, 0);
+        if (ret != OK) {
+            LOGW("%s: failed to use the event reactor, use poll thread", __func__);
+            mUseEventReactor = false;
+        }
+    }
+    if (!mUseEventReactor) {
+        mPollThread->run("CsiMetaDevice", PRIORITY_URGENT_AUDIO);
+    }
     mState = CSI_META_DEVICE_START;
 
     return OK;
@@ -213,13 +228,17 @@ int CsiMetaDevice::stop() {
     CheckWarning(mState != CSI_META_DEVICE_START, OK, "%s: device not started", __func__);
 
     mExitPending = true;
-    mPollThread->requestExit();
+    if (!mUseEventReactor) mPollThread->requestExit();
 
     int ret = mCsiMetaDevice->Stop(false);
 
     CheckAndLogError(ret < 0, ret, "failed to stream off csi meta device, ret = %d", ret);
 
-    mPollThread->requestExitAndWait();
+    if (mUseEventReactor) {
+        V4l2EventReactor::getInstance()->removeHandler(&mReactorHandler);
+    } else {
+        mPollThread->requestExitAndWait();
+    }
 
     mState = CSI_META_DEVICE_STOP;
     return OK;
@@ -272,6 +291,16 @@ int CsiMetaDevice::poll() {
     return OK;
 }
 
+bool CsiMetaDevice::ReactorHandler::onDeviceReady(V4L2Device* device, uint32_t events) {
+    if (mCsiMetaDevice->mExitPending) return false;
+
+    CheckAndLogError(events & EPOLLERR, false, "%s: Poll error, events:0x%x", __func__, events);
+    mCsiMetaDevice->handleCsiMetaBuffer();
+    LOG2("@%s after poll number buffer in devices: %d", __func__,
+         mCsiMetaDevice->mBuffersInCsiMetaDevice.load());
+    return true;
+}
+
 int CsiMetaDevice::hasBufferIndevice() {
     return mBuffersInCsiMetaDevice.load();
 }
@@ -27,6 +27,7 @@
 
 #include "CameraBuffer.h"
 #include "CameraEvent.h"
+#include "V4l2EventReactor.h"
 #include "iutils/Errors.h"
 #include "iutils/Thread.h"
 
@@ -99,6 +100,19 @@ class CsiMetaDevice : public EventSource {
     };
 
     PollThread* mPollThread;
+
+    // Dequeue the CSI meta buffers in the shared event reactor instead of mPollThread
+    class ReactorHandler : public V4l2EventReactor::Handler {
+        CsiMetaDevice* mCsiMetaDevice;
+
+     public:
+        explicit ReactorHandler(CsiMetaDevice* csiMetaDevice) : mCsiMetaDevice(csiMetaDevice) {}
+
+        virtual bool onDeviceReady(V4L2Device* device, uint32_t events);
+    };
+    ReactorHandler mReactorHandler;
+    bool mUseEventReactor;
+
     int mCameraId;
     V4L2VideoNode* mCsiMetaDevice;
     std::vector<V4L2VideoNode*> mConfiguredDevices;
@@ -28,6 +28,7 @@
 #include "iutils/CameraLog.h"
 #include "iutils/CameraDump.h"
 #include "iutils/Errors.h"
+#include "iutils/ThreadPool.h"
 #include "PlatformData.h"
 #include "IGraphConfig.h"
 
@@ -42,18 +43,16 @@ IspParamAdaptor::IspParamAdaptor(int cameraId)
           mCameraId(cameraId),
           mTuningMode(TUNING_MODE_VIDEO),
           mIpuOutputFormat(V4L2_PIX_FMT_NV12),
-          mLastLscSequece(-1),
-          mLastGdcSequence(-1),
           mGraphConfig(nullptr),
           mIntelCca(nullptr),
           mGammaTmOffset(-1) {
     LOG1("<id%d>@%s", mCameraId, __func__);
     CLEAR(mLastPalDataForVideoPipe);
 
-    PalRecord palRecordArray[] = {{ia_pal_uuid_isp_call_info, -1},
-                                  {ia_pal_uuid_isp_bnlm_3_2, -1},
-                                  {ia_pal_uuid_isp_lsc_1_1, -1},
-                                  {ia_pal_uuid_isp_gdc5, -1}};
+    PalRecord palRecordArray[] = {{ia_pal_uuid_isp_call_info, -1, PAL_SOURCE_ANY, 0, 0, 0},
+                                  {ia_pal_uuid_isp_bnlm_3_2, -1, PAL_SOURCE_ANY, 0, 0, 0},
+                                  {ia_pal_uuid_isp_lsc_1_1, -1, PAL_SOURCE_LSC, 0, 0, 0},
+                                  {ia_pal_uuid_isp_gdc5, -1, PAL_SOURCE_DVS, 0, 0, 0}};
     for (uint32_t i = 0; i < sizeof(palRecordArray) / sizeof(PalRecord); i++) {
         mPalRecords.push_back(palRecordArray[i]);
     }
@@ -79,10 +78,11 @@ int IspParamAdaptor::deinit() {
         releaseIspParamBuffers();
     }
 
-    CLEAR(mLastPalDataForVideoPipe);
-    for (uint32_t i = 0; i < mPalRecords.size(); i++) {
-        mPalRecords[i].offset = -1;
+    for (const auto& record : mPalRecords) {
+        LOG1("<id%d>%s, PAL record uuid %d: copied %lu, reused %lu", mCameraId, __func__,
+             record.uuid, record.copyCount, record.reuseCount);
     }
+    resetPalRecords();
     mGammaTmOffset = -1;
 
     mIspAdaptorState = ISP_ADAPTOR_NOT_INIT;
@@ -210,12 +210,7 @@ int IspParamAdaptor::configure(const stream_t& stream, ConfigMode configMode, Tu
     if (ipuOutputFormat != -1) mIpuOutputFormat = ipuOutputFormat;
     LOG2("%s, configMode: %x, PSys output format 0x%x", __func__, configMode, mIpuOutputFormat);
     mTuningMode = tuningMode;
-    CLEAR(mLastPalDataForVideoPipe);
-    mLastLscSequece = -1;
-    mLastGdcSequence = -1;
-    for (uint32_t i = 0; i < mPalRecords.size(); i++) {
-        mPalRecords[i].offset = -1;
-    }
+    resetPalRecords();
     mGammaTmOffset = -1;
 
     mIntelCca = IntelCca::getInstance(mCameraId, tuningMode);
@@ -404,15 +399,50 @@ void IspParamAdaptor::updateKernelToggles(cca::cca_program_group* programGroup)
     }
 }
 
+void IspParamAdaptor::resetPalRecords() {
+    CLEAR(mLastPalDataForVideoPipe);
+    for (auto& record : mPalRecords) {
+        record.offset = -1;
+        record.generation = 0;
+        record.copyCount = 0;
+        record.reuseCount = 0;
+    }
+    mPalBufferGenerations.clear();
+}
+
+bool IspParamAdaptor::isPalRecordEnabled(const PalRecord& record) {
+    // GDC is only carried forward when DVS may skip it
+    if (record.source == PAL_SOURCE_DVS) return PlatformData::isDvsSupported(mCameraId);
+
+    return true;
+}
+
+/*
+ * Return true if AIC outputs the record for the sequence for sure, the record which
+ * may be skipped by AIC (PAL_SOURCE_ANY) returns false.
+ */
+bool IspParamAdaptor::isPalRecordUpdated(const PalRecord& record, int64_t settingSeq) {
+    switch (record.source) {
+        case PAL_SOURCE_LSC: {
+            const AiqResult* aiqResults =
+                AiqResultStorage::getInstance(mCameraId)->getAiqResult(settingSeq);
+            return aiqResults && aiqResults->mLscUpdate;
+        }
+        case PAL_SOURCE_DVS:
+            return AiqResultStorage::getInstance(mCameraId)->isDvsRun(settingSeq);
+        default:
+            return false;
+    }
+}
+
 /*
  * PAL output buffer is a reference data for next output buffer,
  * but currently a ring buffer is used in HAL, which caused logic mismatching issue.
- * So temporarily copy latest PAL data into PAL output buffer.
+ * So copy the latest PAL records which AIC may skip into PAL output buffer, unless
+ * the buffer already holds the latest generation of the record.
  */
-void IspParamAdaptor::updatePalDataForVideoPipe(ia_binary_data dest, int64_t bufSeq,
-                                                int64_t settingSeq) {
+void IspParamAdaptor::updatePalDataForVideoPipe(ia_binary_data dest, int64_t settingSeq) {
     if (mLastPalDataForVideoPipe.data == nullptr || mLastPalDataForVideoPipe.size == 0) {
-        mLastGdcSequence = settingSeq;
         return;
     }
 
@@ -439,46 +469,58 @@ void IspParamAdaptor::updatePalDataForVideoPipe(ia_binary_data dest, int64_t buf
         }
     }
 
+    std::vector<uint64_t>& generations = mPalBufferGenerations[dest.data];
+    generations.resize(mPalRecords.size(), 0);
+
     char* destData = static_cast<char*>(dest.data);
-    ia_pal_record_header* headerSrc = nullptr;
     for (uint32_t i = 0; i < mPalRecords.size(); i++) {
-        if (mPalRecords[i].offset >= 0) {
-            // find source record header
-            header = reinterpret_cast<ia_pal_record_header*>(src + mPalRecords[i].offset);
-            if (header->uuid == mPalRecords[i].uuid) {
-                headerSrc = header;
-            }
+        PalRecord& record = mPalRecords[i];
+        if (record.offset < 0 || !isPalRecordEnabled(record)) continue;
 
-            if (ia_pal_uuid_isp_lsc_1_1 == header->uuid) {
-                if (isLscCopy(bufSeq, settingSeq)) {
-                    LOG2("settingSeq %ld, copy LSC for buf %ld", settingSeq, bufSeq);
-                    updateLscSeqMap(bufSeq);
-                } else {
-                    LOG2("settingSeq %ld, not copy LSC for buf %ld", settingSeq, bufSeq);
-                    continue;
-                }
-            }
+        if (isPalRecordUpdated(record, settingSeq)) {
+            LOG2("settingSeq %ld, uuid %d is updated by AIC", settingSeq, record.uuid);
+            continue;
+        }
+        if (generations[i] == record.generation) {
+            record.reuseCount++;
+            LOG2("settingSeq %ld, uuid %d is up to date", settingSeq, record.uuid);
+            continue;
+        }
 
-            if (ia_pal_uuid_isp_gdc5 == header->uuid) {
-                if (isGdcCopy(bufSeq, settingSeq)) {
-                    LOG2("settingSeq %ld, copy GDC for buf %ld", settingSeq, bufSeq);
-                    updateGdcSeqMap(bufSeq);
-                } else {
-                    LOG2("settingSeq %ld, not copy GDC for buf %ld", settingSeq, bufSeq);
-                    continue;
-                }
-            }
+        // find source record header
+        ia_pal_record_header* headerSrc =
+            reinterpret_cast<ia_pal_record_header*>(src + record.offset);
+        if (headerSrc->uuid != record.uuid) {
+            LOGW("Failed to find PAL recorder header %d", record.uuid);
+            continue;
+        }
+        header = reinterpret_cast<ia_pal_record_header*>(destData + record.offset);
+        if (header->uuid == record.uuid) {
+            MEMCPY_S(header, header->size, headerSrc, headerSrc->size);
+            generations[i] = record.generation;
+            record.copyCount++;
+            LOG2("%s, PAL data of kernel uuid %d has been updated", __func__, header->uuid);
+        }
+    }
+}
 
-            if (!headerSrc) {
-                LOGW("Failed to find PAL recorder header %d", mPalRecords[i].uuid);
-                continue;
-            }
-            header = reinterpret_cast<ia_pal_record_header*>(destData + mPalRecords[i].offset);
-            if (header->uuid == mPalRecords[i].uuid) {
-                MEMCPY_S(header, header->size, headerSrc, headerSrc->size);
-                LOG2("%s, PAL data of kernel uuid %d has been updated", __func__, header->uuid);
-            }
+/*
+ * Called after AIC outputs the video PAL data, the records output by AIC get a new
+ * generation, and the buffer holds the latest generation of all records.
+ */
+void IspParamAdaptor::updatePalRecordGeneration(const ia_binary_data& binaryData,
+                                                int64_t settingSeq, bool firstRun) {
+    std::vector<uint64_t>& generations = mPalBufferGenerations[binaryData.data];
+    generations.resize(mPalRecords.size(), 0);
+
+    for (uint32_t i = 0; i < mPalRecords.size(); i++) {
+        PalRecord& record = mPalRecords[i];
+        if (firstRun || record.source == PAL_SOURCE_ANY || isPalRecordUpdated(record, settingSeq)) {
+            record.generation++;
         }
+        generations[i] = record.generation;
+        LOG2("settingSeq %ld, uuid %d generation %lu, copied %lu, reused %lu", settingSeq,
+             record.uuid, record.generation, record.copyCount, record.reuseCount);
     }
 }
 
@@ -497,60 +539,6 @@ void IspParamAdaptor::updateIspParameterMap(IspParameter* ispParam, int64_t data
     ispParam->mSequenceToDataId[settingSeq] = dataSeq;
 }
 
-bool IspParamAdaptor::isLscCopy(int64_t bufSeq, int64_t settingSeq) {
-    AiqResult* aiqResults = const_cast<AiqResult*>(
-        AiqResultStorage::getInstance(mCameraId)->getAiqResult(settingSeq));
-    if (aiqResults == nullptr) return true;
-
-    if (aiqResults->mLscUpdate) {
-        mLastLscSequece = settingSeq;
-        LOG2("%s, LSC update %ld", __func__, settingSeq);
-        return false;
-    } else {
-        if (mSeqIdToLscSeqIdMap.find(bufSeq) != mSeqIdToLscSeqIdMap.end()) {
-            if (mLastLscSequece >= 0 && mSeqIdToLscSeqIdMap[bufSeq] == mLastLscSequece) {
-                return false;
-            }
-        }
-    }
-
-    return true;
-}
-
-void IspParamAdaptor::updateLscSeqMap(int64_t settingSeq) {
-    mSeqIdToLscSeqIdMap[settingSeq] = mLastLscSequece;
-
-    if (mSeqIdToLscSeqIdMap.size() > ISP_PARAM_QUEUE_SIZE) {
-        mSeqIdToLscSeqIdMap.erase(mSeqIdToLscSeqIdMap.begin());
-    }
-}
-
-bool IspParamAdaptor::isGdcCopy(int64_t bufSeq, int64_t settingSeq) {
-    if (!PlatformData::isDvsSupported(mCameraId)) return false;
-
-    if (AiqResultStorage::getInstance(mCameraId)->isDvsRun(settingSeq)) {
-        mLastGdcSequence = settingSeq;
-        LOG2("%s, GDC update %ld", __func__, settingSeq);
-        return false;
-    } else {
-        if (mSeqIdToGdcSeqIdMap.find(bufSeq) != mSeqIdToGdcSeqIdMap.end()) {
-            if (mLastGdcSequence >= 0 && mSeqIdToGdcSeqIdMap[bufSeq] == mLastGdcSequence) {
-                return false;
-            }
-        }
-    }
-
-    return true;
-}
-
-void IspParamAdaptor::updateGdcSeqMap(int64_t settingSeq) {
-    mSeqIdToGdcSeqIdMap[settingSeq] = mLastGdcSequence;
-
-    if (mSeqIdToGdcSeqIdMap.size() > ISP_PARAM_QUEUE_SIZE) {
-        mSeqIdToGdcSeqIdMap.erase(mSeqIdToGdcSeqIdMap.begin());
-    }
-}
-
 /**
  * runIspAdapt
  * Convert the results of the 3A algorithms and parse with P2P.
@@ -564,12 +552,25 @@ int IspParamAdaptor::runIspAdapt(const IspSettings* ispSettings, int64_t setting
                      "%s, wrong state %d", __func__, mIspAdaptorState);
     CheckAndLogError(!mGraphConfig, UNKNOWN_ERROR, "%s, mGraphConfig is nullptr", __func__);
 
+    // The AIC of the streams is independent, only the PAL buffers and records are shared
+    struct AdaptTask {
+        int streamId;
+        IspParameter* ispParam;
+        std::map<int64_t, ia_binary_data>::iterator dataIt;
+        ia_binary_data binaryData;
+        ia_isp_bxt_gdc_limits* mbrData;
+        ia_isp_bxt_program_group* pgPtr;
+        int ret;
+    };
+    std::vector<AdaptTask> tasks;
+
     for (auto& it : mStreamIdToIspParameterMap) {
         if (streamId != -1 && it.first != streamId) continue;
 
-        ia_binary_data binaryData = {};
-        IspParameter* ispParam = &(it.second);
-        auto dataIt = ispParam->mSequenceToDataMap.end();
+        AdaptTask task = {it.first, &(it.second), it.second.mSequenceToDataMap.end(), {},
+                          nullptr, nullptr, OK};
+        IspParameter* ispParam = task.ispParam;
+        auto& dataIt = task.dataIt;
 
         {
             AutoMutex l(mIpuParamLock);
@@ -583,29 +584,45 @@ int IspParamAdaptor::runIspAdapt(const IspSettings* ispSettings, int64_t setting
             }
             CheckAndLogError(dataIt == ispParam->mSequenceToDataMap.end(), UNKNOWN_ERROR,
                              "No PAL buf!");
-            binaryData = dataIt->second;
+            task.binaryData = dataIt->second;
 
             LOG2("<seq%ld:streamId%d>@%s, Pal data buffer seq: %ld", settingSequence, it.first,
                  __func__, dataIt->first);
         }
 
-        ia_isp_bxt_gdc_limits* mbrData = nullptr;
-        binaryData.size = mStreamIdToPGOutSizeMap[it.first];
+        task.binaryData.size = mStreamIdToPGOutSizeMap[it.first];
         if (mStreamIdToMbrDataMap.find(it.first) != mStreamIdToMbrDataMap.end())
-            mbrData = &(mStreamIdToMbrDataMap[it.first]);
+            task.mbrData = &(mStreamIdToMbrDataMap[it.first]);
 
         // Update some PAL data to latest PAL result
         if (it.first == VIDEO_STREAM_ID) {
-            updatePalDataForVideoPipe(binaryData, dataIt->first, settingSequence);
+            updatePalDataForVideoPipe(task.binaryData, settingSequence);
         }
 
-        ia_isp_bxt_program_group* pgPtr = mGraphConfig->getProgramGroup(it.first);
-        CheckAndLogError(!pgPtr, UNKNOWN_ERROR,
+        task.pgPtr = mGraphConfig->getProgramGroup(it.first);
+        CheckAndLogError(!task.pgPtr, UNKNOWN_ERROR,
                          "%s, Failed to get the programGroup for streamId: %d", __func__, it.first);
+        tasks.push_back(task);
+    }
 
-        int ret = runIspAdaptL(pgPtr, mbrData, ispSettings, settingSequence, &binaryData, it.first);
-        CheckAndLogError(ret != OK, ret, "run isp adaptor error for streamId %d, sequence: %ld",
-                         it.first, settingSequence);
+    // Each stream has its own PAL input parameters and buffer, so their AIC can run in parallel
+    auto runTasks = [&](int start, int end) {
+        for (int i = start; i < end; i++) {
+            AdaptTask& task = tasks[i];
+            task.ret = runIspAdaptL(task.pgPtr, task.mbrData, ispSettings, settingSequence,
+                                    &task.binaryData, task.streamId);
+        }
+    };
+    ThreadPool::forEachItem(static_cast<int>(tasks.size()),
+                            PlatformData::getIspAdaptThreads(mCameraId), runTasks);
+
+    // Complete the streams in the order of stream id, no matter which one finishes first
+    for (auto& task : tasks) {
+        CheckAndLogError(task.ret != OK, task.ret,
+                         "run isp adaptor error for streamId %d, sequence: %ld", task.streamId,
+                         settingSequence);
+        IspParameter* ispParam = task.ispParam;
+        ia_binary_data& binaryData = task.binaryData;
         {
             AutoMutex l(mIpuParamLock);
             int64_t dataSequence = settingSequence;
@@ -618,13 +635,13 @@ int IspParamAdaptor::runIspAdapt(const IspSettings* ispSettings, int64_t setting
             }
             updateIspParameterMap(ispParam, dataSequence, settingSequence, binaryData);
             if (binaryData.size > 0) {
-                ispParam->mSequenceToDataMap.erase(dataIt);
+                ispParam->mSequenceToDataMap.erase(task.dataIt);
 
-                if (it.first == VIDEO_STREAM_ID) {
+                if (task.streamId == VIDEO_STREAM_ID) {
+                    bool firstRun = mLastPalDataForVideoPipe.data == nullptr;
                     mLastPalDataForVideoPipe = binaryData;
                     updateResultFromAlgo(&binaryData, settingSequence);
-                    updateLscSeqMap(settingSequence);
-                    updateGdcSeqMap(settingSequence);
+                    updatePalRecordGeneration(binaryData, settingSequence, firstRun);
                 }
             }
         }
@@ -796,7 +813,11 @@ int IspParamAdaptor::runIspAdaptL(ia_isp_bxt_program_group* pgPtr, ia_isp_bxt_gd
     LOG2("<id%d:streamId:%d>@%s: aiq result id %ld", mCameraId, streamId, __func__,
          aiqResults->mFrameId);
 
-    cca::cca_pal_input_params* inputParams = mStreamIdToPalInputParamsMap[streamId];
+    // The streams may run in parallel, so only look up the map here
+    auto paramsIt = mStreamIdToPalInputParamsMap.find(streamId);
+    CheckAndLogError(paramsIt == mStreamIdToPalInputParamsMap.end(), UNKNOWN_ERROR,
+                     "%s, no PAL input parameters for streamId: %d", __func__, streamId);
+    cca::cca_pal_input_params* inputParams = paramsIt->second;
     inputParams->seq_id = settingSequence;
 
     bool useLinearGamma = false;
@@ -92,7 +92,7 @@ class IspParamAdaptor {
     int initProgramGroupForAllStreams(ConfigMode configMode);
     void initInputParams(cca::cca_pal_input_params* params);
 
-    void updatePalDataForVideoPipe(ia_binary_data dest, int64_t bufSeq, int64_t settingSeq);
+    void updatePalDataForVideoPipe(ia_binary_data dest, int64_t settingSeq);
 
     struct IspParameter {
         /*
@@ -127,11 +127,12 @@ class IspParamAdaptor {
     void updateResultFromAlgo(ia_binary_data* binaryData, int64_t sequence);
     uint32_t getRequestedStats();
 
-    bool isLscCopy(int64_t bufSeq, int64_t settingSeq);
-    void updateLscSeqMap(int64_t settingSeq);
-
-    bool isGdcCopy(int64_t bufSeq, int64_t settingSeq);
-    void updateGdcSeqMap(int64_t settingSeq);
+    struct PalRecord;
+    bool isPalRecordEnabled(const PalRecord& record);
+    bool isPalRecordUpdated(const PalRecord& record, int64_t settingSeq);
+    void updatePalRecordGeneration(const ia_binary_data& binaryData, int64_t settingSeq,
+                                   bool firstRun);
+    void resetPalRecords();
 
  private:
     enum IspAdaptorState {
@@ -152,12 +153,6 @@ class IspParamAdaptor {
     std::map<int, IspParameter> mStreamIdToIspParameterMap;  // map from stream id to IspParameter
     ia_binary_data mLastPalDataForVideoPipe;
 
-    int64_t mLastLscSequece;
-    std::map<int64_t, int64_t> mSeqIdToLscSeqIdMap;
-
-    int64_t mLastGdcSequence;
-    std::map<int64_t, int64_t> mSeqIdToGdcSeqIdMap;
-
     // Guard lock for ipu parameter
     Mutex mIpuParamLock;
     std::unordered_map<int, cca::cca_pal_input_params*> mStreamIdToPalInputParamsMap;
@@ -165,10 +160,28 @@ class IspParamAdaptor {
     IntelCca* mIntelCca;
     int mGammaTmOffset;
 
+    // The AIQ results which a PAL record depends on
+    enum PalRecordSource {
+        PAL_SOURCE_ANY,  // May be updated by any AIC run
+        PAL_SOURCE_LSC,  // Updated when the LSC of the AIQ result is updated
+        PAL_SOURCE_DVS,  // Updated when the DVS runs for the sequence
+    };
+
+    /**
+     * The video PAL records which AIC may skip, they are carried forward from the latest
+     * PAL output. The generation is increased when AIC outputs a new record, the PAL
+     * buffer holding the latest generation doesn't need the copy.
+     */
     struct PalRecord {
         int uuid;
         int offset;
+        PalRecordSource source;
+        uint64_t generation;
+        uint64_t copyCount;
+        uint64_t reuseCount;
     };
     std::vector<PalRecord> mPalRecords;  // Save PAL offset info for overwriting PAL
+    // PAL buffer data -> generations of the records (aligned with mPalRecords) it holds
+    std::unordered_map<const void*, std::vector<uint64_t>> mPalBufferGenerations;
 };
 }  // namespace icamera
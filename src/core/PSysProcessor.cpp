@@ -22,7 +22,7 @@
 #include "iutils/Utils.h"
 #include "iutils/CameraLog.h"
 #include "iutils/CameraDump.h"
-#include "iutils/SwImageConverter.h"
+#include "image_process/SwImageConverter.h"
 
 #include "PlatformData.h"
 #include "3a/AiqResultStorage.h"
@@ -200,6 +200,9 @@ int PSysProcessor::start() {
 
     mThreadRunning = true;
     CLEAR(mSofTimestamp);
+    // The pipeline may be reused by a new configuration with the sequence restarted
+    mSofSequence = -1;
+    mLastStillTnrSequence = -1;
     mProcessThread->run("PsysProcessor", PRIORITY_NORMAL);
     for (auto& psysDAGPair : mPSysDAGs) {
         if (!psysDAGPair.second) continue;
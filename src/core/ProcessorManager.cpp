@@ -17,6 +17,10 @@
 #define LOG_TAG ProcessorManager
 
 #include "ProcessorManager.h"
+
+#include <algorithm>
+
+#include "PlatformData.h"
 #include "iutils/CameraLog.h"
 #include "iutils/Utils.h"
 
@@ -31,13 +35,43 @@ ProcessorManager::~ProcessorManager() {
     deleteProcessors();
 }
 
+static bool isSameStream(const stream_t& a, const stream_t& b) {
+    return a.format == b.format && a.width == b.width && a.height == b.height &&
+           a.field == b.field && a.stride == b.stride && a.size == b.size &&
+           a.memType == b.memType && a.usage == b.usage && a.streamType == b.streamType &&
+           a.orientation == b.orientation;
+}
+
+static bool isSameStreams(const std::map<Port, stream_t>& a, const std::map<Port, stream_t>& b) {
+    if (a.size() != b.size()) return false;
+
+    for (auto itA = a.begin(), itB = b.begin(); itA != a.end(); ++itA, ++itB) {
+        if (itA->first != itB->first || !isSameStream(itA->second, itB->second)) return false;
+    }
+    return true;
+}
+
+bool ProcessorManager::isSameConfig(const ProcessorConfig& a, const ProcessorConfig& b) {
+    return a.mConfigModes == b.mConfigModes && a.mTuningModes == b.mTuningModes &&
+           isSameStreams(a.mInputConfigs, b.mInputConfigs) &&
+           isSameStreams(a.mOutputConfigs, b.mOutputConfigs);
+}
+
 std::vector<BufferQueue*> ProcessorManager::createProcessors(
     const std::map<Port, stream_t>& producerConfigs, const std::map<int, Port>& streamIdToPortMap,
-    stream_config_t* streamList, ParameterGenerator* paramGenerator) {
+    stream_config_t* streamList, const std::vector<ConfigMode>& configModes,
+    ParameterGenerator* paramGenerator) {
     LOG1("<id%d>@%s", mCameraId, __func__);
 
     ProcessorConfig processorItem;
     processorItem.mInputConfigs = producerConfigs;
+    processorItem.mConfigModes = configModes;
+    for (auto cfg : configModes) {
+        TuningConfig tuningConfig;
+        if (PlatformData::getTuningConfigByConfigMode(mCameraId, cfg, tuningConfig) == OK) {
+            processorItem.mTuningModes.push_back(tuningConfig.tuningMode);
+        }
+    }
     for (const auto& item : streamIdToPortMap) {
         if (streamList->streams[item.first].streamType == CAMERA_STREAM_INPUT) continue;
         processorItem.mOutputConfigs[item.second] = streamList->streams[item.first];
@@ -58,7 +92,16 @@ std::vector<BufferQueue*> ProcessorManager::createProcessors(
 
     if (mPsysUsage == PSYS_NORMAL) {
         LOG1("%s, Using normal Psys to do image processing.", __func__);
-        processorItem.mProcessor = new PSysProcessor(mCameraId, paramGenerator);
+        auto cached = std::find_if(
+            mCachedPipelines.begin(), mCachedPipelines.end(),
+            [&](const ProcessorConfig& item) { return isSameConfig(item, processorItem); });
+        if (cached != mCachedPipelines.end()) {
+            LOG1("%s, Reuse the configured Psys pipeline", __func__);
+            processorItem = *cached;
+            mCachedPipelines.erase(cached);
+        } else {
+            processorItem.mProcessor = new PSysProcessor(mCameraId, paramGenerator);
+        }
         mProcessors.push_back(processorItem);
     }
 
@@ -76,17 +119,38 @@ std::vector<BufferQueue*> ProcessorManager::createProcessors(
     return processors;
 }
 
-int ProcessorManager::deleteProcessors() {
+int ProcessorManager::deleteProcessors(bool keepPipeline) {
+    size_t cacheSize = keepPipeline ? PlatformData::getPsysPipelineCacheSize(mCameraId) : 0;
     for (auto& item : mProcessors) {
+        if (mPsysUsage == PSYS_NORMAL && item.mConfigured && cacheSize > 0) {
+            mCachedPipelines.push_front(item);
+            continue;
+        }
         delete item.mProcessor;
     }
     mProcessors.clear();
 
+    while (mCachedPipelines.size() > cacheSize) {
+        delete mCachedPipelines.back().mProcessor;
+        mCachedPipelines.pop_back();
+    }
+
     mPsysUsage = PSYS_NOT_USED;
 
     return OK;
 }
 
+void ProcessorManager::releaseCachedPipelines() {
+    if (mCachedPipelines.empty()) return;
+
+    LOG1("<id%d>@%s, release %zu cached Psys pipelines", mCameraId, __func__,
+         mCachedPipelines.size());
+    for (auto& item : mCachedPipelines) {
+        delete item.mProcessor;
+    }
+    mCachedPipelines.clear();
+}
+
 /**
  * Configure processor with input and output streams
  */
@@ -99,8 +163,12 @@ int ProcessorManager::configureProcessors(const std::vector<ConfigMode>& configM
         BufferQueue* processor = item.mProcessor;
         processor->setFrameInfo(item.mInputConfigs, item.mOutputConfigs);
         processor->setParameters(param);
-        int ret = processor->configure(configModes);
-        CheckAndLogError(ret < 0, ret, "Configure processor failed with:%d", ret);
+        // The reused pipeline has been configured with the same frame info and config modes
+        if (!item.mConfigured) {
+            int ret = processor->configure(configModes);
+            CheckAndLogError(ret < 0, ret, "Configure processor failed with:%d", ret);
+            item.mConfigured = true;
+        }
 
         processor->setBufferProducer(preProcess ? preProcess : producer);
         preProcess = processor;
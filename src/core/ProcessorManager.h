@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <list>
+
 #include "BufferQueue.h"
 
 namespace icamera {
@@ -26,6 +28,12 @@ class ParameterGenerator;
  * \class ProcessorManager
  *
  * \brief ProcessorManager helps to create and maintain the post processors.
+ *
+ * The configured PSysProcessors can be kept after they are released for a reconfiguration,
+ * up to PlatformData::getPsysPipelineCacheSize(). A later configuration with the same
+ * frame info and config modes reuses the least recently released one instead of creating
+ * and configuring the PSYS pipeline again. The cache is dropped before the IntelCca instances
+ * are re-created, since the ISP parameter buffers of the pipelines are allocated from them.
  */
 class ProcessorManager {
  public:
@@ -35,10 +43,20 @@ class ProcessorManager {
     std::vector<BufferQueue*> createProcessors(const std::map<Port, stream_t>& producerConfigs,
                                                const std::map<int, Port>& streamIdToPortMap,
                                                stream_config_t* streamList,
+                                               const std::vector<ConfigMode>& configModes,
                                                ParameterGenerator* paramGenerator);
     int configureProcessors(const std::vector<ConfigMode>& configModes, BufferProducer* producer,
                             const Parameters& param);
-    int deleteProcessors();
+    /**
+     * \brief Delete the processors, the configured PSysProcessor is kept for the next
+     * configuration if keepPipeline is true and the cache is enabled.
+     */
+    int deleteProcessors(bool keepPipeline = false);
+    /**
+     * \brief Delete the cached PSysProcessors, it must be called before the IntelCca
+     * instances used by them are released.
+     */
+    void releaseCachedPipelines();
 
  private:
     DISALLOW_COPY_AND_ASSIGN(ProcessorManager);
@@ -51,12 +69,20 @@ class ProcessorManager {
     } mPsysUsage;
 
     struct ProcessorConfig {
+        ProcessorConfig() : mProcessor(nullptr), mConfigured(false) {}
         BufferQueue* mProcessor;
         std::map<Port, stream_t> mInputConfigs;
         std::map<Port, stream_t> mOutputConfigs;
+        std::vector<ConfigMode> mConfigModes;
+        std::vector<TuningMode> mTuningModes;
+        bool mConfigured;
     };
 
+    bool isSameConfig(const ProcessorConfig& a, const ProcessorConfig& b);
+
     std::vector<ProcessorConfig> mProcessors;
+    // The configured PSysProcessors, the most recently released one is at the front
+    std::list<ProcessorConfig> mCachedPipelines;
 };
 
 }  // end of namespace icamera
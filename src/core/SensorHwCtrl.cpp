@@ -25,6 +25,7 @@
 
 #include "PlatformData.h"
 #include "SensorHwCtrl.h"
+#include "SysCall.h"
 #include "V4l2DeviceFactory.h"
 #include "iutils/CameraLog.h"
 
@@ -47,7 +48,10 @@ SensorHwCtrl::SensorHwCtrl(int cameraId, V4L2Subdevice* pixelArraySubdev,
           mWdrMode(0),
           // HDR_FEATURE_E
           mCurFll(0),
-          mCalculatingFrameDuration(true) {
+          mCalculatingFrameDuration(true),
+          mGatheringControls(false),
+          mPendingLlp(0),
+          mPendingFll(0) {
     LOG1("<id%d> @%s", mCameraId, __func__);
     // CRL_MODULE_S
     /**
@@ -112,7 +116,7 @@ int SensorHwCtrl::configure() {
     int rhs1 = PlatformData::getFixedVbp(mCameraId);  // VBP is rhs1 register value
     if (rhs1 >= 0) {                                  // Fixed VBP enabled
         LOG1("%s: set fixed VBP %d", __func__, rhs1);
-        int status = mPixelArraySubdev->SetControl(CRL_CID_EXPOSURE_RHS1, rhs1);
+        int status = setControl(CRL_CID_EXPOSURE_RHS1, rhs1);
         CheckAndLogError(status != OK, status, "%s failed to o set exposure RHS1.", __func__);
     }
     // DOL_FEATURE_E
@@ -176,7 +180,7 @@ int SensorHwCtrl::setExposure(const vector<int>& coarseExposures,
 
     LOG2("%s coarseExposure=%d fineExposure=%d", __func__, coarseExposures[0], fineExposures[0]);
     LOG2("SENSORCTRLINFO: exposure_value=%d", coarseExposures[0]);
-    return mPixelArraySubdev->SetControl(V4L2_CID_EXPOSURE, coarseExposures[0]);
+    return setControl(V4L2_CID_EXPOSURE, coarseExposures[0]);
 }
 
 // CRL_MODULE_S
@@ -189,7 +193,7 @@ int SensorHwCtrl::setMultiExposures(const vector<int>& coarseExposures,
     if (coarseExposures.size() > 2) {
         LOG2("coarseExposure[0]=%d fineExposure[0]=%d", coarseExposures[0], fineExposures[0]);
         // The first exposure is very short exposure if larger than 2 exposures.
-        status = mPixelArraySubdev->SetControl(CRL_CID_EXPOSURE_SHS2, coarseExposures[0]);
+        status = setControl(CRL_CID_EXPOSURE_SHS2, coarseExposures[0]);
         CheckAndLogError(status != OK, status, "failed to set exposure SHS2 %d.",
                          coarseExposures[0]);
 
@@ -202,10 +206,10 @@ int SensorHwCtrl::setMultiExposures(const vector<int>& coarseExposures,
     }
 
     LOG2("shortExp=%d longExp=%d", shortExp, longExp);
-    status = mPixelArraySubdev->SetControl(CRL_CID_EXPOSURE_SHS1, shortExp);
+    status = setControl(CRL_CID_EXPOSURE_SHS1, shortExp);
     CheckAndLogError(status != OK, status, "failed to set exposure SHS1 %d.", shortExp);
 
-    status = mPixelArraySubdev->SetControl(V4L2_CID_EXPOSURE, longExp);
+    status = setControl(V4L2_CID_EXPOSURE, longExp);
     CheckAndLogError(status != OK, status, "failed to set long exposure %d.", longExp);
     LOG2("SENSORCTRLINFO: exposure_value=%d", longExp);
 
@@ -220,7 +224,7 @@ int SensorHwCtrl::setDualExposuresDCGAndVS(const vector<int>& coarseExposures,
     if (coarseExposures.size() > 2) {
         LOG2("coarseExposure[0]=%d fineExposure[0]=%d", coarseExposures[0], fineExposures[0]);
         // The first exposure is very short exposure for DCG + VS case.
-        status = mPixelArraySubdev->SetControl(CRL_CID_EXPOSURE_SHS1, coarseExposures[0]);
+        status = setControl(CRL_CID_EXPOSURE_SHS1, coarseExposures[0]);
         CheckAndLogError(status != OK, status, "failed to set exposure SHS1 %d.",
                          coarseExposures[0]);
 
@@ -228,7 +232,7 @@ int SensorHwCtrl::setDualExposuresDCGAndVS(const vector<int>& coarseExposures,
         LOG2("SENSORCTRLINFO: exposure_long=%d", coarseExposures[2]);  // long
     }
 
-    status = mPixelArraySubdev->SetControl(V4L2_CID_EXPOSURE, longExp);
+    status = setControl(V4L2_CID_EXPOSURE, longExp);
     CheckAndLogError(status != OK, status, "failed to set long exposure %d.", longExp);
     LOG2("SENSORCTRLINFO: exposure_value=%d", longExp);
 
@@ -259,7 +263,7 @@ int SensorHwCtrl::setShutterAndReadoutTiming(const vector<int>& coarseExposures,
                 CheckWarning((shs3 < range.SHS3.min || shs3 > range.SHS3.max), NO_INIT,
                              "%s : SHS3 not match %d [%d ~ %d]", __func__, shs3, range.SHS3.min,
                              range.SHS3.max);
-                status = mPixelArraySubdev->SetControl(CRL_CID_EXPOSURE_SHS3, shs3);
+                status = setControl(CRL_CID_EXPOSURE_SHS3, shs3);
                 CheckAndLogError(status != OK, status, "%s failed to set exposure SHS3.", __func__);
 
                 // RHS2 range [SHS2 + upperBound ~ SHS3 - lowerBound] and should = min + n * step
@@ -268,22 +272,23 @@ int SensorHwCtrl::setShutterAndReadoutTiming(const vector<int>& coarseExposures,
                 CheckWarning((rhs2 < range.RHS2.min || rhs2 > range.RHS2.max), NO_INIT,
                              "%s : RHS2 not match %d [%d ~ %d]", __func__, rhs2, range.RHS2.min,
                              range.RHS2.max);
-                status = mPixelArraySubdev->SetControl(CRL_CID_EXPOSURE_RHS2, rhs2);
+                status = setControl(CRL_CID_EXPOSURE_RHS2, rhs2);
                 CheckAndLogError(status != OK, status, "%s failed to set exposure RHS2.", __func__);
 
                 // SEF2(coarseExposures[1]) = RHS2 - SHS2 - OFFSET
                 shs2 = rhs2 - coarseExposures[1] - 1;
             } else {
                 // LEF(coarseExposures[2]) = FLL + SHS2.upperBound - SHS2 - OFFSET
-                shs2 = mCurFll + range.SHS2.upperBound - coarseExposures[1] - 1;
+                shs2 = currentFll() + range.SHS2.upperBound - coarseExposures[1] - 1;
             }
 
             // SHS2 range [RHS1 + RHS1.upperBound ~ SHS2.max]
-            CheckWarningNoReturn(shs2 < range.SHS2.min || shs2 > std::max(range.SHS2.max, mCurFll),
+            int shs2Max = std::max(range.SHS2.max, currentFll());
+            CheckWarningNoReturn(shs2 < range.SHS2.min || shs2 > shs2Max,
                                  "%s : SHS2 not match %d [%d ~ %d]", __func__, shs2, range.SHS2.min,
-                                 std::max(range.SHS2.max, mCurFll));
-            shs2 = CLIP(shs2, std::max(range.SHS2.max, mCurFll), range.SHS2.min);
-            status = mPixelArraySubdev->SetControl(CRL_CID_EXPOSURE_SHS2, shs2);
+                                 shs2Max);
+            shs2 = CLIP(shs2, shs2Max, range.SHS2.min);
+            status = setControl(CRL_CID_EXPOSURE_SHS2, shs2);
             CheckAndLogError(status != OK, status, "%s failed to set exposure SHS2.", __func__);
 
             // RHS1 range [SHS1 + upperBound ~ SHS2 - lowerBound] and should = min + n * step
@@ -299,7 +304,7 @@ int SensorHwCtrl::setShutterAndReadoutTiming(const vector<int>& coarseExposures,
                 rhs1 = CLIP(rhs1, range.RHS1.max, range.RHS1.min);
                 // Set RHS1 if not using fixed VBP
                 LOG2("%s: set dynamic VBP %d", __func__, rhs1);
-                status = mPixelArraySubdev->SetControl(CRL_CID_EXPOSURE_RHS1, rhs1);
+                status = setControl(CRL_CID_EXPOSURE_RHS1, rhs1);
                 CheckAndLogError(status != OK, status, "%s failed to set exposure RHS1.", __func__);
             } else {
                 // Use fixed VBP for RHS1 value
@@ -320,7 +325,7 @@ int SensorHwCtrl::setShutterAndReadoutTiming(const vector<int>& coarseExposures,
                                  "%s : SHS1 not match %d [%d ~ %d]", __func__, shs1, range.SHS1.min,
                                  range.SHS1.max);
             shs1 = CLIP(shs1, range.SHS1.max, range.SHS1.min);
-            status = mPixelArraySubdev->SetControl(CRL_CID_EXPOSURE_SHS1, shs1);
+            status = setControl(CRL_CID_EXPOSURE_SHS1, shs1);
             CheckAndLogError(status != OK, status, "%s failed to set exposure SHS1.", __func__);
 
             LOG2("%s: set exposures done.", __func__);
@@ -351,13 +356,13 @@ int SensorHwCtrl::setAnalogGains(const vector<int>& analogGains) {
     // CRL_MODULE_E
 
     LOG2("%s analogGain=%d", __func__, analogGains[0]);
-    int status = mPixelArraySubdev->SetControl(V4L2_CID_ANALOGUE_GAIN, analogGains[0]);
+    int status = setControl(V4L2_CID_ANALOGUE_GAIN, analogGains[0]);
     CheckAndLogError(status != OK, status, "failed to set analog gain %d.", analogGains[0]);
 #ifdef V4L2_CID_BLC
     int low, high;
     if (PlatformData::getDisableBLCByAGain(mCameraId, low, high)) {
         // Set V4L2_CID_BLC to 0(disable) if analog gain falls into the given range.
-        status = mPixelArraySubdev->SetControl(
+        status = setControl(
             V4L2_CID_BLC, (analogGains[0] >= low && analogGains[0] <= high) ? 0 : 1);
     }
 #endif
@@ -382,14 +387,14 @@ int SensorHwCtrl::setDigitalGains(const vector<int>& digitalGains) {
     if (mWdrMode && PlatformData::getSensorGainType(mCameraId) == ISP_DG_AND_SENSOR_DIRECT_AG) {
         LOG2("%s: WDR mode, skip sensor DG, all digital gain is passed to ISP", __func__);
     } else if (PlatformData::isUsingSensorDigitalGain(mCameraId)) {
-        if (mPixelArraySubdev->SetControl(V4L2_CID_GAIN, digitalGains[0]) != OK) {
+        if (setControl(V4L2_CID_GAIN, digitalGains[0]) != OK) {
             LOGW("set digital gain failed");
         }
     }
     // CRL_MODULE_E
 
     LOG2("%s digitalGain=%d", __func__, digitalGains[0]);
-    return mPixelArraySubdev->SetControl(V4L2_CID_DIGITAL_GAIN, digitalGains[0]);
+    return setControl(V4L2_CID_DIGITAL_GAIN, digitalGains[0]);
 }
 
 // CRL_MODULE_S
@@ -400,7 +405,7 @@ int SensorHwCtrl::setMultiDigitalGain(const vector<int>& digitalGains) {
 
     if (digitalGains.size() > 2) {
         LOG2("digitalGains[0]=%d", digitalGains[0]);
-        status = mPixelArraySubdev->SetControl(CRL_CID_DIGITAL_GAIN_VS, digitalGains[0]);
+        status = setControl(CRL_CID_DIGITAL_GAIN_VS, digitalGains[0]);
         CheckAndLogError(status != OK, status, "failed to set very short DG %d.", digitalGains[0]);
 
         shortDg = digitalGains[1];
@@ -408,10 +413,10 @@ int SensorHwCtrl::setMultiDigitalGain(const vector<int>& digitalGains) {
     }
 
     LOG2("shortDg=%d longDg=%d", shortDg, longDg);
-    status = mPixelArraySubdev->SetControl(CRL_CID_DIGITAL_GAIN_S, shortDg);
+    status = setControl(CRL_CID_DIGITAL_GAIN_S, shortDg);
     CheckAndLogError(status != OK, status, "failed to set short DG %d.", shortDg);
 
-    status = mPixelArraySubdev->SetControl(V4L2_CID_GAIN, longDg);
+    status = setControl(V4L2_CID_GAIN, longDg);
     CheckAndLogError(status != OK, status, "failed to set long DG %d.", longDg);
 
     return status;
@@ -424,7 +429,7 @@ int SensorHwCtrl::setMultiAnalogGain(const vector<int>& analogGains) {
 
     if (analogGains.size() > 2) {
         LOG2("VS AG %d", analogGains[0]);
-        int status = mPixelArraySubdev->SetControl(CRL_CID_ANALOG_GAIN_VS, analogGains[0]);
+        int status = setControl(CRL_CID_ANALOG_GAIN_VS, analogGains[0]);
         CheckAndLogError(status != OK, status, "failed to set VS AG %d", analogGains[0]);
 
         shortAg = analogGains[1];
@@ -436,10 +441,10 @@ int SensorHwCtrl::setMultiAnalogGain(const vector<int>& analogGains) {
     }
 
     LOG2("shortAg=%d longAg=%d", shortAg, longAg);
-    status = mPixelArraySubdev->SetControl(CRL_CID_ANALOG_GAIN_S, shortAg);
+    status = setControl(CRL_CID_ANALOG_GAIN_S, shortAg);
     CheckAndLogError(status != OK, status, "failed to set short AG %d.", shortAg);
 
-    status = mPixelArraySubdev->SetControl(V4L2_CID_ANALOGUE_GAIN, longAg);
+    status = setControl(V4L2_CID_ANALOGUE_GAIN, longAg);
     CheckAndLogError(status != OK, status, "failed to set long AG %d.", longAg);
 
     return status;
@@ -457,7 +462,7 @@ int SensorHwCtrl::setConversionGain(const vector<int>& analogGains) {
     LOG2("very short AG %d, short AG %d, long AG %d, conversion value %d", analogGains[0],
          analogGains[1], analogGains[2], value);
 
-    int status = mPixelArraySubdev->SetControl(V4L2_CID_ANALOGUE_GAIN, value);
+    int status = setControl(V4L2_CID_ANALOGUE_GAIN, value);
     CheckAndLogError(status != OK, status, "failed to set AG %d", value);
 
     return OK;
@@ -471,16 +476,20 @@ int SensorHwCtrl::setLineLengthPixels(int llp) {
     if (mCalculatingFrameDuration) {
         int horzBlank = llp - mCropWidth;
         if (mHorzBlank != horzBlank) {
-            status = mPixelArraySubdev->SetControl(V4L2_CID_HBLANK, horzBlank);
+            status = setControl(V4L2_CID_HBLANK, horzBlank);
         }
         // CRL_MODULE_S
     } else {
-        status = mPixelArraySubdev->SetControl(V4L2_CID_LINE_LENGTH_PIXELS, llp);
+        status = setControl(V4L2_CID_LINE_LENGTH_PIXELS, llp);
         // CRL_MODULE_E
     }
 
     CheckAndLogError(status != OK, status, "failed to set llp.");
 
+    if (mGatheringControls) {
+        mPendingLlp = llp;
+        return status;
+    }
     mHorzBlank = llp - mCropWidth;
     return status;
 }
@@ -492,14 +501,19 @@ int SensorHwCtrl::setFrameLengthLines(int fll) {
     if (mCalculatingFrameDuration) {
         int vertBlank = fll - mCropHeight;
         if (mVertBlank != vertBlank) {
-            status = mPixelArraySubdev->SetControl(V4L2_CID_VBLANK, vertBlank);
+            status = setControl(V4L2_CID_VBLANK, vertBlank);
         }
         // CRL_MODULE_S
     } else {
-        status = mPixelArraySubdev->SetControl(V4L2_CID_FRAME_LENGTH_LINES, fll);
+        status = setControl(V4L2_CID_FRAME_LENGTH_LINES, fll);
         // CRL_MODULE_E
     }
 
+    if (mGatheringControls) {
+        mPendingFll = fll;
+        return status;
+    }
+
     mCurFll = fll;
 
     CheckAndLogError(status != OK, status, "failed to set fll.");
@@ -508,6 +522,119 @@ int SensorHwCtrl::setFrameLengthLines(int fll) {
     return status;
 }
 
+/**
+ * The drivers update the exposure range when the blanking or frame length is set, while
+ * a grouped write checks all the values before setting any of them. So these controls are
+ * written before the others, or a longer exposure in the same frame may be clipped.
+ */
+static bool isFrameTimingControl(uint32_t id) {
+    if (id == V4L2_CID_VBLANK || id == V4L2_CID_HBLANK) return true;
+    // CRL_MODULE_S
+    if (id == V4L2_CID_LINE_LENGTH_PIXELS || id == V4L2_CID_FRAME_LENGTH_LINES) return true;
+    // CRL_MODULE_E
+    return false;
+}
+
+void SensorHwCtrl::beginControls() {
+    LOG2("@%s, %zu controls not committed", __func__, mPendingControls.size());
+    mGatheringControls = true;
+}
+
+int SensorHwCtrl::commitControls() {
+    mGatheringControls = false;
+    int llp = mPendingLlp;
+    int fll = mPendingFll;
+    mPendingLlp = 0;
+    mPendingFll = 0;
+
+    std::vector<struct v4l2_ext_control> timingControls;
+    std::vector<struct v4l2_ext_control> otherControls;
+    for (const auto& control : mPendingControls) {
+        if (isFrameTimingControl(control.id)) {
+            timingControls.push_back(control);
+        } else {
+            otherControls.push_back(control);
+        }
+    }
+    mPendingControls.clear();
+
+    int status = writeControls(&timingControls);
+    // The blanking is written only if it differs from the cached one, so the cache is
+    // updated only if the driver has taken the values
+    if (status == OK) {
+        if (llp) mHorzBlank = llp - mCropWidth;
+        if (fll) {
+            mCurFll = fll;
+            mVertBlank = fll - mCropHeight;
+        }
+    }
+    int ret = writeControls(&otherControls);
+    return status != OK ? status : ret;
+}
+
+int SensorHwCtrl::setControl(int id, int value) {
+    if (!mGatheringControls) {
+        return mPixelArraySubdev->SetControl(id, value);
+    }
+
+    // Keep the first position of the control, and the last value of it.
+    for (auto& control : mPendingControls) {
+        if (control.id == static_cast<uint32_t>(id)) {
+            control.value = value;
+            return OK;
+        }
+    }
+
+    struct v4l2_ext_control control;
+    CLEAR(control);
+    control.id = id;
+    control.value = value;
+    mPendingControls.push_back(control);
+    return OK;
+}
+
+int SensorHwCtrl::writeControls(std::vector<struct v4l2_ext_control>* controls) {
+    if (controls->empty()) return OK;
+
+    // The ids are gathered in the reused vector, to avoid allocating it every frame
+    mControlIds.clear();
+    for (const auto& control : *controls) mControlIds.push_back(control.id);
+    bool grouped = mControlIds.size() > 1 &&
+                   mUngroupedControlSets.find(mControlIds) == mUngroupedControlSets.end();
+    if (grouped) {
+        struct v4l2_ext_controls extControls;
+        CLEAR(extControls);
+        // 0 is V4L2_CTRL_WHICH_CUR_VAL, which allows the controls of different classes.
+        extControls.ctrl_class = 0;
+        extControls.count = controls->size();
+        extControls.controls = controls->data();
+
+        int fd = V4l2DeviceFactory::getDeviceFd(mPixelArraySubdev);
+        int ret = SysCall::getInstance()->ioctl(fd, VIDIOC_S_EXT_CTRLS, &extControls);
+        if (ret == 0) {
+            LOG2("@%s, %zu controls are written together", __func__, controls->size());
+            return OK;
+        }
+        LOGW("%s: failed to write %zu controls together, error index %u: %s", __func__,
+             controls->size(), extControls.error_idx, strerror(errno));
+    }
+
+    int status = OK;
+    for (const auto& control : *controls) {
+        int ret = mPixelArraySubdev->SetControl(control.id, control.value);
+        if (ret != OK) status = ret;
+    }
+
+    // The values are fine one by one, so it's the grouped write of them that the driver
+    // rejects. Don't try it again, or every frame pays a failed ioctl and the warning.
+    if (grouped && status == OK) {
+        LOG1("%s: grouped write of the %zu controls isn't supported, write them one by one",
+             __func__, mControlIds.size());
+        mUngroupedControlSets.insert(mControlIds);
+    }
+    return status;
+}
+
 int SensorHwCtrl::setFrameDuration(int llp, int fll) {
     HAL_TRACE_CALL(CAMERA_DEBUG_LOG_LEVEL2);
     CheckAndLogError(!mPixelArraySubdev, NO_INIT, "pixel array sub device is not set");
@@ -650,8 +777,8 @@ int SensorHwCtrl::setAWB(float r_per_g, float b_per_g) {
 
     LOG2("%s set AWB r_per_g=%f, b_per_g=%f", __func__, r_per_g, b_per_g);
 
-    int ret = mPixelArraySubdev->SetControl(V4L2_CID_RED_BALANCE, static_cast<int>(r_per_g * 256));
-    ret |= mPixelArraySubdev->SetControl(V4L2_CID_BLUE_BALANCE, static_cast<int>(b_per_g * 256));
+    int ret = setControl(V4L2_CID_RED_BALANCE, static_cast<int>(r_per_g * 256));
+    ret |= setControl(V4L2_CID_BLUE_BALANCE, static_cast<int>(b_per_g * 256));
 
     return ret;
 }
@@ -22,6 +22,7 @@
 #include <v4l2_device.h>
 #endif
 
+#include <set>
 #include <vector>
 
 #include "iutils/Errors.h"
@@ -53,6 +54,21 @@ class SensorHwCtrl {
     virtual int getActivePixelArraySize(int& width, int& height, int& pixelCode);
     virtual int getExposureRange(int& exposureMin, int& exposureMax, int& exposureStep);
 
+    /**
+     * Gather the pixel array controls set after it, such as exposures, gains and blanking,
+     * until commitControls is called.
+     */
+    virtual void beginControls();
+
+    /**
+     * Write the gathered controls with one VIDIOC_S_EXT_CTRLS, or one by one if the driver
+     * rejects the grouped write of them. The gathered llp and fll are cached only if the
+     * frame timing controls are written.
+     *
+     *\return OK if successfully.
+     */
+    virtual int commitControls();
+
     // HDR_FEATURE_S
     /**
      * Set WDR mode to sensor which is used to select WDR sensor settings or none-WDR settings.
@@ -83,6 +99,11 @@ class SensorHwCtrl {
     int getLineLengthPixels(int& llp);
     int setFrameLengthLines(int fll);
     int getFrameLengthLines(int& fll);
+    // The fll of the frame being set, the gathered one if it's set in this batch
+    int currentFll() const { return mPendingFll ? mPendingFll : mCurFll; }
+
+    int setControl(int id, int value);
+    int writeControls(std::vector<struct v4l2_ext_control>* controls);
 
     // CRL_MODULE_S
     int setMultiExposures(const std::vector<int>& coarseExposures,
@@ -125,6 +146,16 @@ class SensorHwCtrl {
      * use HBlank/VBlank to calculate it.
      */
     bool mCalculatingFrameDuration;
+
+    bool mGatheringControls;
+    // The ids of the control sets which the driver rejects to write together, they are
+    // written one by one
+    std::set<std::vector<uint32_t>> mUngroupedControlSets;
+    std::vector<uint32_t> mControlIds;  // the ids of the controls being written
+    std::vector<struct v4l2_ext_control> mPendingControls;
+    // The gathered llp and fll, they are cached once they are written. 0 if not set.
+    int mPendingLlp;
+    int mPendingFll;
 };  // class SensorHwCtrl
 
 /**
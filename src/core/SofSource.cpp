@@ -20,6 +20,7 @@
 #include <fcntl.h>
 #include <string>
 #include <poll.h>
+#include <sys/epoll.h>
 
 // VIRTUAL_CHANNEL_S
 #include "linux/ipu-isys.h"
@@ -33,6 +34,8 @@ namespace icamera {
 
 SofSource::SofSource(int cameraId)
         : mPollThread(nullptr),
+          mReactorHandler(this),
+          mUseEventReactor(false),
           mCameraId(cameraId),
           // VIRTUAL_CHANNEL_S
           mAggregatorSubDev(nullptr),
@@ -173,15 +176,28 @@ int SofSource::start() {
         return OK;
     }
 
+    mExitPending = false;
+    mUseEventReactor = PlatformData::isIsysEventReactorEnabled(mCameraId);
+    if (mUseEventReactor) {
+        const int pollTimeoutCount = 10;
+        const int pollTimeout = 1000;
+        std::vector<V4L2Device*> devices;
+        devices.push_back(mIsysReceiverSubDev);
+        int status = V4l2EventReactor::getInstance()->addHandler(&mReactorHandler, devices,
+                                                                 pollTimeout * pollTimeoutCount);
+        if (status == OK) return OK;
+
+        LOGW("%s: failed to use the event reactor, use poll thread", __func__);
+        mUseEventReactor = false;
+    }
+
     if (mFlushFd[0] != -1) {
         // read pipe just in case there is data in pipe.
         char readBuf;
         int readSize = read(mFlushFd[0], reinterpret_cast<void*>(&readBuf), sizeof(char));
         LOG1("%s, readSize %d", __func__, readSize);
     }
-    int status = mPollThread->run("SofSource", PRIORITY_URGENT_AUDIO);
-    mExitPending = false;
-    return status;
+    return mPollThread->run("SofSource", PRIORITY_URGENT_AUDIO);
 }
 
 int SofSource::stop() {
@@ -191,6 +207,11 @@ int SofSource::stop() {
     }
 
     mExitPending = true;
+    if (mUseEventReactor) {
+        V4l2EventReactor::getInstance()->removeHandler(&mReactorHandler);
+        return OK;
+    }
+
     if (mFlushFd[1] != -1) {
         char buf = 0xf;  // random value to write to flush fd.
         int size = write(mFlushFd[1], &buf, sizeof(char));
@@ -237,6 +258,11 @@ int SofSource::poll() {
         return 0;
     }
 
+    handleSofEvent();
+    return 0;
+}
+
+void SofSource::handleSofEvent() {
     struct v4l2_event event;
     CLEAR(event);
     mIsysReceiverSubDev->DequeueEvent(&event);
@@ -254,8 +280,21 @@ int SofSource::poll() {
     eventData.buffer = nullptr;
     eventData.data.sync = syncData;
     notifyListeners(eventData);
+}
 
-    return 0;
+bool SofSource::ReactorHandler::onDeviceReady(V4L2Device* device, uint32_t events) {
+    if (mSofSource->mExitPending) return false;
+
+    CheckAndLogError(events & EPOLLERR, false, "Poll error, events:0x%x", events);
+    mSofSource->handleSofEvent();
+    return true;
+}
+
+bool SofSource::ReactorHandler::onDeviceTimeout() {
+    if (mSofSource->mExitPending) return false;
+
+    LOGI("Sof poll time out.");
+    return true;
 }
 
 }  // namespace icamera
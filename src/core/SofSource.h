@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "CameraEvent.h"
+#include "V4l2EventReactor.h"
 #include "iutils/Thread.h"
 
 namespace icamera {
@@ -56,6 +57,20 @@ class SofSource : public EventSource {
         }
     };
     PollThread* mPollThread;
+
+    // Dequeue the SOF events in the shared event reactor instead of mPollThread
+    class ReactorHandler : public V4l2EventReactor::Handler {
+        SofSource* mSofSource;
+
+     public:
+        explicit ReactorHandler(SofSource* sofSource) : mSofSource(sofSource) {}
+
+        virtual bool onDeviceReady(V4L2Device* device, uint32_t events);
+        virtual bool onDeviceTimeout();
+    };
+    ReactorHandler mReactorHandler;
+    bool mUseEventReactor;
+
     int mCameraId;
     // VIRTUAL_CHANNEL_S
     V4L2Subdevice* mAggregatorSubDev;
@@ -67,6 +82,7 @@ class SofSource : public EventSource {
     bool mSofDisabled;
 
     int poll();
+    void handleSofEvent();
     int mFlushFd[2];  // Flush file descriptor
 };
 
@@ -17,7 +17,7 @@
 #define LOG_TAG SwImageProcessor
 
 #include "iutils/Utils.h"
-#include "iutils/SwImageConverter.h"
+#include "image_process/SwImageConverter.h"
 #include "iutils/CameraLog.h"
 #include "iutils/CameraDump.h"
 
@@ -119,7 +119,8 @@ int SwImageProcessor::processNewFrame() {
             cInBuffer->getWidth(), cInBuffer->getHeight(),
             static_cast<unsigned char*>(cInBuffer->getBufferAddr()), cInBuffer->getBufferSize(),
             cInBuffer->getFormat(), static_cast<unsigned char*>(cOutBuffer->getBufferAddr()),
-            cOutBuffer->getBufferSize(), cOutBuffer->getFormat());
+            cOutBuffer->getBufferSize(), cOutBuffer->getFormat(),
+            PlatformData::getSwProcessingThreads(mCameraId));
         CheckAndLogError((ret < 0), ret, "format convertion failed with %d", ret);
 
         if (CameraDump::isDumpTypeEnable(DUMP_SW_IMG_PROC_OUTPUT)) {
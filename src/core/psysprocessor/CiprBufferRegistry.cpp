@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG CiprBufferRegistry
+
+#include "CiprBufferRegistry.h"
+
+#include <iterator>
+
+#include "iutils/CameraLog.h"
+#include "iutils/Errors.h"
+
+namespace icamera {
+
+size_t CiprBufferRegistry::KeyHash::operator()(const Key& key) const {
+    size_t hash = std::hash<const void*>()(key.ctx);
+    hash = hash * 31 + std::hash<const void*>()(key.ptr);
+    hash = hash * 31 + std::hash<int>()(key.fd);
+    return hash * 31 + std::hash<int>()(key.size);
+}
+
+CiprBufferRegistry::CiprBufferRegistry(int cameraId, size_t maxBufferNum)
+        : mCameraId(cameraId),
+          mMaxBufferNum(maxBufferNum),
+          mHitCount(0),
+          mMissCount(0),
+          mEvictCount(0) {}
+
+CiprBufferRegistry::~CiprBufferRegistry() {
+    AutoMutex l(mLock);
+    LOG1("<id%d>%s, hit %lu, miss %lu, evict %lu, left %zu", mCameraId, __func__, mHitCount,
+         mMissCount, mEvictCount, mEntries.size());
+    for (auto& entry : mEntries) {
+        delete entry.buffer;
+    }
+}
+
+CIPR::Buffer* CiprBufferRegistry::acquire(CIPR::Context* ctx, void* ptr, int size,
+                                          const CreateFunc& create) {
+    CheckAndLogError((size <= 0 || ptr == nullptr), nullptr, "Invalid parameter: size=%d, ptr=%p",
+                     size, ptr);
+    return acquire({ctx, -1, ptr, size}, create);
+}
+
+CIPR::Buffer* CiprBufferRegistry::acquire(CIPR::Context* ctx, int fd, int size,
+                                          const CreateFunc& create) {
+    CheckAndLogError((size <= 0 || fd < 0), nullptr, "Invalid parameter: size: %d, fd: %d", size,
+                     fd);
+    return acquire({ctx, fd, nullptr, size}, create);
+}
+
+CIPR::Buffer* CiprBufferRegistry::acquire(const Key& key, const CreateFunc& create) {
+    AutoMutex l(mLock);
+
+    auto it = mKeyMap.find(key);
+    if (it != mKeyMap.end()) {
+        mHitCount++;
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        it->second->refCount++;
+        return it->second->buffer;
+    }
+
+    mMissCount++;
+    // The buffer is created in the lock, so it isn't registered twice by 2 callers
+    CIPR::Buffer* buffer = create();
+    CheckAndLogError(!buffer, nullptr, "%s, create cipr buffer for fd %d ptr %p failed",
+                     __func__, key.fd, key.ptr);
+
+    mEntries.push_front({key, buffer, 1});
+    mKeyMap[key] = mEntries.begin();
+    mBufferMap[buffer] = mEntries.begin();
+    LOG2("<id%d>%s, register fd %d ptr %p size %d, total %zu", mCameraId, __func__, key.fd,
+         key.ptr, key.size, mEntries.size());
+
+    evictLocked();
+    return buffer;
+}
+
+void CiprBufferRegistry::release(CIPR::Buffer* buffer) {
+    AutoMutex l(mLock);
+
+    auto it = mBufferMap.find(buffer);
+    CheckAndLogError(it == mBufferMap.end(), VOID_VALUE, "%s, unknown buffer %p", __func__,
+                     buffer);
+    CheckAndLogError(it->second->refCount <= 0, VOID_VALUE, "%s, buffer %p isn't referenced",
+                     __func__, buffer);
+    it->second->refCount--;
+}
+
+void CiprBufferRegistry::releaseContext(CIPR::Context* ctx) {
+    AutoMutex l(mLock);
+
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        auto cur = it++;
+        if (cur->key.ctx == ctx) eraseLocked(cur);
+    }
+}
+
+void CiprBufferRegistry::evictLocked() {
+    // Start from the least recently used one
+    auto it = mEntries.end();
+    while (mEntries.size() > mMaxBufferNum && it != mEntries.begin()) {
+        auto cur = --it;
+        if (cur->refCount > 0) continue;
+
+        LOG2("<id%d>%s, evict fd %d ptr %p size %d", mCameraId, __func__, cur->key.fd,
+             cur->key.ptr, cur->key.size);
+        it = std::next(cur);
+        eraseLocked(cur);
+        mEvictCount++;
+    }
+}
+
+void CiprBufferRegistry::eraseLocked(EntryIter it) {
+    mKeyMap.erase(it->key);
+    mBufferMap.erase(it->buffer);
+    delete it->buffer;
+    mEntries.erase(it);
+}
+
+}  // namespace icamera
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+#include "iutils/Thread.h"
+#include "iutils/Utils.h"
+#include "modules/ia_cipr/include/Buffer.h"
+#include "modules/ia_cipr/include/Context.h"
+
+namespace icamera {
+
+/**
+ * \class CiprBufferRegistry
+ *
+ * \brief The user buffers registered to the PSYS, shared by the PGs of one camera.
+ *
+ * The buffers are looked up by (context, fd or user pointer, size) in a hash map, and
+ * kept in a LRU list. A buffer is referenced by the PG terminals using it, only the
+ * unreferenced ones are evicted when the registry is full.
+ *
+ * The kernel mapping of a buffer belongs to the psys file handle, which is opened per
+ * PG context, so the entries of different contexts aren't shared with each other.
+ */
+class CiprBufferRegistry {
+ public:
+    explicit CiprBufferRegistry(int cameraId, size_t maxBufferNum = kMaxBufferNum);
+    ~CiprBufferRegistry();
+
+    typedef std::function<CIPR::Buffer*()> CreateFunc;
+
+    /**
+     * \brief Get the registered buffer and add one reference to it, the buffer is created
+     * by create() if it isn't registered yet.
+     */
+    CIPR::Buffer* acquire(CIPR::Context* ctx, void* ptr, int size, const CreateFunc& create);
+    CIPR::Buffer* acquire(CIPR::Context* ctx, int fd, int size, const CreateFunc& create);
+    void release(CIPR::Buffer* buffer);
+
+    /**
+     * \brief Delete all the buffers of the context, called before the context is deleted.
+     */
+    void releaseContext(CIPR::Context* ctx);
+
+ private:
+    struct Key {
+        CIPR::Context* ctx;
+        int fd;
+        void* ptr;
+        int size;
+
+        bool operator==(const Key& other) const {
+            return ctx == other.ctx && fd == other.fd && ptr == other.ptr && size == other.size;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry {
+        Key key;
+        CIPR::Buffer* buffer;
+        int refCount;
+    };
+
+    typedef std::list<Entry>::iterator EntryIter;
+
+    CIPR::Buffer* acquire(const Key& key, const CreateFunc& create);
+    void evictLocked();
+    void eraseLocked(EntryIter it);
+
+ private:
+    static const size_t kMaxBufferNum = 256;
+
+    int mCameraId;
+    size_t mMaxBufferNum;
+
+    Mutex mLock;  // protect all the members below
+    std::list<Entry> mEntries;  // the most recently used one is at the front
+    std::unordered_map<Key, EntryIter, KeyHash> mKeyMap;
+    std::unordered_map<CIPR::Buffer*, EntryIter> mBufferMap;
+
+    // Statistics
+    uint64_t mHitCount;
+    uint64_t mMissCount;
+    uint64_t mEvictCount;
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(CiprBufferRegistry);
+};
+
+}  // namespace icamera
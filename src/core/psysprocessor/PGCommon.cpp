@@ -81,9 +81,14 @@ PGCommon::PGCommon(int cameraId, int pgId, const std::string& pgName, TuningMode
           mPPGProcessGroup(nullptr),
           mToken(0),
           mEvent(nullptr),
+          mCmdPending(false),
+          mIterSequence(0),
+          mIterStatistics(nullptr),
           mTerminalBuffers(nullptr),
           mInputMainTerminal(-1),
           mOutputMainTerminal(-1),
+          mFlushCount(0),
+          mSkippedFlushCount(0),
           mShareReferPool(nullptr),
           mIpuParameters(nullptr),
           mIntelCca(nullptr) {
@@ -101,6 +106,7 @@ int PGCommon::init() {
 
     mCtx = new CIPR::Context();
     CheckAndLogError(!(mCtx->isInitialized()), UNKNOWN_ERROR, "Failed to initialize Context");
+    if (!mBufferRegistry) mBufferRegistry = std::make_shared<CiprBufferRegistry>(mCameraId);
 
     int ret = getCapability();
     if (ret != OK) return ret;
@@ -135,6 +141,14 @@ int PGCommon::init() {
 }
 
 void PGCommon::deInit() {
+    LOG1("<id%d>%s: %s, tnr buffer flush %lu, skipped %lu", mCameraId, __func__, getName(),
+         mFlushCount, mSkippedFlushCount);
+
+    if (mCmdPending) {
+        waitCmd(reinterpret_cast<uint64_t>(&mCmd));
+        mCmdPending = false;
+    }
+
     if (mPPGStarted) {
         stopPPG();
         mPPGStarted = false;
@@ -162,9 +176,8 @@ void PGCommon::deInit() {
     if (mPPGBuffer) {
         delete mPPGBuffer;
     }
-    for (auto& item : mBuffers) {
-        delete item.ciprBuf;
-    }
+    mFrameBuffers.clear();
+    if (mBufferRegistry) mBufferRegistry->releaseContext(mCtx);
 
     delete mCtx;
 
@@ -379,6 +392,11 @@ int PGCommon::createCommands() {
     mEvent = new CIPR::Event(eventCfg);
     CheckAndLogError(!(mEvent->isInitialized()), UNKNOWN_ERROR, "Failed to initialize Event");
 
+    if (PlatformData::isPsysAsyncSubmissionEnabled(mCameraId)) {
+        mEventReaper = std::unique_ptr<EventReaper>(new EventReaper(mCtx, eventCfg.timeout));
+        mEventReaper->run(mName + "Reaper", PRIORITY_NORMAL);
+    }
+
     return OK;
 }
 
@@ -436,6 +454,11 @@ int PGCommon::createCommand(CIPR::Buffer* pg, CIPR::Command** cmd, CIPR::Buffer*
 }
 
 void PGCommon::destoryCommands() {
+    if (mEventReaper) {
+        mEventReaper->exit();
+        mEventReaper.reset();
+    }
+
     delete mCmd;
     delete mCmdExtBuffer;
 
@@ -880,11 +903,31 @@ int PGCommon::iterate(CameraBufferMap& inBufs, CameraBufferMap& outBufs, ia_bina
                       const ia_binary_data* ipuParameters) {
     PERF_CAMERA_ATRACE();
 
+    int ret = prepareIteration(inBufs, outBufs, statistics, ipuParameters);
+    if (ret != OK) return ret;
+
+    ret = executeIteration();
+    if (ret != OK) return ret;
+
+    return finishIteration();
+}
+
+int PGCommon::prepareIteration(CameraBufferMap& inBufs, CameraBufferMap& outBufs,
+                               ia_binary_data* statistics, const ia_binary_data* ipuParameters) {
+    PERF_CAMERA_ATRACE();
+
     int64_t sequence = 0;
     if (!inBufs.empty()) {
         sequence = inBufs.begin()->second->getSequence();
     }
     LOG2("<id%d><seq%ld>%s:%s ++", mCameraId, sequence, getName(), __func__);
+    if (mCmdPending) {
+        // The previous iteration failed before finishIteration()
+        mCmdPending = false;
+        waitCmd(reinterpret_cast<uint64_t>(&mCmd));
+    }
+    mIterSequence = sequence;
+    mIterStatistics = statistics;
 
     int ret = prepareTerminalBuffers(ipuParameters, inBufs, outBufs, sequence);
     CheckAndLogError((ret != OK), ret, "%s, prepareTerminalBuffers fail with %d", getName(), ret);
@@ -915,9 +958,26 @@ int PGCommon::iterate(CameraBufferMap& inBufs, CameraBufferMap& outBufs, ia_bina
         mPPGStarted = true;
     }
 
-    ret = executePG();
+    return OK;
+}
+
+int PGCommon::executeIteration() {
+    // Only the reaper can wait for the command in another call
+    int ret = executePG(!mEventReaper);
     CheckAndLogError((ret != OK), ret, "%s, executePG fail", getName());
+    return OK;
+}
+
+int PGCommon::finishIteration() {
+    int64_t sequence = mIterSequence;
+    int ret = OK;
+    if (mCmdPending) {
+        mCmdPending = false;
+        ret = waitCmd(reinterpret_cast<uint64_t>(&mCmd));
+        CheckAndLogError((ret != OK), ret, "%s, executePG fail", getName());
+    }
 
+    ia_binary_data* statistics = mIterStatistics;
     if (statistics) {
         bool useCcaBuf = false;
         if (mIntelCca && !statistics->data) {
@@ -1077,6 +1137,8 @@ int PGCommon::allocateTnrSimBuffers() {
 int PGCommon::prepareTerminalBuffers(const ia_binary_data* ipuParameters,
                                      const CameraBufferMap& inBufs, const CameraBufferMap& outBufs,
                                      int64_t sequence) {
+    releaseFrameBuffers();
+
     CIPR::Buffer* ciprBuf = nullptr;
     // Prepare payload
     for (int termIdx = 0; termIdx < mTerminalCount; termIdx++) {
@@ -1111,6 +1173,7 @@ int PGCommon::prepareTerminalBuffers(const ia_binary_data* ipuParameters,
             CheckAndLogError(!ciprBuf, NO_MEMORY,
                              "%s, register buffer size %d for terminal %d fail", __func__,
                              buffer->getBufferSize(), termIdx);
+            mFrameBuffers.push_back(ciprBuf);
             mTerminalBuffers[termIdx] = ciprBuf;
         }
     }
@@ -1124,6 +1187,16 @@ int PGCommon::prepareTerminalBuffers(const ia_binary_data* ipuParameters,
             std::swap(mTerminalBuffers[mTnrTerminalPair.inId],
                       mTerminalBuffers[mTnrTerminalPair.outId]);
         }
+        // Only the still stream flushes its tnr data buffers
+        if (mStreamId == STILL_STREAM_ID) {
+            for (int termIdx : {mTnrTerminalPair.inId, mTnrTerminalPair.outId}) {
+                if (mTerminalBuffers[termIdx]->isCpuDirty()) {
+                    mFlushCount++;
+                } else {
+                    mSkippedFlushCount++;
+                }
+            }
+        }
     }
 
     for (auto& pair : mDvsTerminalPairs) {
@@ -1157,6 +1230,13 @@ int PGCommon::prepareTerminalBuffers(const ia_binary_data* ipuParameters,
 }
 
 void PGCommon::postTerminalBuffersDone(int64_t sequence) {
+    releaseFrameBuffers();
+    // The tnr data buffers are clean after the flush, until the refer data is copied into them
+    if (!mTnrDataBuffers.empty()) {
+        mTerminalBuffers[mTnrTerminalPair.inId]->setCpuDirty(false);
+        mTerminalBuffers[mTnrTerminalPair.outId]->setCpuDirty(false);
+    }
+
     if (!mTnrDataBuffers.empty() && mShareReferIds[mTnrTerminalPair.inId]) {
         mShareReferPool->releaseBuffer(mShareReferIds[mTnrTerminalPair.inId],
                                        mTerminalBuffers[mTnrTerminalPair.inId],
@@ -1170,7 +1250,7 @@ void PGCommon::postTerminalBuffersDone(int64_t sequence) {
     }
 }
 
-int PGCommon::executePG() {
+int PGCommon::executePG(bool waitLastCmd) {
     PERF_CAMERA_ATRACE();
     TRACE_LOG_PROCESS(mName.c_str(), __func__);
     CheckAndLogError((!mCmd), INVALID_OPERATION, "%s, Command is invalid.", __func__);
@@ -1201,8 +1281,10 @@ int PGCommon::executePG() {
         ret = ia_css_process_group_set_fragment_limit(mProcessGroup, (uint16_t)(fragIdx + 1));
         CheckAndLogError((ret != OK), ret, "%s, set fragment limit %d fail", getName(), fragIdx);
 
-        ret = handleCmd(&mCmd, &mCmdCfg);
+        bool wait = waitLastCmd || fragIdx < mFragmentCount - 1;
+        ret = handleCmd(&mCmd, &mCmdCfg, wait);
         CheckAndLogError((ret != OK), ret, "%s, call handleCmd fail", getName());
+        if (!wait) mCmdPending = true;
     }
 
     return OK;
@@ -1249,11 +1331,8 @@ int PGCommon::stopPPG() {
     return ret;
 }
 
-int PGCommon::handleCmd(CIPR::Command** cmd, CIPR::PSysCommandConfig* cmdCfg) {
-    CIPR::PSysEventConfig eventCfg = {};
-    mEvent->getConfig(&eventCfg);
+int PGCommon::handleCmd(CIPR::Command** cmd, CIPR::PSysCommandConfig* cmdCfg, bool wait) {
     cmdCfg->issueID = reinterpret_cast<uint64_t>(cmd);
-    eventCfg.commandIssueID = cmdCfg->issueID;
 
     LOG3("<id%d>@%s", mCameraId, __func__);
 
@@ -1265,15 +1344,26 @@ int PGCommon::handleCmd(CIPR::Command** cmd, CIPR::PSysCommandConfig* cmdCfg) {
     CheckAndLogError((ret != CIPR::Result::OK), UNKNOWN_ERROR,
                      "%s, call CIPR::Command::getConfig fail", __func__);
 
+    if (mEventReaper) mEventReaper->addCommand(cmdCfg->issueID);
     ret = (*cmd)->enqueue(mCtx);
-    CheckAndLogError((ret != CIPR::Result::OK), UNKNOWN_ERROR,
-                     "%s, call Context::enqueueCommand() fail %d", __func__, ret);
+    if (ret != CIPR::Result::OK) {
+        LOGE("%s, call Context::enqueueCommand() fail %d", __func__, ret);
+        if (mEventReaper) mEventReaper->finishCommand(cmdCfg->issueID, static_cast<int>(ret));
+        return UNKNOWN_ERROR;
+    }
+
+    return wait ? waitCmd(cmdCfg->issueID) : OK;
+}
+
+int PGCommon::waitCmd(uint64_t issueId) {
+    if (mEventReaper) return mEventReaper->waitCommand(issueId);
 
     // Wait event
-    ret = mEvent->wait(mCtx);
+    CIPR::Result ret = mEvent->wait(mCtx);
     CheckAndLogError((ret != CIPR::Result::OK), UNKNOWN_ERROR,
                      "%s, call Context::waitForEvent fail, ret: %d", __func__, ret);
 
+    CIPR::PSysEventConfig eventCfg = {};
     ret = mEvent->getConfig(&eventCfg);
     CheckAndLogError((ret != CIPR::Result::OK), UNKNOWN_ERROR,
                      "%s, call Event::getConfig() fail, ret: %d", __func__, ret);
@@ -1440,65 +1530,22 @@ int PGCommon::getCiprBufferSize(CIPR::Buffer* buffer) {
 }
 
 CIPR::Buffer* PGCommon::registerUserBuffer(int size, void* ptr, bool flush) {
-    CheckAndLogError((size <= 0 || ptr == nullptr), nullptr, "Invalid parameter: size=%d, ptr=%p",
-                     size, ptr);
-
-    for (auto it = mBuffers.begin(); it != mBuffers.end(); ++it) {
-        if (ptr == it->userPtr) {
-            if (size == getCiprBufferSize(it->ciprBuf)) {
-                return it->ciprBuf;
-            }
-
-            LOG2("%s, the buffer size is changed: old(%d), new(%d) addr(%p)", __func__,
-                 getCiprBufferSize(it->ciprBuf), size, it->userPtr);
-            delete it->ciprBuf;
-            it->ciprBuf = nullptr;
-            it->userPtr = nullptr;
-            mBuffers.erase(it);
-            break;
-        }
-    }
-
-    CIPR::Buffer* ciprBuf = createUserPtrCiprBuffer(size, ptr, flush);
-    CheckAndLogError(!ciprBuf, nullptr, "Create cipr buffer for %p failed", ptr);
-
-    CiprBufferMapping bufMap;
-    bufMap.userPtr = ptr;
-    bufMap.ciprBuf = ciprBuf;
-    mBuffers.push_back(bufMap);
-
-    return ciprBuf;
+    return mBufferRegistry->acquire(mCtx, ptr, size, [&]() {
+        return createUserPtrCiprBuffer(size, ptr, flush);
+    });
 }
 
 CIPR::Buffer* PGCommon::registerUserBuffer(int size, int fd, bool flush) {
-    CheckAndLogError((size <= 0 || fd < 0), nullptr, "Invalid parameter: size: %d, fd: %d", size,
-                     fd);
-
-    for (auto it = mBuffers.begin(); it != mBuffers.end(); ++it) {
-        if (fd == it->userFd) {
-            if (size == getCiprBufferSize(it->ciprBuf)) {
-                return it->ciprBuf;
-            }
+    return mBufferRegistry->acquire(mCtx, fd, size, [&]() {
+        return createDMACiprBuffer(size, fd, flush);
+    });
+}
 
-            LOG2("%s, the buffer size is changed: old(%d), new(%d) fd(%d)", __func__,
-                 getCiprBufferSize(it->ciprBuf), size, it->userFd);
-            delete it->ciprBuf;
-            it->ciprBuf = nullptr;
-            it->userFd = -1;
-            mBuffers.erase(it);
-            break;
-        }
+void PGCommon::releaseFrameBuffers() {
+    for (auto buffer : mFrameBuffers) {
+        mBufferRegistry->release(buffer);
     }
-
-    CIPR::Buffer* ciprBuf = createDMACiprBuffer(size, fd, flush);
-    CheckAndLogError(!ciprBuf, nullptr, "Create cipr buffer for fd %d failed", fd);
-
-    CiprBufferMapping bufMap;
-    bufMap.userFd = fd;
-    bufMap.ciprBuf = ciprBuf;
-    mBuffers.push_back(bufMap);
-
-    return ciprBuf;
+    mFrameBuffers.clear();
 }
 
 void PGCommon::dumpTerminalPyldAndDesc(int pgId, int64_t sequence,
@@ -1558,4 +1605,103 @@ void PGCommon::dumpTerminalPyldAndDesc(int pgId, int64_t sequence,
     fclose(fp);
 }
 
+PGCommon::EventReaper::EventReaper(CIPR::Context* ctx, int timeout)
+        : mCtx(ctx),
+          mRunningCount(0),
+          mExiting(false) {
+    CIPR::PSysEventConfig eventCfg = {};
+    eventCfg.timeout = timeout;
+    mEvent = new CIPR::Event(eventCfg);
+}
+
+PGCommon::EventReaper::~EventReaper() {
+    delete mEvent;
+}
+
+void PGCommon::EventReaper::addCommand(uint64_t issueId) {
+    AutoMutex l(mLock);
+    mCommands[issueId] = {false, 0};
+    mRunningCount++;
+    mCommandCondition.signal();
+}
+
+void PGCommon::EventReaper::finishCommand(uint64_t issueId, int error) {
+    AutoMutex l(mLock);
+    finishCommandLocked(issueId, error);
+    mDoneCondition.broadcast();
+}
+
+void PGCommon::EventReaper::finishCommandLocked(uint64_t issueId, int error) {
+    auto it = mCommands.find(issueId);
+    if (it == mCommands.end() || it->second.done) {
+        LOGW("%s, no running command for issue id 0x%lx", __func__, issueId);
+        return;
+    }
+    it->second = {true, error};
+    mRunningCount--;
+}
+
+int PGCommon::EventReaper::waitCommand(uint64_t issueId) {
+    ConditionLock lock(mLock);
+    auto it = mCommands.find(issueId);
+    CheckAndLogError(it == mCommands.end(), INVALID_OPERATION, "%s, unknown issue id 0x%lx",
+                     __func__, issueId);
+
+    while (!it->second.done && !mExiting) {
+        mDoneCondition.wait(lock);
+    }
+    int error = it->second.done ? it->second.error : -1;
+    mCommands.erase(it);
+
+    // Ignore the error in event config since it's not a fatal error.
+    if (error) {
+        LOGW("%s, event config error: %d", __func__, error);
+    }
+    return (error == 0) ? OK : UNKNOWN_ERROR;
+}
+
+void PGCommon::EventReaper::exit() {
+    requestExit();
+    {
+        AutoMutex l(mLock);
+        mExiting = true;
+        mCommandCondition.broadcast();
+        mDoneCondition.broadcast();
+    }
+    requestExitAndWait();
+}
+
+bool PGCommon::EventReaper::threadLoop() {
+    {
+        ConditionLock lock(mLock);
+        while (mRunningCount == 0 && !mExiting) {
+            mCommandCondition.wait(lock);
+        }
+        if (mExiting) return false;
+    }
+
+    // Only this thread dequeues the events, so mEvent isn't locked
+    CIPR::Result ret = mEvent->wait(mCtx);
+    CIPR::PSysEventConfig eventCfg = {};
+    if (ret == CIPR::Result::OK) {
+        ret = mEvent->getConfig(&eventCfg);
+    }
+
+    AutoMutex l(mLock);
+    if (ret != CIPR::Result::OK) {
+        LOGE("%s, call Context::waitForEvent fail, ret: %d", __func__, ret);
+        // The event is lost, fail all the running commands instead of blocking them
+        for (auto& cmd : mCommands) {
+            if (cmd.second.done) continue;
+            cmd.second = {true, -1};
+        }
+        mRunningCount = 0;
+    } else {
+        finishCommandLocked(eventCfg.commandIssueID, static_cast<int>(eventCfg.error));
+    }
+    mDoneCondition.broadcast();
+
+    return true;
+}
+
 }  // namespace icamera
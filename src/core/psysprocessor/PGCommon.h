@@ -28,6 +28,7 @@ extern "C" {
 #include <ia_css_terminal_types.h>
 }
 
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -39,9 +40,11 @@ extern "C" {
 #include "modules/algowrapper/IntelPGParam.h"
 #endif
 #include "BufferQueue.h"
+#include "CiprBufferRegistry.h"
 #include "IspParamAdaptor.h"
 #include "PGUtils.h"
 #include "ShareReferBufferPool.h"
+#include "iutils/Thread.h"
 #include "modules/ia_cipr/include/Buffer.h"
 #include "modules/ia_cipr/include/Command.h"
 #include "modules/ia_cipr/include/Context.h"
@@ -77,7 +80,12 @@ typedef std::map<ia_uid, std::shared_ptr<CameraBuffer>> CameraBufferMap;
  *          handleCmd();
  *          handleEvent();
  *          decode();
+ *    or prepareIteration(), executeIteration() and finishIteration() for the same steps.
  * 6. deInit();
+ *
+ * With the async submission, the PSYS events are dequeued by the EventReaper thread and
+ * routed to the waiting commands by issue id. executeIteration() returns once the last
+ * command is enqueued, so the executor can prepare the next PG while this one is running.
  */
 class PGCommon {
  public:
@@ -90,6 +98,9 @@ class PGCommon {
     void setShareReferPool(std::shared_ptr<ShareReferBufferPool> referPool) {
         mShareReferPool = referPool;
     }
+    void setBufferRegistry(std::shared_ptr<CiprBufferRegistry> registry) {
+        mBufferRegistry = registry;
+    }
 
     /**
      * allocate memory for some variables.
@@ -135,6 +146,22 @@ class PGCommon {
     virtual int iterate(CameraBufferMap& inBufs, CameraBufferMap& outBufs,
                         ia_binary_data* statistics, const ia_binary_data* ipuParameters);
 
+    /**
+     * run p2p to encode the params terminals, the PG isn't executed.
+     */
+    int prepareIteration(CameraBufferMap& inBufs, CameraBufferMap& outBufs,
+                         ia_binary_data* statistics, const ia_binary_data* ipuParameters);
+
+    /**
+     * execute the PG, the last command isn't waited for if the async submission is enabled.
+     */
+    int executeIteration();
+
+    /**
+     * wait for the PG execution and run p2p to decode the statistic terminals.
+     */
+    int finishIteration();
+
     const char* getName() { return mName.c_str(); }
 
  private:
@@ -167,10 +194,11 @@ class PGCommon {
     virtual int prepareTerminalBuffers(const ia_binary_data* ipuParameters,
                                        const CameraBufferMap& inBufs,
                                        const CameraBufferMap& outBufs, int64_t sequence);
-    int executePG();
+    int executePG(bool waitLastCmd = true);
     int startPPG();
     int stopPPG();
-    int handleCmd(CIPR::Command** cmd, CIPR::PSysCommandConfig* cmdCfg);
+    int handleCmd(CIPR::Command** cmd, CIPR::PSysCommandConfig* cmdCfg, bool wait = true);
+    int waitCmd(uint64_t issueId);
 
     void postTerminalBuffersDone(int64_t sequence);
 
@@ -180,6 +208,8 @@ class PGCommon {
     void* getCiprBufferPtr(CIPR::Buffer* buffer);
     CIPR::Buffer* registerUserBuffer(int size, void* ptr, bool flush = false);
     CIPR::Buffer* registerUserBuffer(int size, int fd, bool flush = false);
+    // Release the references of the data terminal buffers of the last frame
+    void releaseFrameBuffers();
     int getCiprBufferSize(CIPR::Buffer* buffer);
 
     void dumpTerminalPyldAndDesc(int pgId, int64_t sequence, ia_css_process_group_t* pgGroup);
@@ -187,12 +217,35 @@ class PGCommon {
  protected:
     enum PPGCommandType { PPG_CMD_TYPE_START = 0, PPG_CMD_TYPE_STOP, PPG_CMD_TYPE_COUNT };
 
-    struct CiprBufferMapping {
-        CiprBufferMapping() {}
-        void* userPtr = nullptr;
-        int userFd = -1;
-        CIPR::Buffer* baseCiprBuf = nullptr;
-        CIPR::Buffer* ciprBuf = nullptr;
+    class EventReaper : public Thread {
+     public:
+        EventReaper(CIPR::Context* ctx, int timeout);
+        ~EventReaper();
+
+        // Called before the command is enqueued, so its event can't be missed
+        void addCommand(uint64_t issueId);
+        void finishCommand(uint64_t issueId, int error);
+        int waitCommand(uint64_t issueId);
+        void exit();
+
+     private:
+        bool threadLoop() override;
+        void finishCommandLocked(uint64_t issueId, int error);
+
+        struct CommandState {
+            bool done;
+            int error;
+        };
+
+        CIPR::Context* mCtx;
+        CIPR::Event* mEvent;
+
+        Mutex mLock;  // protect mCommands, mRunningCount and mExiting
+        Condition mCommandCondition;
+        Condition mDoneCondition;
+        std::map<uint64_t, CommandState> mCommands;  // key: issue id
+        int mRunningCount;
+        bool mExiting;
     };
 
     static const int kEventTimeout = 8000;
@@ -240,6 +293,12 @@ class PGCommon {
 
     CIPR::PSysCommandConfig mCmdCfg;
     CIPR::Event* mEvent = nullptr;
+    std::unique_ptr<EventReaper> mEventReaper;
+    bool mCmdPending;  // the last command of executeIteration() isn't waited for
+
+    // The iteration between prepareIteration() and finishIteration()
+    int64_t mIterSequence;
+    ia_binary_data* mIterStatistics;
 
     CIPR::Buffer** mTerminalBuffers;
 
@@ -247,7 +306,11 @@ class PGCommon {
     int mInputMainTerminal;
     int mOutputMainTerminal;
 
-    std::vector<CiprBufferMapping> mBuffers;
+    std::shared_ptr<CiprBufferRegistry> mBufferRegistry;
+    std::vector<CIPR::Buffer*> mFrameBuffers;  // referenced by the data terminals of one frame
+    // The flushed and the skipped tnr data buffers, the clean ones aren't flushed
+    uint64_t mFlushCount;
+    uint64_t mSkippedFlushCount;
 
     TerminalPair mTnrTerminalPair;
     std::vector<uint8_t*> mTnrDataBuffers;
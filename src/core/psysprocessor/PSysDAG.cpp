@@ -36,6 +36,7 @@ PSysDAG::PSysDAG(int cameraId, CameraScheduler* scheduler, PSysDagCallback* psys
           mTuningMode(TUNING_MODE_MAX),
 #ifdef USE_PG_LITE_PIPE
           mShareReferPool(nullptr),
+          mBufferRegistry(std::make_shared<CiprBufferRegistry>(cameraId)),
 #endif
           mDefaultMainInputPort(MAIN_PORT),
           mVideoTnrExecutor(nullptr),
@@ -172,6 +173,7 @@ int PSysDAG::createPipeExecutors(bool useTnrOutBuffer) {
         executor->setNotifyPolicy(item.notifyPolicy);
 #ifdef USE_PG_LITE_PIPE
         executor->setShareReferPool(mShareReferPool);
+        executor->setBufferRegistry(mBufferRegistry);
 #endif
         int ret = executor->initPipe();
         if (ret != OK) {
@@ -580,6 +582,14 @@ int PSysDAG::stop() {
     for (auto& executors : mExecutorsPool) {
         executors->stop();
     }
+
+    // Drop the tasks of this session since the DAG may be started again
+    {
+        AutoMutex taskLock(mTaskLock);
+        mOngoingTasks.clear();
+    }
+    AutoMutex palLock(mOngoingPalMapLock);
+    mOngoingPalMap.clear();
     return OK;
 }
 
@@ -143,6 +143,7 @@ class PSysDAG {
     IspParamAdaptor* mIspParamAdaptor;
 #ifdef USE_PG_LITE_PIPE
     std::shared_ptr<ShareReferBufferPool> mShareReferPool;
+    std::shared_ptr<CiprBufferRegistry> mBufferRegistry;
 #endif
 
     std::map<Port, stream_t> mInputFrameInfo;
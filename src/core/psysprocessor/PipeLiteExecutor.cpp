@@ -61,6 +61,7 @@ PipeLiteExecutor::PipeLiteExecutor(int cameraId, const ExecutorPolicy& policy,
           mAdaptor(nullptr),
           mPolicyManager(nullptr),
           mShareReferPool(nullptr),
+          mBufferRegistry(nullptr),
           mLastStatsSequence(-1),
           mExclusivePGs(exclusivePGs),
           mPSysDag(psysDag),
@@ -226,6 +227,7 @@ int PipeLiteExecutor::createPGs() {
             new PGCommon(mCameraId, pgId, pgName, tuningMode, pgUnit.stageId + 1));
         // Please refer to ia_cipf_css.h for terminalBaseUid
         pgUnit.pg->setShareReferPool(mShareReferPool);
+        pgUnit.pg->setBufferRegistry(mBufferRegistry);
         mPGExecutors.push_back(pgUnit);
         int ret = pgUnit.pg->init();
         CheckAndLogError(ret != OK, UNKNOWN_ERROR, "create PG %d error", pgId);
@@ -537,7 +539,7 @@ bool PipeLiteExecutor::fetchBuffersInQueue(map<Port, shared_ptr<CameraBuffer>>&
                                            map<Port, shared_ptr<CameraBuffer>>& cOutBuffer) {
     for (auto& input : mInputQueue) {
         Port port = input.first;
-        CameraBufQ& inputQueue = input.second;
+        CameraBufRing& inputQueue = input.second;
         if (inputQueue.empty()) {
             LOG2("%s: No buffer input port %d", __func__, port);
             cInBuffer.clear();
@@ -548,7 +550,7 @@ bool PipeLiteExecutor::fetchBuffersInQueue(map<Port, shared_ptr<CameraBuffer>>&
 
     for (auto& output : mOutputQueue) {
         Port port = output.first;
-        CameraBufQ& outputQueue = output.second;
+        CameraBufRing& outputQueue = output.second;
         if (outputQueue.empty()) {
             LOG2("%s: No buffer output port %d", __func__, port);
             cInBuffer.clear();
@@ -800,25 +802,49 @@ int PipeLiteExecutor::runPipe(map<Port, shared_ptr<CameraBuffer>>& inBuffers,
         // Update sequence only for the 1st input buffer currently
         unit.inputBuffers.begin()->second->setSequence(sequence);
         // Currently PG handles one stats buffer only
-        ret = unit.pg->iterate(unit.inputBuffers, unit.outputBuffers,
-                               pgStatsDatas.empty() ? nullptr : pgStatsDatas[0], ipuParameters);
+        // The parameters of this PG are encoded while the previous one is running
+        ret = unit.pg->prepareIteration(unit.inputBuffers, unit.outputBuffers,
+                                        pgStatsDatas.empty() ? nullptr : pgStatsDatas[0],
+                                        ipuParameters);
         CheckAndLogError((ret != OK), ret, "%s: pipe iteration error %d", mName.c_str(), ret);
 
-        if (CameraDump::isDumpTypeEnable(DUMP_PSYS_INTERM_BUFFER)) {
-            for (auto& item : unit.outputBuffers) {
-                char desc[MAX_NAME_LEN] = {'\0'};
-                snprintf(desc, (MAX_NAME_LEN - 1), "-%s-%d-%ld", unit.pg->getName(),
-                         item.first - unit.stageId - 1, sequence);
-                CameraDump::dumpImage(mCameraId, item.second, M_NA, INVALID_PORT, desc);
-            }
+        if (pgIndex > 0) {
+            ret = finishPGIteration(pgIndex - 1, sequence, outStatsBuffers, &statTotalNum);
+            CheckAndLogError((ret != OK), ret, "%s: pipe iteration error %d", mName.c_str(), ret);
         }
-        statTotalNum += statsCount;
-        if (sisCount > 0) {
-            // Currently handle one sis output only
-            handleSisStats(unit.outputBuffers, outStatsBuffers[statTotalNum]);
+
+        ret = unit.pg->executeIteration();
+        CheckAndLogError((ret != OK), ret, "%s: pipe iteration error %d", mName.c_str(), ret);
+    }
+
+    ret = finishPGIteration(mPGExecutors.size() - 1, sequence, outStatsBuffers, &statTotalNum);
+    CheckAndLogError((ret != OK), ret, "%s: pipe iteration error %d", mName.c_str(), ret);
+
+    return OK;
+}
+
+int PipeLiteExecutor::finishPGIteration(unsigned int pgIndex, int64_t sequence,
+                                        const vector<shared_ptr<CameraBuffer>>& outStatsBuffers,
+                                        int* statTotalNum) {
+    ExecutorUnit& unit = mPGExecutors[pgIndex];
+    int ret = unit.pg->finishIteration();
+    CheckAndLogError((ret != OK), ret, "%s: finish iteration error %d", unit.pg->getName(), ret);
+
+    if (CameraDump::isDumpTypeEnable(DUMP_PSYS_INTERM_BUFFER)) {
+        for (auto& item : unit.outputBuffers) {
+            char desc[MAX_NAME_LEN] = {'\0'};
+            snprintf(desc, (MAX_NAME_LEN - 1), "-%s-%d-%ld", unit.pg->getName(),
+                     item.first - unit.stageId - 1, sequence);
+            CameraDump::dumpImage(mCameraId, item.second, M_NA, INVALID_PORT, desc);
         }
-        statTotalNum += sisCount;
     }
+    *statTotalNum += unit.statKernelUids.size();
+    unsigned int sisCount = unit.sisKernelUids.size();
+    if (sisCount > 0) {
+        // Currently handle one sis output only
+        handleSisStats(unit.outputBuffers, outStatsBuffers[*statTotalNum]);
+    }
+    *statTotalNum += sisCount;
 
     return OK;
 }
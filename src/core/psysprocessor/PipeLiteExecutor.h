@@ -24,6 +24,7 @@
 
 #include "BufferQueue.h"
 #include "CameraBuffer.h"
+#include "CiprBufferRegistry.h"
 #include "GraphConfig.h"
 #include "IspParamAdaptor.h"
 #include "Parameters.h"
@@ -61,6 +62,9 @@ class PipeLiteExecutor : public BufferQueue, public ISchedulerNode {
     void setShareReferPool(std::shared_ptr<ShareReferBufferPool> referPool) {
         mShareReferPool = referPool;
     }
+    void setBufferRegistry(std::shared_ptr<CiprBufferRegistry> registry) {
+        mBufferRegistry = registry;
+    }
 
     void getOutputTerminalPorts(std::map<ia_uid, Port>& outputTerminals) const;
     void getInputTerminalPorts(std::map<ia_uid, Port>& terminals) const;
@@ -172,6 +176,10 @@ class PipeLiteExecutor : public BufferQueue, public ISchedulerNode {
 
     int handleSisStats(std::map<ia_uid, std::shared_ptr<CameraBuffer>>& frameBuffers,
                        const std::shared_ptr<CameraBuffer>& outStatsBuffers);
+    // Wait for the PG and handle its outputs, statTotalNum is the stats index of the PG
+    int finishPGIteration(unsigned int pgIndex, int64_t sequence,
+                          const std::vector<std::shared_ptr<CameraBuffer>>& outStatsBuffers,
+                          int* statTotalNum);
 
  protected:
     int mCameraId;
@@ -189,6 +197,7 @@ class PipeLiteExecutor : public BufferQueue, public ISchedulerNode {
 
     PolicyManager* mPolicyManager;
     std::shared_ptr<ShareReferBufferPool> mShareReferPool;
+    std::shared_ptr<CiprBufferRegistry> mBufferRegistry;  // Shared by all the PGs of the camera
 
     // For internal connections (between PGs)
     std::map<ia_uid, std::shared_ptr<CameraBuffer>> mPGBuffers;  // Buffers between PGs
@@ -198,6 +198,7 @@ int32_t ShareReferBufferPool::acquireBuffer(int64_t id, CIPR::Buffer** referIn,
         (*referIn)->getMemorySize(&dstSize);
         if (srcPtr && dstPtr) {
             MEMCPY_S(dstPtr, dstSize, srcPtr, srcSize);
+            (*referIn)->setCpuDirty(true);
         }
         LOG1("%s acquire in seq %ld (copy from %s), out seq %ld", pair->consumerPgName.c_str(),
              inSequence, pair->producerPgName.c_str(), outSequence);
@@ -26,7 +26,9 @@
 // FRAME_SYNC_S
 #include "SyncManager.h"
 // FRAME_SYNC_E
+#include "V4l2EventReactor.h"
 #include "iutils/CameraLog.h"
+#include "iutils/ThreadPool.h"
 
 namespace icamera {
 
@@ -110,6 +112,10 @@ int CameraHal::deinit() {
     // Release it when the last device exit
     SyncManager::releaseInstance();
     // FRAME_SYNC_E
+    // All the devices are closed, so no handler is left in the reactor
+    V4l2EventReactor::releaseInstance();
+    // No frame is processed any more, so the pool workers can exit before the library unloads
+    ThreadPool::releaseInstance();
     // Release the PlatformData instance here due to it was
     // created in init() period
     PlatformData::releaseInstance();
@@ -25,12 +25,15 @@ namespace icamera {
 
 class IImageProcessor {
  public:
-    IImageProcessor(){};
+    IImageProcessor() : mParallelism(1){};
     virtual ~IImageProcessor(){};
 
     static std::unique_ptr<IImageProcessor> createImageProcessor();
     static bool isProcessingTypeSupported(PostProcessType type);
 
+    // The max thread number of ThreadPool used by one frame, 0 means all the pool workers
+    void setParallelism(int parallelism) { mParallelism = parallelism; }
+
     virtual status_t cropFrame(const std::shared_ptr<camera3::Camera3Buffer>& input,
                                std::shared_ptr<camera3::Camera3Buffer>& output) = 0;
     virtual status_t scaleFrame(const std::shared_ptr<camera3::Camera3Buffer>& input,
@@ -41,6 +44,9 @@ class IImageProcessor {
     virtual status_t convertFrame(const std::shared_ptr<camera3::Camera3Buffer>& input,
                                   std::shared_ptr<camera3::Camera3Buffer>& output) = 0;
 
+ protected:
+    int mParallelism;
+
  private:
     DISALLOW_COPY_AND_ASSIGN(IImageProcessor);
 };
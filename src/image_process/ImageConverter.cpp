@@ -19,10 +19,14 @@
 #include <sys/types.h>
 #include <linux/videodev2.h>
 
+#include <vector>
+
 #include "iutils/CameraLog.h"
 #include "iutils/Utils.h"
 #include "iutils/Errors.h"
+#include "iutils/ThreadPool.h"
 #include "ImageConverter.h"
+#include "SimdKernels.h"
 
 namespace icamera {
 namespace ImageConverter {
@@ -173,7 +177,11 @@ void convertYV12ToNV21(int width, int height, int srcStride, int dstStride, void
         unsigned char* pDstVU = dstPtr;
         unsigned char* pSrcV = srcPtrV;
         unsigned char* pSrcU = srcPtrU;
-        for (int j = 0; j < whalf; ++j) {
+        int j = SimdKernels::interleaveRow(pDstVU, pSrcV, pSrcU, whalf);
+        pDstVU += j * 2;
+        pSrcV += j;
+        pSrcU += j;
+        for (; j < whalf; ++j) {
             *pDstVU++ = *pSrcV++;
             *pDstVU++ = *pSrcU++;
         }
@@ -222,111 +230,49 @@ void copyYV12ToYV12(int width, int height, int srcStride, int dstStride, void* s
     }
 }
 
-// covert NV12 (Y plane, interlaced UV bytes) to
-// NV21 (Y plane, interlaced VU bytes) and trim stride width to real width
-void trimConvertNV12ToNV21(int width, int height, int srcStride, void* src, void* dst) {
-    const int ysize = width * height;
-    unsigned const char* pSrc = (unsigned char*)src;
-    unsigned char* pDst = (unsigned char*)dst;
+// covert the lines [start, end) of NV12 (Y plane, interlaced UV bytes) to
+// NV21 (Y plane, interlaced VU bytes) and trim stride width to real width, start is even
+static void convertNV12ToNV21Rows(int width, int height, int srcStride, const unsigned char* src,
+                                  unsigned char* dst, int start, int end) {
+    const unsigned char* pSrc = src + srcStride * start;
+    unsigned char* pDst = dst + width * start;
 
     // Copy Y component
     if (srcStride == width) {
-        MEMCPY_S(pDst, ysize, pSrc, ysize);
-    } else if (srcStride > width) {
-        int j = height;
-        while (j--) {
+        MEMCPY_S(pDst, width * (end - start), pSrc, width * (end - start));
+    } else {
+        for (int j = start; j < end; j++) {
             MEMCPY_S(pDst, width, pSrc, width);
             pSrc += srcStride;
             pDst += width;
         }
-    } else {
-        ALOGE("bad stride value");
-        return;
     }
 
     // Convert UV to VU
-    pSrc = (unsigned char*)src + srcStride * height;
-    pDst = (unsigned char*)dst + width * height;
-    for (int j = 0; j < height / 2; j++) {
-        if (width >= 16) {
-            const uint32_t* ptr0 = (const uint32_t*)(pSrc);
-            uint32_t* ptr1 = (uint32_t*)(pDst);
-            int bNotLastLine = ((j + 1) == (height / 2)) ? 0 : 1;
-            int width_16 = (width + 15 * bNotLastLine) & ~0xf;
-            if ((((uint64_t)(pSrc)) & 0xf) == 0 &&
-                (((uint64_t)(pDst)) & 0xf) == 0) {  // 16 bytes aligned for both src and dest
-                __asm__ volatile("movl       %0,  %%eax      \n\t"
-                                 "movl       %1,  %%edx      \n\t"
-                                 "movl       %2,  %%ecx      \n\t"
-                                 "1:     \n\t"
-                                 "movdqa (%%eax), %%xmm1     \n\t"
-                                 "movdqa  %%xmm1, %%xmm0     \n\t"
-                                 "psllw       $8, %%xmm1     \n\t"
-                                 "psrlw       $8, %%xmm0     \n\t"
-                                 "por     %%xmm0, %%xmm1     \n\t"
-                                 "movdqa  %%xmm1, (%%edx)    \n\t"
-                                 "add        $16, %%eax      \n\t"
-                                 "add        $16, %%edx      \n\t"
-                                 "sub        $16, %%ecx      \n\t"
-                                 "jnz   1b \n\t"
-                                 : "+m"(ptr0), "+m"(ptr1), "+m"(width_16)
-                                 :
-                                 : "eax", "ecx", "edx", "xmm0", "xmm1");
-            } else {  // either src or dest is not 16-bytes aligned
-                __asm__ volatile("movl       %0,  %%eax      \n\t"
-                                 "movl       %1,  %%edx      \n\t"
-                                 "movl       %2,  %%ecx      \n\t"
-                                 "1:     \n\t"
-                                 "lddqu  (%%eax), %%xmm1     \n\t"
-                                 "movdqa  %%xmm1, %%xmm0     \n\t"
-                                 "psllw       $8, %%xmm1     \n\t"
-                                 "psrlw       $8, %%xmm0     \n\t"
-                                 "por     %%xmm0, %%xmm1     \n\t"
-                                 "movdqu  %%xmm1, (%%edx)    \n\t"
-                                 "add        $16, %%eax      \n\t"
-                                 "add        $16, %%edx      \n\t"
-                                 "sub        $16, %%ecx      \n\t"
-                                 "jnz   1b \n\t"
-                                 : "+m"(ptr0), "+m"(ptr1), "+m"(width_16)
-                                 :
-                                 : "eax", "ecx", "edx", "xmm0", "xmm1");
-            }
-
-            // process remaining data of less than 16 bytes of last row
-            for (int i = width_16; i < width; i += 2) {
-                pDst[i] = pSrc[i + 1];
-                pDst[i + 1] = pSrc[i];
-            }
-        } else if ((((uint64_t)(pSrc)) & 0x3) == 0 &&
-                   (((uint64_t)(pDst)) & 0x3) == 0) {  // 4 bytes aligned for both src and dest
-            const uint32_t* ptr0 = (const uint32_t*)(pSrc);
-            uint32_t* ptr1 = (uint32_t*)(pDst);
-            int width_4 = width & ~3;
-            for (int i = 0; i < width_4; i += 4) {
-                uint32_t data0 = *ptr0++;
-                uint32_t data1 = (data0 >> 8) & 0x00ff00ff;
-                uint32_t data2 = (data0 << 8) & 0xff00ff00;
-                *ptr1++ = data1 | data2;
-            }
-            // process remaining data of less than 4 bytes at end of each row
-            for (int i = width_4; i < width; i += 2) {
-                pDst[i] = pSrc[i + 1];
-                pDst[i + 1] = pSrc[i];
-            }
-        } else {
-            unsigned const char* ptr0 = pSrc;
-            unsigned char* ptr1 = pDst;
-            for (int i = 0; i < width; i += 2) {
-                *ptr1++ = ptr0[1];
-                *ptr1++ = ptr0[0];
-                ptr0 += 2;
-            }
+    pSrc = src + srcStride * height + srcStride * (start / 2);
+    pDst = dst + width * height + width * (start / 2);
+    for (int j = start / 2; j < end / 2; j++) {
+        int i = SimdKernels::swapBytePairsRow(pDst, pSrc, width);
+        for (; i < width; i += 2) {
+            pDst[i] = pSrc[i + 1];
+            pDst[i + 1] = pSrc[i];
         }
         pDst += width;
         pSrc += srcStride;
     }
 }
 
+// covert NV12 (Y plane, interlaced UV bytes) to
+// NV21 (Y plane, interlaced VU bytes) and trim stride width to real width
+void trimConvertNV12ToNV21(int width, int height, int srcStride, void* src, void* dst) {
+    if (srcStride < width) {
+        ALOGE("bad stride value");
+        return;
+    }
+    convertNV12ToNV21Rows(width, height, srcStride, (const unsigned char*)src,
+                          (unsigned char*)dst, 0, height);
+}
+
 // convert NV12 (Y plane, interlaced UV bytes) to YV12 (Y plane, V plane, U plane)
 // without Y and C 16 bytes aligned
 void convertNV12ToYV12(int width, int height, int srcStride, void* src, void* dst) {
@@ -359,7 +305,8 @@ void convertNV12ToYV12(int width, int height, int srcStride, void* src, void* ds
     int halfHeight = height / 2;
     int halfWidth = width / 2;
     for (int i = 0; i < halfHeight; ++i) {
-        for (int j = 0; j < halfWidth; ++j) {
+        int j = SimdKernels::deinterleaveRow(dstPtrU, dstPtrV, srcPtr, halfWidth);
+        for (; j < halfWidth; ++j) {
             dstPtrV[j] = srcPtr[j * 2 + 1];
             dstPtrU[j] = srcPtr[j * 2];
         }
@@ -369,37 +316,37 @@ void convertNV12ToYV12(int width, int height, int srcStride, void* src, void* ds
     }
 }
 
-// convert NV12 (Y plane, interlaced UV bytes) to YV12 (Y plane, V plane, U plane)
-// with Y and C 16 bytes aligned
-void align16ConvertNV12ToYV12(int width, int height, int srcStride, void* src, void* dst) {
+// convert the lines [start, end) of NV12 (Y plane, interlaced UV bytes) to
+// YV12 (Y plane, V plane, U plane) with Y and C 16 bytes aligned, start is even
+static void align16ConvertNV12ToYV12Rows(int width, int height, int srcStride,
+                                         const unsigned char* src, unsigned char* dst, int start,
+                                         int end) {
     int yStride = ALIGN_16(width);
     size_t ySize = yStride * height;
     int cStride = ALIGN_16(yStride / 2);
     size_t cSize = cStride * height / 2;
 
-    unsigned char* srcPtr = (unsigned char*)src;
-    unsigned char* dstPtr = (unsigned char*)dst;
-    unsigned char* dstPtrV = (unsigned char*)dst + ySize;
-    unsigned char* dstPtrU = (unsigned char*)dst + ySize + cSize;
+    const unsigned char* srcPtr = src + srcStride * start;
+    unsigned char* dstPtr = dst + yStride * start;
+    unsigned char* dstPtrV = dst + ySize + cStride * (start / 2);
+    unsigned char* dstPtrU = dst + ySize + cSize + cStride * (start / 2);
 
-    // copy the entire Y plane
+    // copy the Y lines
     if (srcStride == yStride) {
-        MEMCPY_S(dstPtr, ySize, srcPtr, ySize);
-        srcPtr += ySize;
-    } else if (srcStride > width) {
-        for (int i = 0; i < height; i++) {
+        MEMCPY_S(dstPtr, yStride * (end - start), srcPtr, yStride * (end - start));
+    } else {
+        for (int i = start; i < end; i++) {
             MEMCPY_S(dstPtr, width, srcPtr, width);
             srcPtr += srcStride;
             dstPtr += yStride;
         }
-    } else {
-        ALOGE("bad src stride value");
-        return;
     }
 
     // deinterlace the UV data
-    for (int i = 0; i < height / 2; ++i) {
-        for (int j = 0; j < width / 2; ++j) {
+    srcPtr = src + srcStride * height + srcStride * (start / 2);
+    for (int i = start / 2; i < end / 2; ++i) {
+        int j = SimdKernels::deinterleaveRow(dstPtrU, dstPtrV, srcPtr, width / 2);
+        for (; j < width / 2; ++j) {
             dstPtrV[j] = srcPtr[j * 2 + 1];
             dstPtrU[j] = srcPtr[j * 2];
         }
@@ -409,6 +356,17 @@ void align16ConvertNV12ToYV12(int width, int height, int srcStride, void* src, v
     }
 }
 
+// convert NV12 (Y plane, interlaced UV bytes) to YV12 (Y plane, V plane, U plane)
+// with Y and C 16 bytes aligned
+void align16ConvertNV12ToYV12(int width, int height, int srcStride, void* src, void* dst) {
+    if (srcStride < width) {
+        ALOGE("bad src stride value");
+        return;
+    }
+    align16ConvertNV12ToYV12Rows(width, height, srcStride, (const unsigned char*)src,
+                                 (unsigned char*)dst, 0, height);
+}
+
 // P411's Y, U, V are seperated. But the YUY2's Y, U and V are interleaved.
 void YUY2ToP411(int width, int height, int stride, void* src, void* dst) {
     int ySize = width * height;
@@ -639,6 +597,13 @@ void repadYUV420(int width, int height, int srcStride, int dstStride, void* src,
     }
 }
 
+// The scratch line of the calling thread, it's reallocated only for a wider frame
+static unsigned char* getScratchLine(int width) {
+    static thread_local std::vector<unsigned char> sLine;
+    if (sLine.size() < static_cast<size_t>(width)) sLine.resize(width);
+    return sLine.data();
+}
+
 // covert YUYV(YUY2, YUV422 format) to YV12 (Y plane, V plane, U plane)
 void convertYUYVToYV12(int width, int height, int srcStride, int dstStride, void* src, void* dst) {
     int ySize = width * height;
@@ -649,23 +614,29 @@ void convertYUYVToYV12(int width, int height, int srcStride, int dstStride, void
     unsigned char* dstPtr = (unsigned char*)dst;
     unsigned char* dstPtrV = (unsigned char*)dst + ySize;
     unsigned char* dstPtrU = (unsigned char*)dst + ySize + cSize;
+    // The interlaced UV bytes of one line
+    unsigned char* uvLine = getScratchLine(width);
 
     for (int i = 0; i < height; i++) {
         // The first line of the source
         // Copy first Y Plane first
-        for (int j = 0; j < width; j++) {
+        int j = SimdKernels::deinterleaveRow(dstPtr, uvLine, srcPtr, width);
+        for (; j < width; j++) {
             dstPtr[j] = srcPtr[j * 2];
+            uvLine[j] = srcPtr[j * 2 + 1];
         }
 
         if (i & 1) {
             // Copy the V plane
-            for (int k = 0; k < wHalf; k++) {
+            int k = SimdKernels::deinterleaveRow(nullptr, dstPtrV, uvLine, wHalf);
+            for (; k < wHalf; k++) {
                 dstPtrV[k] = srcPtr[k * 4 + 3];
             }
             dstPtrV = dstPtrV + ALIGN_16(dstStride >> 1);
         } else {
             // Copy the U plane
-            for (int k = 0; k < wHalf; k++) {
+            int k = SimdKernels::deinterleaveRow(dstPtrU, nullptr, uvLine, wHalf);
+            for (; k < wHalf; k++) {
                 dstPtrU[k] = srcPtr[k * 4 + 1];
             }
             dstPtrU = dstPtrU + ALIGN_16(dstStride >> 1);
@@ -679,27 +650,28 @@ void convertYUYVToYV12(int width, int height, int srcStride, int dstStride, void
 // covert YUYV(YUY2, YUV422 format) to NV21 (Y plane, interlaced VU bytes)
 void convertYUYVToNV21(int width, int height, int srcStride, void* src, void* dst) {
     int ySize = width * height;
-    int u_counter = 1, v_counter = 0;
 
     unsigned char* srcPtr = (unsigned char*)src;
     unsigned char* dstPtr = (unsigned char*)dst;
-    unsigned char* dstPtrUV = (unsigned char*)dst + ySize;
+    unsigned char* dstPtrVU = (unsigned char*)dst + ySize;
+    // The interlaced UV bytes of one line
+    unsigned char* uvLine = getScratchLine(width);
 
     for (int i = 0; i < height; i++) {
-        // The first line of the source
-        // Copy first Y Plane first
-        for (int j = 0; j < width * 2; j++) {
-            if (j % 2 == 0) dstPtr[j / 2] = srcPtr[j];
-            if (i % 2) {
-                if ((j % 4) == 3) {
-                    dstPtrUV[v_counter] = srcPtr[j];  // V plane
-                    v_counter += 2;
-                }
-                if ((j % 4) == 1) {
-                    dstPtrUV[u_counter] = srcPtr[j];  // U plane
-                    u_counter += 2;
-                }
+        // Copy Y plane, the UV of the odd lines are used
+        int j = SimdKernels::deinterleaveRow(dstPtr, uvLine, srcPtr, width);
+        for (; j < width; j++) {
+            dstPtr[j] = srcPtr[j * 2];
+            uvLine[j] = srcPtr[j * 2 + 1];
+        }
+
+        if (i % 2) {
+            int k = SimdKernels::swapBytePairsRow(dstPtrVU, uvLine, width);
+            for (; k + 1 < width; k += 2) {
+                dstPtrVU[k] = uvLine[k + 1];  // V plane
+                dstPtrVU[k + 1] = uvLine[k];  // U plane
             }
+            dstPtrVU += width;
         }
 
         srcPtr = srcPtr + srcStride * 2;
@@ -707,83 +679,206 @@ void convertYUYVToNV21(int width, int height, int srcStride, void* src, void* ds
     }
 }
 
+// covert the lines [start, end) of NV12 to YUYV or UYVY, the UV line is shared by 2 lines
+static void convertNV12ToPackedYUV422(bool yuyv, int width, int height, int srcStride,
+                                      int dstStride, const unsigned char* src, unsigned char* dst,
+                                      int start, int end) {
+    const unsigned char* srcPtrY = src + srcStride * start;
+    const unsigned char* srcPtrUV = src + srcStride * height + srcStride * (start / 2);
+    unsigned char* dstPtr = dst + dstStride * 2 * start;
+    const int yOffset = yuyv ? 0 : 1;
+
+    for (int i = start; i < end; i++) {
+        // Y0 U0 Y1 V0: Y and the interlaced UV bytes are interlaced again
+        int j = yuyv ? SimdKernels::interleaveRow(dstPtr, srcPtrY, srcPtrUV, width)
+                     : SimdKernels::interleaveRow(dstPtr, srcPtrUV, srcPtrY, width);
+        for (; j < width; j++) {
+            dstPtr[j * 2 + yOffset] = srcPtrY[j];
+            dstPtr[j * 2 + 1 - yOffset] = srcPtrUV[j];
+        }
+        if (i % 2) srcPtrUV += srcStride;
+
+        srcPtrY += srcStride;
+        dstPtr += dstStride * 2;
+    }
+}
+
 void convertNV12ToYUYV(int srcWidth, int srcHeight, int srcStride, int dstStride, const void* src,
                        void* dst) {
-    int y_counter = 0, u_counter = 1, v_counter = 3, uv_counter = 0;
-    unsigned char* srcYPtr = (unsigned char*)src;
-    unsigned char* srcUVPtr = (unsigned char*)src + srcWidth * srcHeight;
-    unsigned char* dstPtr = (unsigned char*)dst;
+    convertNV12ToPackedYUV422(true, srcWidth, srcHeight, srcStride, dstStride,
+                              (const unsigned char*)src, (unsigned char*)dst, 0, srcHeight);
+}
 
-    for (int i = 0; i < srcHeight; i++) {
-        for (int k = 0; k < srcWidth; k++) {
-            dstPtr[y_counter] = srcYPtr[k];
-            y_counter += 2;
-            dstPtr[u_counter] = srcUVPtr[uv_counter];
-            u_counter += 4;
-            dstPtr[v_counter] = srcUVPtr[uv_counter + 1];
-            v_counter += 4;
-            uv_counter += 2;
+// covert the lines [start, end) of YUYV or UYVY to NV12, the UV of the even lines are used
+static void convertPackedYUV422ToNV12(bool yuyv, int width, int height, int srcStride,
+                                      int dstStride, const unsigned char* src, unsigned char* dst,
+                                      int start, int end) {
+    const unsigned char* srcPtr = src + srcStride * 2 * start;
+    unsigned char* dstPtr = dst + dstStride * start;
+    unsigned char* dstPtrUV = dst + dstStride * height + dstStride * (start / 2);
+    const int yOffset = yuyv ? 0 : 1;
+
+    for (int i = start; i < end; i++) {
+        unsigned char* uv = (i % 2) ? nullptr : dstPtrUV;
+        int j = yuyv ? SimdKernels::deinterleaveRow(dstPtr, uv, srcPtr, width)
+                     : SimdKernels::deinterleaveRow(uv, dstPtr, srcPtr, width);
+        for (; j < width; j++) {
+            dstPtr[j] = srcPtr[j * 2 + yOffset];
+            if (uv) uv[j] = srcPtr[j * 2 + 1 - yOffset];
         }
-        if ((i % 2) == 0) {
-            srcUVPtr = srcUVPtr + srcStride;
+        if (uv) dstPtrUV += dstStride;
+
+        srcPtr += srcStride * 2;
+        dstPtr += dstStride;
+    }
+}
+
+// covert the lines [start, end) of YUYV to UYVY or UYVY to YUYV
+static void swapPackedYUV422(int width, int srcStride, int dstStride, const unsigned char* src,
+                             unsigned char* dst, int start, int end) {
+    src += srcStride * 2 * start;
+    dst += dstStride * 2 * start;
+    for (int i = start; i < end; i++) {
+        int j = SimdKernels::swapBytePairsRow(dst, src, width * 2);
+        for (; j < width * 2; j += 2) {
+            dst[j] = src[j + 1];
+            dst[j + 1] = src[j];
         }
+        src += srcStride * 2;
+        dst += dstStride * 2;
+    }
+}
+
+// The conversion table, all the functions take the stride of the first plane in pixels.
+// The ConvertRowsFunc ones convert the lines [start, end) only, so one image can be split
+// into bands of even lines and converted by several threads.
+typedef void (*ConvertFunc)(int width, int height, int srcStride, int dstStride, void* src,
+                            void* dst);
+typedef void (*ConvertRowsFunc)(int width, int height, int srcStride, int dstStride,
+                                const unsigned char* src, unsigned char* dst, int start, int end);
+
+struct ConvertEntry {
+    int srcFormat;
+    int dstFormat;
+    ConvertFunc convert;
+    ConvertRowsFunc convertRows;
+};
+
+static void yuyvToNV21(int width, int height, int srcStride, int dstStride, void* src,
+                       void* dst) {
+    convertYUYVToNV21(width, height, srcStride, src, dst);
+}
 
-        dstPtr = dstPtr + 2 * dstStride;
-        srcYPtr = srcYPtr + srcStride;
-        u_counter = 1;
-        v_counter = 3;
-        y_counter = 0;
-        uv_counter = 0;
+static void nv12ToYV12Rows(int width, int height, int srcStride, int dstStride,
+                           const unsigned char* src, unsigned char* dst, int start, int end) {
+    align16ConvertNV12ToYV12Rows(width, height, srcStride, src, dst, start, end);
+}
+
+static void nv12ToNV21Rows(int width, int height, int srcStride, int dstStride,
+                           const unsigned char* src, unsigned char* dst, int start, int end) {
+    convertNV12ToNV21Rows(width, height, srcStride, src, dst, start, end);
+}
+
+static void nv12ToYUYVRows(int width, int height, int srcStride, int dstStride,
+                           const unsigned char* src, unsigned char* dst, int start, int end) {
+    convertNV12ToPackedYUV422(true, width, height, srcStride, dstStride, src, dst, start, end);
+}
+
+static void nv12ToUYVYRows(int width, int height, int srcStride, int dstStride,
+                           const unsigned char* src, unsigned char* dst, int start, int end) {
+    convertNV12ToPackedYUV422(false, width, height, srcStride, dstStride, src, dst, start, end);
+}
+
+static void yuyvToNV12Rows(int width, int height, int srcStride, int dstStride,
+                           const unsigned char* src, unsigned char* dst, int start, int end) {
+    convertPackedYUV422ToNV12(true, width, height, srcStride, dstStride, src, dst, start, end);
+}
+
+static void uyvyToNV12Rows(int width, int height, int srcStride, int dstStride,
+                           const unsigned char* src, unsigned char* dst, int start, int end) {
+    convertPackedYUV422ToNV12(false, width, height, srcStride, dstStride, src, dst, start, end);
+}
+
+static void swapYUV422Rows(int width, int height, int srcStride, int dstStride,
+                           const unsigned char* src, unsigned char* dst, int start, int end) {
+    swapPackedYUV422(width, srcStride, dstStride, src, dst, start, end);
+}
+
+static const ConvertEntry gConvertTable[] = {
+    {V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_YVU420, nullptr, nv12ToYV12Rows},
+    {V4L2_PIX_FMT_YVU420, V4L2_PIX_FMT_YVU420, copyYV12ToYV12, nullptr},
+    {V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_YVU420, convertYUYVToYV12, nullptr},
+    {V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_NV21, nullptr, nv12ToNV21Rows},
+    {V4L2_PIX_FMT_YVU420, V4L2_PIX_FMT_NV21, convertYV12ToNV21, nullptr},
+    {V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_NV21, yuyvToNV21, nullptr},
+    {V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_YUYV, nullptr, nv12ToYUYVRows},
+    {V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_UYVY, nullptr, nv12ToUYVYRows},
+    {V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_NV12, nullptr, yuyvToNV12Rows},
+    {V4L2_PIX_FMT_UYVY, V4L2_PIX_FMT_NV12, nullptr, uyvyToNV12Rows},
+    {V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_UYVY, nullptr, swapYUV422Rows},
+    {V4L2_PIX_FMT_UYVY, V4L2_PIX_FMT_YUYV, nullptr, swapYUV422Rows},
+};
+
+static const ConvertEntry* findConvertEntry(int srcFormat, int dstFormat) {
+    for (size_t i = 0; i < ARRAY_SIZE(gConvertTable); i++) {
+        if (gConvertTable[i].srcFormat == srcFormat && gConvertTable[i].dstFormat == dstFormat) {
+            return &gConvertTable[i];
+        }
+    }
+    return nullptr;
+}
+
+bool isConversionSupported(int srcFormat, int dstFormat) {
+    return findConvertEntry(srcFormat, dstFormat) != nullptr;
+}
+
+int convertImage(int srcFormat, int dstFormat, int width, int height, int srcStride,
+                 int dstStride, void* src, void* dst, int parallelism) {
+    CheckAndLogError(!src || !dst, BAD_VALUE, "%s: invalid buffer src %p, dst %p", __func__, src,
+                     dst);
+    CheckAndLogError(srcStride < width, BAD_VALUE, "%s: bad src stride %d, width %d", __func__,
+                     srcStride, width);
+
+    const ConvertEntry* entry = findConvertEntry(srcFormat, dstFormat);
+    CheckAndLogError(!entry, BAD_VALUE, "%s: unsupported conversion %s -> %s", __func__,
+                     CameraUtils::format2string(srcFormat).c_str(),
+                     CameraUtils::format2string(dstFormat).c_str());
+
+    LOG2("%s: %s -> %s %dx%d, stride %d -> %d, parallelism %d", __func__,
+         CameraUtils::format2string(srcFormat).c_str(),
+         CameraUtils::format2string(dstFormat).c_str(), width, height, srcStride, dstStride,
+         parallelism);
+    if (!entry->convertRows) {
+        entry->convert(width, height, srcStride, dstStride, src, dst);
+        return OK;
     }
+
+    const unsigned char* srcPtr = static_cast<const unsigned char*>(src);
+    unsigned char* dstPtr = static_cast<unsigned char*>(dst);
+    // The bands start at even lines, so the UV lines of YUV420 aren't shared by bands
+    ThreadPool::forEachBand(height, parallelism, 2, [&](int start, int end) {
+        entry->convertRows(width, height, srcStride, dstStride, srcPtr, dstPtr, start, end);
+    });
+    return OK;
 }
 
 void convertBuftoYV12(int format, int width, int height, int srcStride, int dstStride, void* src,
                       void* dst, bool align16) {
-    switch (format) {
-        case V4L2_PIX_FMT_NV12:
-            align16 ? align16ConvertNV12ToYV12(width, height, srcStride, src, dst) :
-                      convertNV12ToYV12(width, height, srcStride, src, dst);
-            break;
-        case V4L2_PIX_FMT_YVU420:
-            copyYV12ToYV12(width, height, srcStride, dstStride, src, dst);
-            break;
-        case V4L2_PIX_FMT_YUYV:
-            convertYUYVToYV12(width, height, srcStride, dstStride, src, dst);
-            break;
-        default:
-            ALOGE("%s: unsupported format %d", __func__, format);
-            break;
+    if (format == V4L2_PIX_FMT_NV12 && !align16) {
+        convertNV12ToYV12(width, height, srcStride, src, dst);
+        return;
     }
+    convertImage(format, V4L2_PIX_FMT_YVU420, width, height, srcStride, dstStride, src, dst);
 }
 
 void convertBuftoNV21(int format, int width, int height, int srcStride, int dstStride, void* src,
                       void* dst) {
-    switch (format) {
-        case V4L2_PIX_FMT_NV12:
-            trimConvertNV12ToNV21(width, height, srcStride, src, dst);
-            break;
-        case V4L2_PIX_FMT_YVU420:
-            convertYV12ToNV21(width, height, srcStride, dstStride, src, dst);
-            break;
-        case V4L2_PIX_FMT_YUYV:
-            convertYUYVToNV21(width, height, srcStride, src, dst);
-            break;
-        default:
-            ALOGE("%s: unsupported format %d", __func__, format);
-            break;
-    }
+    convertImage(format, V4L2_PIX_FMT_NV21, width, height, srcStride, dstStride, src, dst);
 }
 
 void convertBuftoYUYV(int format, int width, int height, int srcStride, int dstStride, void* src,
                       void* dst) {
-    switch (format) {
-        case V4L2_PIX_FMT_NV12:
-            convertNV12ToYUYV(width, height, srcStride, dstStride, src, dst);
-            break;
-        default:
-            LOGE("%s: unsupported format %d", __func__, format);
-            break;
-    }
+    convertImage(format, V4L2_PIX_FMT_YUYV, width, height, srcStride, dstStride, src, dst);
 }
 }  // namespace ImageConverter
 }  // namespace icamera
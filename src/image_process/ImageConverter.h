@@ -45,6 +45,23 @@ void convertYUYVToNV21(int width, int height, int srcStride, void* src, void* ds
 void convertNV12ToYUYV(int srcWidth, int srcHeight, int srcStride, int dstStride, const void* src,
                        void* dst);
 
+/**
+ * \brief Check if convertImage supports the conversion from srcFormat to dstFormat.
+ */
+bool isConversionSupported(int srcFormat, int dstFormat);
+
+/**
+ * \brief Convert the image by the (srcFormat, dstFormat) conversion table.
+ *
+ * The strides are the ones of the first plane, in pixels. The image is split into row
+ * bands and converted by ThreadPool if the conversion supports it, parallelism is the
+ * max thread number, 0 means using all the pool workers.
+ *
+ * \return OK if succeeded, BAD_VALUE if the conversion isn't supported.
+ */
+int convertImage(int srcFormat, int dstFormat, int width, int height, int srcStride,
+                 int dstStride, void* src, void* dst, int parallelism = 1);
+
 void convertBuftoYV12(int format, int width, int height, int srcStride, int dstStride, void* src,
                       void* dst, bool align16 = true);
 void convertBuftoNV21(int format, int width, int height, int srcStride, int dstStride, void* src,
@@ -21,7 +21,9 @@
 #include "iutils/Errors.h"
 #include "iutils/Utils.h"
 #include "iutils/CameraLog.h"
+#include "iutils/ThreadPool.h"
 #include "ImageScalerCore.h"
+#include "SimdKernels.h"
 
 #define RESOLUTION_VGA_WIDTH 640
 #define RESOLUTION_VGA_HEIGHT 480
@@ -40,7 +42,7 @@ void ImageScalerCore::downScaleImage(
     int format, int src_skip_lines_top,
     // number of lines that are skipped after reading src_h
     // (should be set always to reach full image height)
-    int src_skip_lines_bottom) {
+    int src_skip_lines_bottom, int parallelism) {
     unsigned char* m_dest = (unsigned char*)dest;
     const unsigned char* m_src = (const unsigned char*)src;
     switch (format) {
@@ -55,13 +57,13 @@ void ImageScalerCore::downScaleImage(
                 // downscale & crop
                 ImageScalerCore::downScaleAndCropNv12Image(
                     m_dest, m_src, dest_w, dest_h, dest_stride, src_w, src_h, src_stride,
-                    src_skip_lines_top, src_skip_lines_bottom);
+                    src_skip_lines_top, src_skip_lines_bottom, parallelism);
             }
             break;
         }
         case V4L2_PIX_FMT_YUYV: {
             ImageScalerCore::downScaleYUY2Image(m_dest, m_src, dest_w, dest_h, dest_stride, src_w,
-                                                src_h, src_stride);
+                                                src_h, src_stride, parallelism);
             break;
         }
         default: {
@@ -73,7 +75,8 @@ void ImageScalerCore::downScaleImage(
 
 void ImageScalerCore::downScaleYUY2Image(unsigned char* dest, const unsigned char* src,
                                          const int dest_w, const int dest_h, const int dest_stride,
-                                         const int src_w, const int src_h, const int src_stride) {
+                                         const int src_w, const int src_h, const int src_stride,
+                                         const int parallelism) {
     if (dest == NULL || dest_w <= 0 || dest_h <= 0 || src == NULL || src_w <= 0 || src_h <= 0)
         return;
 
@@ -83,49 +86,61 @@ void ImageScalerCore::downScaleYUY2Image(unsigned char* dest, const unsigned cha
     const int scale_w = (src_w << 8) / dest_w;  // scale factors
     const int scale_h = (src_h << 8) / dest_h;
     int macro_pixel_width = dest_w >> 1;
-    unsigned int val_1, val_2;  // for bi-linear-interpolation
-    int i, j, k;
-
-    for (i = 0; i < dest_h; ++i) {
-        int src_i = i * scale_h;
-        int dy = src_i & 0xff;
-        src_i >>= 8;
-        for (j = 0; j < macro_pixel_width; ++j) {
-            int src_j = j * scale_w;
-            int dx = src_j & 0xff;
-            src_j = src_j >> 8;
-            for (k = 0; k < 4; ++k) {
-                // bi-linear-interpolation
-                if (dx == 0 && dy == 0) {
-                    dest[i * 2 * dest_stride + 4 * j + k] =
-                        src[src_i * 2 * src_stride + src_j * 4 + k];
-                } else if (dx == 0 && dy != 0) {
-                    val_1 = (unsigned int)src[src_i * 2 * src_stride + src_j * 4 + k];
-                    val_2 = (unsigned int)src[(src_i + 1) * 2 * src_stride + src_j * 4 + k];
-                    val_1 = (val_1 * (256 - dy) + val_2 * dy) >> 8;
-                    dest[i * 2 * dest_stride + 4 * j + k] = ((val_1 <= 255) ? val_1 : 255);
-                } else if (dx != 0 && dy == 0) {
-                    val_1 =
-                        ((unsigned int)src[src_i * 2 * src_stride + src_j * 4 + k] * (256 - dx) +
-                         (unsigned int)src[src_i * 2 * src_stride + (src_j + 1) * 4 + k] * dx) >>
-                        8;
-                    dest[i * 2 * dest_stride + 4 * j + k] = ((val_1 <= 255) ? val_1 : 255);
-                } else {
-                    val_1 =
-                        ((unsigned int)src[src_i * 2 * src_stride + src_j * 4 + k] * (256 - dx) +
-                         (unsigned int)src[src_i * 2 * src_stride + (src_j + 1) * 4 + k] * dx) >>
-                        8;
-                    val_2 = ((unsigned int)src[(src_i + 1) * 2 * src_stride + src_j * 4 + k] *
+
+    ThreadPool::forEachBand(dest_h, parallelism, 1, [&](int start, int end) {
+        unsigned int val_1, val_2;  // for bi-linear-interpolation
+        int i, j, k;
+
+        for (i = start; i < end; ++i) {
+            int src_i = i * scale_h;
+            int dy = src_i & 0xff;
+            src_i >>= 8;
+            const unsigned char* row0 = src + src_i * 2 * src_stride;
+            // The next row isn't read if dy is 0
+            const unsigned char* row1 = dy ? row0 + 2 * src_stride : row0;
+            j = SimdKernels::bilinearRow(dest + i * 2 * dest_stride, row0, row1,
+                                         macro_pixel_width * 4, 2, 4, 0, scale_w, dy,
+                                         2 * src_stride) >> 2;
+            for (; j < macro_pixel_width; ++j) {
+                int src_j = j * scale_w;
+                int dx = src_j & 0xff;
+                src_j = src_j >> 8;
+                for (k = 0; k < 4; ++k) {
+                    // bi-linear-interpolation
+                    if (dx == 0 && dy == 0) {
+                        dest[i * 2 * dest_stride + 4 * j + k] =
+                            src[src_i * 2 * src_stride + src_j * 4 + k];
+                    } else if (dx == 0 && dy != 0) {
+                        val_1 = (unsigned int)src[src_i * 2 * src_stride + src_j * 4 + k];
+                        val_2 = (unsigned int)src[(src_i + 1) * 2 * src_stride + src_j * 4 + k];
+                        val_1 = (val_1 * (256 - dy) + val_2 * dy) >> 8;
+                        dest[i * 2 * dest_stride + 4 * j + k] = ((val_1 <= 255) ? val_1 : 255);
+                    } else if (dx != 0 && dy == 0) {
+                        val_1 = ((unsigned int)src[src_i * 2 * src_stride + src_j * 4 + k] *
+                                     (256 - dx) +
+                                 (unsigned int)src[src_i * 2 * src_stride + (src_j + 1) * 4 + k] *
+                                     dx) >>
+                                8;
+                        dest[i * 2 * dest_stride + 4 * j + k] = ((val_1 <= 255) ? val_1 : 255);
+                    } else {
+                        val_1 = ((unsigned int)src[src_i * 2 * src_stride + src_j * 4 + k] *
+                                     (256 - dx) +
+                                 (unsigned int)src[src_i * 2 * src_stride + (src_j + 1) * 4 + k] *
+                                     dx) >>
+                                8;
+                        val_2 =
+                            ((unsigned int)src[(src_i + 1) * 2 * src_stride + src_j * 4 + k] *
                                  (256 - dx) +
                              (unsigned int)src[(src_i + 1) * 2 * src_stride + (src_j + 1) * 4 + k] *
                                  dx) >>
                             8;
-                    val_1 = (val_1 * (256 - dy) + val_2 * dy) >> 8;
-                    dest[i * 2 * dest_stride + 4 * j + k] = ((val_1 <= 255) ? val_1 : 255);
+                        val_1 = (val_1 * (256 - dy) + val_2 * dy) >> 8;
+                        dest[i * 2 * dest_stride + 4 * j + k] = ((val_1 <= 255) ? val_1 : 255);
+                    }
                 }
             }
         }
-    }
+    });
 }
 
 void ImageScalerCore::trimNv12Image(
@@ -211,11 +226,11 @@ void ImageScalerCore::downScaleAndCropNv12Image(
     const int src_skip_lines_top,
     // number of lines that are skipped after reading src_h
     // (should be set always to reach full image height)
-    const int src_skip_lines_bottom) {
+    const int src_skip_lines_bottom, const int parallelism) {
     LOG1("@%s: dest_w: %d, dest_h: %d, dest_stride: %d, src_w: %d, src_h: %d, src_stride: %d, "
-         "skip_top: %d, skip_bottom: %d, dest: %p, src: %p",
+         "skip_top: %d, skip_bottom: %d, dest: %p, src: %p, parallelism: %d",
          __func__, dest_w, dest_h, dest_stride, src_w, src_h, src_stride, src_skip_lines_top,
-         src_skip_lines_bottom, dest, src);
+         src_skip_lines_bottom, dest, src, parallelism);
 
     if (src_w == 800 && src_h == 600 && src_skip_lines_top == 0 && src_skip_lines_bottom == 0 &&
         dest_w == RESOLUTION_QVGA_WIDTH && dest_h == RESOLUTION_QVGA_HEIGHT) {
@@ -253,74 +268,85 @@ void ImageScalerCore::downScaleAndCropNv12Image(
     int r_skip = src_w < proper_source_width ? 0 : (src_w - proper_source_width - l_skip);
     int skip = l_skip + r_skip;
 
-    int i, j, x1, y1, x2, y2;
-    unsigned int val_1, val_2;
-    int dx, dy;
     int src_Y_data = src_stride * (src_h + src_skip_lines_bottom + (src_skip_lines_top >> 1));
     int dest_Y_data = dest_stride * dest_h;
-    int width, height;
     if (0 == dest_w || 0 == dest_h) {
         LOGE("%s,dest_w or dest_h should not be 0", __func__);
         return;
     }
     const int scaling_w = ((src_w - skip) << 8) / dest_w;
     const int scaling_h = (src_h << 8) / dest_h;
-    dx = 0;
-    dy = 0;
-    // get Y data
-    for (i = 0; i < dest_h; i++) {
-        y1 = i * scaling_h;
-        dy = y1 & 0xff;
-        y2 = y1 >> 8;
-        for (j = 0; j < dest_w; j++) {
-            x1 = j * scaling_w;
-            dx = x1 & 0xff;
-            x2 = (x1 >> 8) + l_skip;
-            val_1 = ((unsigned int)src[y2 * src_stride + x2] * (256 - dx) +
-                     (unsigned int)src[y2 * src_stride + x2 + 1] * dx) >>
-                    8;
-            val_2 = ((unsigned int)src[(y2 + 1) * src_stride + x2] * (256 - dx) +
-                     (unsigned int)src[(y2 + 1) * src_stride + x2 + 1] * dx) >>
-                    8;
-            dest[i * dest_stride + j] = MIN(((val_1 * (256 - dy) + val_2 * dy) >> 8), 0xff);
+
+    // The bands start at even lines, the UV lines [start / 2, end / 2) go with the Y lines
+    ThreadPool::forEachBand(dest_h, parallelism, 2, [&](int start, int end) {
+        int i, j, x1, y1, x2, y2;
+        unsigned int val_1, val_2;
+        int dx = 0, dy = 0;
+        int width = dest_w >> 1;
+        // get Y data
+        for (i = start; i < end; i++) {
+            y1 = i * scaling_h;
+            dy = y1 & 0xff;
+            y2 = y1 >> 8;
+            const unsigned char* row0 = src + y2 * src_stride;
+            j = SimdKernels::bilinearRow(dest + i * dest_stride, row0,
+                                         dy ? row0 + src_stride : row0, dest_w, 0, 1, l_skip,
+                                         scaling_w, dy, src_stride);
+            for (; j < dest_w; j++) {
+                x1 = j * scaling_w;
+                dx = x1 & 0xff;
+                x2 = (x1 >> 8) + l_skip;
+                val_1 = ((unsigned int)src[y2 * src_stride + x2] * (256 - dx) +
+                         (unsigned int)src[y2 * src_stride + x2 + 1] * dx) >>
+                        8;
+                val_2 = ((unsigned int)src[(y2 + 1) * src_stride + x2] * (256 - dx) +
+                         (unsigned int)src[(y2 + 1) * src_stride + x2 + 1] * dx) >>
+                        8;
+                dest[i * dest_stride + j] = MIN(((val_1 * (256 - dy) + val_2 * dy) >> 8), 0xff);
+            }
         }
-    }
-    i = 0;
-    j = 0;
-    width = dest_w >> 1;
-    height = dest_h >> 1;
-    // get UV data
-    for (i = 0; i < height; i++) {
-        y1 = i * scaling_h;
-        dy = y1 & 0xff;
-        y2 = y1 >> 8;
-        for (j = 0; j < width; j++) {
-            x1 = j * scaling_w;
-            dx = x1 & 0xff;
-            x2 = (x1 >> 8) + l_skip / 2;
-            // fill U data
-            val_1 = ((unsigned int)src[y2 * src_stride + (x2 << 1) + src_Y_data] * (256 - dx) +
-                     (unsigned int)src[y2 * src_stride + ((x2 + 1) << 1) + src_Y_data] * dx) >>
-                    8;
-            val_2 =
-                ((unsigned int)src[(y2 + 1) * src_stride + (x2 << 1) + src_Y_data] * (256 - dx) +
-                 (unsigned int)src[(y2 + 1) * src_stride + ((x2 + 1) << 1) + src_Y_data] * dx) >>
-                8;
-            dest[i * dest_stride + (j << 1) + dest_Y_data] =
-                MIN(((val_1 * (256 - dy) + val_2 * dy) >> 8), 0xff);
-            // fill V data
-            val_1 = ((unsigned int)src[y2 * src_stride + (x2 << 1) + 1 + src_Y_data] * (256 - dx) +
-                     (unsigned int)src[y2 * src_stride + ((x2 + 1) << 1) + 1 + src_Y_data] * dx) >>
-                    8;
-            val_2 = ((unsigned int)src[(y2 + 1) * src_stride + (x2 << 1) + 1 + src_Y_data] *
+        // get UV data
+        for (i = start / 2; i < end / 2; i++) {
+            y1 = i * scaling_h;
+            dy = y1 & 0xff;
+            y2 = y1 >> 8;
+            // U and V are interleaved, each output byte is one sample
+            const unsigned char* row0 = src + y2 * src_stride + src_Y_data;
+            j = SimdKernels::bilinearRow(dest + i * dest_stride + dest_Y_data, row0,
+                                         dy ? row0 + src_stride : row0, width * 2, 1, 2, l_skip / 2,
+                                         scaling_w, dy, src_stride) >> 1;
+            for (; j < width; j++) {
+                x1 = j * scaling_w;
+                dx = x1 & 0xff;
+                x2 = (x1 >> 8) + l_skip / 2;
+                // fill U data
+                val_1 = ((unsigned int)src[y2 * src_stride + (x2 << 1) + src_Y_data] * (256 - dx) +
+                         (unsigned int)src[y2 * src_stride + ((x2 + 1) << 1) + src_Y_data] * dx) >>
+                        8;
+                val_2 = ((unsigned int)src[(y2 + 1) * src_stride + (x2 << 1) + src_Y_data] *
+                             (256 - dx) +
+                         (unsigned int)src[(y2 + 1) * src_stride + ((x2 + 1) << 1) + src_Y_data] *
+                             dx) >>
+                        8;
+                dest[i * dest_stride + (j << 1) + dest_Y_data] =
+                    MIN(((val_1 * (256 - dy) + val_2 * dy) >> 8), 0xff);
+                // fill V data
+                val_1 = ((unsigned int)src[y2 * src_stride + (x2 << 1) + 1 + src_Y_data] *
+                             (256 - dx) +
+                         (unsigned int)src[y2 * src_stride + ((x2 + 1) << 1) + 1 + src_Y_data] *
+                             dx) >>
+                        8;
+                val_2 =
+                    ((unsigned int)src[(y2 + 1) * src_stride + (x2 << 1) + 1 + src_Y_data] *
                          (256 - dx) +
                      (unsigned int)src[(y2 + 1) * src_stride + ((x2 + 1) << 1) + 1 + src_Y_data] *
                          dx) >>
                     8;
-            dest[i * dest_stride + (j << 1) + 1 + dest_Y_data] =
-                MIN(((val_1 * (256 - dy) + val_2 * dy) >> 8), 0xff);
+                dest[i * dest_stride + (j << 1) + 1 + dest_Y_data] =
+                    MIN(((val_1 * (256 - dy) + val_2 * dy) >> 8), 0xff);
+            }
         }
-    }
+    });
 }
 
 void ImageScalerCore::downScaleAndCropNv12ImageQvga(unsigned char* dest, const unsigned char* src,
@@ -336,8 +362,13 @@ void ImageScalerCore::downScaleAndCropNv12ImageQvga(unsigned char* dest, const u
         u_int32_t* s1 = (u_int32_t*)(&src[(i * scale + 0) * src_stride]);
         u_int32_t* s2 = (u_int32_t*)(&src[(i * scale + 1) * src_stride]);
         u_int32_t* d = (u_int32_t*)(&dest[i * dest_stride]);
+        int j = SimdKernels::average2x2Row(&dest[i * dest_stride], (unsigned char*)s1,
+                                           (unsigned char*)s2, dest_w, false);
+        s1 += j / 2;
+        s2 += j / 2;
+        d += j / 4;
         // This processes 4 dest pixels at a time
-        for (int j = 0; j < dest_w; j += 4) {
+        for (; j < dest_w; j += 4) {
             u_int32_t a1;  // Input data upper row
             u_int32_t a2;  // Input data lower row
             u_int32_t b;   // Output data
@@ -368,8 +399,13 @@ void ImageScalerCore::downScaleAndCropNv12ImageQvga(unsigned char* dest, const u
         u_int32_t* s1 = (u_int32_t*)(&src[(i * scale + 0) * src_stride]);
         u_int32_t* s2 = (u_int32_t*)(&src[(i * scale + 1) * src_stride]);
         u_int32_t* d = (u_int32_t*)(&dest[i * dest_stride]);
+        int j = SimdKernels::average2x2Row(&dest[i * dest_stride], (unsigned char*)s1,
+                                           (unsigned char*)s2, dest_w, true) / 2;
+        s1 += j;
+        s2 += j;
+        d += j / 2;
         // This processes 2 dest UV pairs at a time
-        for (int j = 0; j < dest_w / 2; j += 2) {
+        for (; j < dest_w / 2; j += 2) {
             u_int32_t a1;  // Input data upper row
             u_int32_t a2;  // Input data lower row
             u_int32_t b;   // Output data
@@ -864,7 +900,8 @@ int ImageScalerCore::cropCompose(void* src, unsigned int srcW, unsigned int srcH
                                  int dstFormat, unsigned int srcCropW, unsigned int srcCropH,
                                  unsigned int srcCropLeft, unsigned int srcCropTop,
                                  unsigned int dstCropW, unsigned int dstCropH,
-                                 unsigned int dstCropLeft, unsigned int dstCropTop) {
+                                 unsigned int dstCropLeft, unsigned int dstCropTop,
+                                 int parallelism) {
     static const unsigned int MAXVAL = 65536;
     static const int ALLOW_DOWNSCALING = 1;
 
@@ -910,7 +947,7 @@ int ImageScalerCore::cropCompose(void* src, unsigned int srcW, unsigned int srcH
         // Upscaling both horizontally and vertically
         cropComposeUpscaleNV12_bl(src, srcH, srcStride, srcCropLeft, srcCropTop, srcCropW, srcCropH,
                                   dst, dstH, dstStride, dstCropLeft, dstCropTop, dstCropW,
-                                  dstCropH);
+                                  dstCropH, parallelism);
         return 0;
     }
 
@@ -945,11 +982,10 @@ void ImageScalerCore::cropComposeUpscaleNV12_bl(void* src, unsigned int srcH,
                                                 unsigned int srcCropH, void* dst, unsigned int dstH,
                                                 unsigned int dstStride, unsigned int dstCropLeft,
                                                 unsigned int dstCropTop, unsigned int dstCropW,
-                                                unsigned int dstCropH) {
+                                                unsigned int dstCropH, int parallelism) {
     static const int BILINEAR = 1;
     static const unsigned int FP_1 = 1 << MFP;         // Fixed point 1.0
     static const unsigned int FRACT = (1 << MFP) - 1;  // Fractional part mask
-    unsigned int dx, dy, sx, sy;
     unsigned char* s = (unsigned char*)src;
     unsigned char* d = (unsigned char*)dst;
     unsigned int sx0, sy0, dx0, dy0, dx1, dy1;
@@ -962,33 +998,44 @@ void ImageScalerCore::cropComposeUpscaleNV12_bl(void* src, unsigned int srcH,
         return;
     }
 
-    // Upscale luminance
+    // Upscale luminance, the source line of every output line is computed from its index,
+    // so the output lines can be split into bands.
     sx0 = srcCropLeft << MFP;
     sy0 = srcCropTop << MFP;
     dx0 = dstCropLeft;
     dy0 = dstCropTop;
     dx1 = dstCropLeft + dstCropW;
     dy1 = dstCropTop + dstCropH;
-    for (dy = dy0, sy = sy0; dy < dy1; dy++, sy += syd) {
-        for (dx = dx0, sx = sx0; dx < dx1; dx++, sx += sxd) {
-            unsigned int sxi = sx >> MFP;
-            unsigned int syi = sy >> MFP;
-            unsigned int s0 = s[srcStride * syi + sxi];
-            if (BILINEAR) {
-                unsigned int fx = sx & FRACT;  // Fractional part
-                unsigned int fy = sy & FRACT;
-                unsigned int fx1 = FP_1 - fx;  // 1 - fractional part
-                unsigned int fy1 = FP_1 - fy;
-                unsigned int s1 = s[srcStride * syi + sxi + 1];
-                unsigned int s2 = s[srcStride * (syi + 1) + sxi];
-                unsigned int s3 = s[srcStride * (syi + 1) + sxi + 1];
-                unsigned int s4 = (s0 * fx1 + s1 * fx) >> MFP;
-                unsigned int s5 = (s2 * fx1 + s3 * fx) >> MFP;
-                s0 = (s4 * fy1 + s5 * fy) >> MFP;
+    ThreadPool::forEachBand(dy1 - dy0, parallelism, 1, [&](int start, int end) {
+        unsigned int dx, dy, sx, sy;
+        for (dy = dy0 + start, sy = sy0 + start * syd; dy < dy0 + end; dy++, sy += syd) {
+            unsigned int done = 0;
+            if (BILINEAR && MFP == 16) {
+                unsigned int syi = sy >> MFP;
+                done = SimdKernels::bilinearRowQ16(&d[dstStride * dy + dx0], &s[srcStride * syi],
+                                                   &s[srcStride * (syi + 1)], dx1 - dx0, sx0, sxd,
+                                                   sy & FRACT, srcStride);
+            }
+            for (dx = dx0 + done, sx = sx0 + done * sxd; dx < dx1; dx++, sx += sxd) {
+                unsigned int sxi = sx >> MFP;
+                unsigned int syi = sy >> MFP;
+                unsigned int s0 = s[srcStride * syi + sxi];
+                if (BILINEAR) {
+                    unsigned int fx = sx & FRACT;  // Fractional part
+                    unsigned int fy = sy & FRACT;
+                    unsigned int fx1 = FP_1 - fx;  // 1 - fractional part
+                    unsigned int fy1 = FP_1 - fy;
+                    unsigned int s1 = s[srcStride * syi + sxi + 1];
+                    unsigned int s2 = s[srcStride * (syi + 1) + sxi];
+                    unsigned int s3 = s[srcStride * (syi + 1) + sxi + 1];
+                    unsigned int s4 = (s0 * fx1 + s1 * fx) >> MFP;
+                    unsigned int s5 = (s2 * fx1 + s3 * fx) >> MFP;
+                    s0 = (s4 * fy1 + s5 * fy) >> MFP;
+                }
+                d[dstStride * dy + dx] = s0;
             }
-            d[dstStride * dy + dx] = s0;
         }
-    }
+    });
 
     // Upscale chrominance
     s = (unsigned char*)src + srcStride * srcH;
@@ -999,14 +1046,17 @@ void ImageScalerCore::cropComposeUpscaleNV12_bl(void* src, unsigned int srcH,
     dy0 = dstCropTop >> 1;
     dx1 = (dstCropLeft + dstCropW) >> 1;
     dy1 = (dstCropTop + dstCropH) >> 1;
-    for (dy = dy0, sy = sy0; dy < dy1; dy++, sy += syd) {
-        for (dx = dx0, sx = sx0; dx < dx1; dx++, sx += sxd) {
-            unsigned int sxi = sx >> MFP;
-            unsigned int syi = sy >> MFP;
-            d[dstStride * dy + dx * 2 + 0] = s[srcStride * syi + sxi * 2 + 0];
-            d[dstStride * dy + dx * 2 + 1] = s[srcStride * syi + sxi * 2 + 1];
+    ThreadPool::forEachBand(dy1 - dy0, parallelism, 1, [&](int start, int end) {
+        unsigned int dx, dy, sx, sy;
+        for (dy = dy0 + start, sy = sy0 + start * syd; dy < dy0 + end; dy++, sy += syd) {
+            for (dx = dx0, sx = sx0; dx < dx1; dx++, sx += sxd) {
+                unsigned int sxi = sx >> MFP;
+                unsigned int syi = sy >> MFP;
+                d[dstStride * dy + dx * 2 + 0] = s[srcStride * syi + sxi * 2 + 0];
+                d[dstStride * dy + dx * 2 + 1] = s[srcStride * syi + sxi * 2 + 1];
+            }
         }
-    }
+    });
 }
 
 }  // namespace icamera
@@ -19,18 +19,21 @@ namespace icamera {
 /**
  * \class ImageScalerCore
  *
+ * parallelism is the max thread number of ThreadPool to scale one image, the output
+ * rows are split into bands. 0 means using all the pool workers.
  */
 class ImageScalerCore {
  public:
     static void downScaleImage(void* src, void* dest, int dest_w, int dest_h, int dest_stride,
                                int src_w, int src_h, int src_stride, int format,
-                               int src_skip_lines_top = 0, int src_skip_lines_bottom = 0);
+                               int src_skip_lines_top = 0, int src_skip_lines_bottom = 0,
+                               int parallelism = 1);
     static int cropCompose(void* src, unsigned int srcW, unsigned int srcH, unsigned int srcStride,
                            int srcFormat, void* dst, unsigned int dstW, unsigned int dstH,
                            unsigned int dstStride, int dstFormat, unsigned int srcCropW,
                            unsigned int srcCropH, unsigned int srcCropLeft, unsigned int srcCropTop,
                            unsigned int dstCropW, unsigned int dstCropH, unsigned int dstCropLeft,
-                           unsigned int dstCropTop);
+                           unsigned int dstCropTop, int parallelism = 1);
     static int cropComposeZoom(void* src, void* dst, unsigned int width, unsigned int height,
                                unsigned int stride, int format, unsigned int srcCropW,
                                unsigned int srcCropH, unsigned int srcCropLeft,
@@ -39,13 +42,15 @@ class ImageScalerCore {
  protected:
     static void downScaleYUY2Image(unsigned char* dest, const unsigned char* src, const int dest_w,
                                    const int dest_h, const int dest_stride, const int src_w,
-                                   const int src_h, const int src_stride);
+                                   const int src_h, const int src_stride,
+                                   const int parallelism = 1);
 
     static void downScaleAndCropNv12Image(unsigned char* dest, const unsigned char* src,
                                           const int dest_w, const int dest_h, const int dest_stride,
                                           const int src_w, const int src_h, const int src_stride,
                                           const int src_skip_lines_top = 0,
-                                          const int src_skip_lines_bottom = 0);
+                                          const int src_skip_lines_bottom = 0,
+                                          const int parallelism = 1);
 
     static void trimNv12Image(unsigned char* dest, const unsigned char* src, const int dest_w,
                               const int dest_h, const int dest_stride, const int src_w,
@@ -72,6 +77,7 @@ class ImageScalerCore {
                                           unsigned int srcCropW, unsigned int srcCropH, void* dst,
                                           unsigned int dstH, unsigned int dstStride,
                                           unsigned int dstCropLeft, unsigned int dstCropTop,
-                                          unsigned int dstCropW, unsigned int dstCropH);
+                                          unsigned int dstCropW, unsigned int dstCropH,
+                                          int parallelism);
 };
 }  // namespace icamera
@@ -51,9 +51,13 @@ status_t ScaleProcess::doPostProcessing(const shared_ptr<camera3::Camera3Buffer>
     return OK;
 }
 
-RotateProcess::RotateProcess(int angle) : PostProcessorBase("Rotate"), mAngle(angle) {
-    LOG1("@%s create rotate processor, degree: %d", __func__, mAngle);
+RotateProcess::RotateProcess(int angle, int parallelism)
+        : PostProcessorBase("Rotate"),
+          mAngle(angle) {
+    LOG1("@%s create rotate processor, degree: %d, parallelism: %d", __func__, mAngle,
+         parallelism);
     mProcessor = IImageProcessor::createImageProcessor();
+    mProcessor->setParallelism(parallelism);
 }
 
 status_t RotateProcess::doPostProcessing(const shared_ptr<camera3::Camera3Buffer>& inBuf,
@@ -88,9 +92,10 @@ status_t CropProcess::doPostProcessing(const shared_ptr<camera3::Camera3Buffer>&
     return OK;
 }
 
-ConvertProcess::ConvertProcess() : PostProcessorBase("Convert") {
-    LOG1("@%s create convert processor", __func__);
+ConvertProcess::ConvertProcess(int parallelism) : PostProcessorBase("Convert") {
+    LOG1("@%s create convert processor, parallelism: %d", __func__, parallelism);
     mProcessor = IImageProcessor::createImageProcessor();
+    mProcessor->setParallelism(parallelism);
 }
 
 status_t ConvertProcess::doPostProcessing(const shared_ptr<camera3::Camera3Buffer>& inBuf,
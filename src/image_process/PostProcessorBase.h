@@ -65,7 +65,7 @@ class ScaleProcess : public PostProcessorBase {
 
 class RotateProcess : public PostProcessorBase {
  public:
-    RotateProcess(int angle);
+    RotateProcess(int angle, int parallelism = 1);
     ~RotateProcess(){};
 
     virtual status_t doPostProcessing(const std::shared_ptr<camera3::Camera3Buffer>& inBuf,
@@ -86,7 +86,7 @@ class CropProcess : public PostProcessorBase {
 
 class ConvertProcess : public PostProcessorBase {
  public:
-    ConvertProcess();
+    ConvertProcess(int parallelism = 1);
     ~ConvertProcess(){};
 
     virtual status_t doPostProcessing(const std::shared_ptr<camera3::Camera3Buffer>& inBuf,
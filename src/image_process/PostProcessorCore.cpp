@@ -20,6 +20,7 @@
 
 #include "HALv3Utils.h"
 #include "iutils/CameraLog.h"
+#include "PlatformData.h"
 
 using std::shared_ptr;
 
@@ -40,13 +41,15 @@ status_t PostProcessorCore::createProcessor() {
                 processor = std::make_shared<ScaleProcess>();
                 break;
             case POST_PROCESS_ROTATE:
-                processor = std::make_shared<RotateProcess>(order.angle);
+                processor = std::make_shared<RotateProcess>(
+                    order.angle, PlatformData::getSwProcessingThreads(mCameraId));
                 break;
             case POST_PROCESS_CROP:
                 processor = std::make_shared<CropProcess>();
                 break;
             case POST_PROCESS_CONVERT:
-                processor = std::make_shared<ConvertProcess>();
+                processor = std::make_shared<ConvertProcess>(
+                    PlatformData::getSwProcessingThreads(mCameraId));
                 break;
             case POST_PROCESS_JPEG_ENCODING:
                 processor = std::make_shared<JpegProcess>(mCameraId);
@@ -0,0 +1,496 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG SimdKernels
+
+#include "SimdKernels.h"
+
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#endif
+
+#include "iutils/CameraLog.h"
+
+namespace icamera {
+
+static SimdLevel detectSimdLevel() {
+    const char* PROP_CAMERA_SIMD = "cameraSimd";
+    char* simd = getenv(PROP_CAMERA_SIMD);
+    if (simd && atoi(simd) == 0) {
+        LOG1("%s: SIMD is disabled by %s", __func__, PROP_CAMERA_SIMD);
+        return SIMD_LEVEL_NONE;
+    }
+
+    SimdLevel level = SIMD_LEVEL_NONE;
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        level = SIMD_LEVEL_AVX2;
+    } else if (__builtin_cpu_supports("sse4.2")) {
+        level = SIMD_LEVEL_SSE42;
+    }
+#endif
+    LOG1("%s: SIMD level %d", __func__, level);
+    return level;
+}
+
+SimdLevel SimdKernels::getSimdLevel() {
+    static const SimdLevel sLevel = detectSimdLevel();
+    return sLevel;
+}
+
+#ifdef SIMD_X86
+// Narrow 8 int32 lanes (0~255) to 8 bytes
+__attribute__((target("avx2"))) static inline void storeLow8Bytes(unsigned char* dst,
+                                                                  __m256i v) {
+    const __m256i order = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+    v = _mm256_packus_epi32(v, v);
+    v = _mm256_packus_epi16(v, v);
+    v = _mm256_permutevar8x32_epi32(v, order);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(v));
+}
+
+// Weighted sum of 2 samples with 8 bits fraction: (a * (256 - w) + b * w) >> 8
+__attribute__((target("avx2"))) static inline __m256i blend8(__m256i a, __m256i b, __m256i w) {
+    const __m256i one = _mm256_set1_epi32(256);
+    __m256i ab = _mm256_or_si256(a, _mm256_slli_epi32(b, 16));
+    __m256i ww = _mm256_or_si256(_mm256_sub_epi32(one, w), _mm256_slli_epi32(w, 16));
+    return _mm256_srli_epi32(_mm256_madd_epi16(ab, ww), 8);
+}
+
+// groupShift 2 and step 4 (YUY2): the 4 bytes of one group are gathered at once and
+// interpolated in 16 bits lanes, (a * (256 - w) + b * w) is 65280 at most.
+__attribute__((target("avx2"))) static int bilinearRowQuadAvx2(
+    unsigned char* dst, const unsigned char* row0, const unsigned char* row1, int count,
+    int offset, int scale, int dy, int limit) {
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+    const __m256i one = _mm256_set1_epi16(256);
+    const __m256i vScale = _mm256_set1_epi32(scale);
+    const __m256i vOffset = _mm256_set1_epi32(offset);
+    const __m256i vDy = _mm256_set1_epi16(dy);
+    const __m256i vDy1 = _mm256_set1_epi16(256 - dy);
+    const int* base0 = reinterpret_cast<const int*>(row0);
+    const int* base1 = reinterpret_cast<const int*>(row1);
+    const int* next0 = reinterpret_cast<const int*>(row0 + 4);
+    const int* next1 = reinterpret_cast<const int*>(row1 + 4);
+
+    int j = 0;
+    for (; j + 32 <= count; j += 32) {
+        int lastX = (((((j >> 2) + 7) * scale) >> 8) + offset) * 4;
+        if (lastX + 7 >= limit) break;
+
+        __m256i p = _mm256_mullo_epi32(_mm256_add_epi32(_mm256_set1_epi32(j >> 2), lane), vScale);
+        __m256i x = _mm256_slli_epi32(_mm256_add_epi32(_mm256_srli_epi32(p, 8), vOffset), 2);
+        // Every 16 bits of a group share the same dx
+        __m256i dx = _mm256_and_si256(p, byteMask);
+        dx = _mm256_or_si256(dx, _mm256_slli_epi32(dx, 16));
+        __m256i dx2[2] = {_mm256_unpacklo_epi32(dx, dx), _mm256_unpackhi_epi32(dx, dx)};
+
+        __m256i g[4] = {_mm256_i32gather_epi32(base0, x, 1), _mm256_i32gather_epi32(next0, x, 1),
+                        _mm256_i32gather_epi32(base1, x, 1), _mm256_i32gather_epi32(next1, x, 1)};
+        __m256i v[2];
+        for (int k = 0; k < 2; k++) {
+            __m256i s[4];
+            for (int n = 0; n < 4; n++) {
+                s[n] = k ? _mm256_unpackhi_epi8(g[n], zero) : _mm256_unpacklo_epi8(g[n], zero);
+            }
+            __m256i w1 = _mm256_sub_epi16(one, dx2[k]);
+            __m256i h0 = _mm256_srli_epi16(
+                _mm256_add_epi16(_mm256_mullo_epi16(s[0], w1), _mm256_mullo_epi16(s[1], dx2[k])),
+                8);
+            __m256i h1 = _mm256_srli_epi16(
+                _mm256_add_epi16(_mm256_mullo_epi16(s[2], w1), _mm256_mullo_epi16(s[3], dx2[k])),
+                8);
+            v[k] = _mm256_srli_epi16(
+                _mm256_add_epi16(_mm256_mullo_epi16(h0, vDy1), _mm256_mullo_epi16(h1, vDy)), 8);
+        }
+        // The unpacked halves are packed back in the original order within each 128 bits
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + j), _mm256_packus_epi16(v[0], v[1]));
+    }
+    return j;
+}
+
+__attribute__((target("avx2"))) static int bilinearRowAvx2(
+    unsigned char* dst, const unsigned char* row0, const unsigned char* row1, int count,
+    int groupShift, int step, int offset, int scale, int dy, int limit) {
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+    const __m256i channelMask = _mm256_set1_epi32((1 << groupShift) - 1);
+    const __m128i shift = _mm_cvtsi32_si128(groupShift);
+    const __m256i vScale = _mm256_set1_epi32(scale);
+    const __m256i vOffset = _mm256_set1_epi32(offset);
+    const __m256i vStep = _mm256_set1_epi32(step);
+    const __m256i vDy = _mm256_set1_epi32(dy);
+    const __m128i nextShift = _mm_cvtsi32_si128(step * 8);
+    const int* base0 = reinterpret_cast<const int*>(row0);
+    const int* base1 = reinterpret_cast<const int*>(row1);
+
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        // The source position grows with j, and each gather reads 4 bytes
+        int last = j + 7;
+        int lastX = ((((last >> groupShift) * scale) >> 8) + offset) * step +
+                    (last & ((1 << groupShift) - 1));
+        if (lastX + step + 3 >= limit) break;
+
+        __m256i idx = _mm256_add_epi32(_mm256_set1_epi32(j), lane);
+        __m256i p = _mm256_mullo_epi32(_mm256_srl_epi32(idx, shift), vScale);
+        __m256i dx = _mm256_and_si256(p, byteMask);
+        __m256i x = _mm256_add_epi32(_mm256_srli_epi32(p, 8), vOffset);
+        x = _mm256_add_epi32(_mm256_mullo_epi32(x, vStep), _mm256_and_si256(idx, channelMask));
+
+        // Both samples are in the gathered 4 bytes since step is 1 or 2
+        __m256i g0 = _mm256_i32gather_epi32(base0, x, 1);
+        __m256i g1 = _mm256_i32gather_epi32(base1, x, 1);
+        __m256i a0 = _mm256_and_si256(g0, byteMask);
+        __m256i b0 = _mm256_and_si256(_mm256_srl_epi32(g0, nextShift), byteMask);
+        __m256i a1 = _mm256_and_si256(g1, byteMask);
+        __m256i b1 = _mm256_and_si256(_mm256_srl_epi32(g1, nextShift), byteMask);
+
+        __m256i v = blend8(blend8(a0, b0, dx), blend8(a1, b1, dx), vDy);
+        storeLow8Bytes(dst + j, v);
+    }
+    return j;
+}
+
+__attribute__((target("avx2"))) static int bilinearRowQ16Avx2(
+    unsigned char* dst, const unsigned char* row0, const unsigned char* row1, int count,
+    unsigned int sx0, unsigned int sxd, unsigned int fy, int limit) {
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+    const __m256i fractMask = _mm256_set1_epi32(0xffff);
+    const __m256i one = _mm256_set1_epi32(0x10000);
+    const __m256i vSxd = _mm256_set1_epi32(sxd);
+    const __m256i vFy = _mm256_set1_epi32(fy);
+    const __m256i vFy1 = _mm256_set1_epi32(0x10000 - fy);
+    const int* base0 = reinterpret_cast<const int*>(row0);
+    const int* base1 = reinterpret_cast<const int*>(row1);
+
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        unsigned int sx = sx0 + j * sxd;
+        if (static_cast<int>((sx + 7 * sxd) >> 16) + 3 >= limit) break;
+
+        __m256i vSx = _mm256_add_epi32(_mm256_set1_epi32(sx), _mm256_mullo_epi32(lane, vSxd));
+        __m256i x = _mm256_srli_epi32(vSx, 16);
+        __m256i fx = _mm256_and_si256(vSx, fractMask);
+        __m256i fx1 = _mm256_sub_epi32(one, fx);
+
+        __m256i g0 = _mm256_i32gather_epi32(base0, x, 1);
+        __m256i g1 = _mm256_i32gather_epi32(base1, x, 1);
+        __m256i s0 = _mm256_and_si256(g0, byteMask);
+        __m256i s1 = _mm256_and_si256(_mm256_srli_epi32(g0, 8), byteMask);
+        __m256i s2 = _mm256_and_si256(g1, byteMask);
+        __m256i s3 = _mm256_and_si256(_mm256_srli_epi32(g1, 8), byteMask);
+
+        __m256i s4 = _mm256_srli_epi32(
+            _mm256_add_epi32(_mm256_mullo_epi32(s0, fx1), _mm256_mullo_epi32(s1, fx)), 16);
+        __m256i s5 = _mm256_srli_epi32(
+            _mm256_add_epi32(_mm256_mullo_epi32(s2, fx1), _mm256_mullo_epi32(s3, fx)), 16);
+        __m256i v = _mm256_srli_epi32(
+            _mm256_add_epi32(_mm256_mullo_epi32(s4, vFy1), _mm256_mullo_epi32(s5, vFy)), 16);
+        storeLow8Bytes(dst + j, v);
+    }
+    return j;
+}
+
+__attribute__((target("sse4.2"))) static int average2x2RowSse42(unsigned char* dst,
+                                                               const unsigned char* row0,
+                                                               const unsigned char* row1,
+                                                               int count, bool interleaved) {
+    const __m128i ones = _mm_set1_epi8(1);
+    const __m128i round = _mm_set1_epi16(2);
+    // Put U0 U1 V0 V1 next to each other, the pair sums are still in U V order
+    const __m128i order =
+        _mm_setr_epi8(0, 2, 1, 3, 4, 6, 5, 7, 8, 10, 9, 11, 12, 14, 13, 15);
+
+    int j = 0;
+    for (; j + 16 <= count; j += 16) {
+        __m128i sum[2];
+        for (int k = 0; k < 2; k++) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * j + 16 * k));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * j + 16 * k));
+            if (interleaved) {
+                a = _mm_shuffle_epi8(a, order);
+                b = _mm_shuffle_epi8(b, order);
+            }
+            sum[k] = _mm_add_epi16(_mm_maddubs_epi16(a, ones), _mm_maddubs_epi16(b, ones));
+            sum[k] = _mm_srli_epi16(_mm_add_epi16(sum[k], round), 2);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), _mm_packus_epi16(sum[0], sum[1]));
+    }
+    return j;
+}
+
+__attribute__((target("sse4.2"))) static int swapBytePairsRowSse42(unsigned char* dst,
+                                                                  const unsigned char* src,
+                                                                  int count) {
+    int j = 0;
+    for (; j + 16 <= count; j += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + j));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), v);
+    }
+    return j;
+}
+
+__attribute__((target("sse4.2"))) static int deinterleaveRowSse42(unsigned char* even,
+                                                                 unsigned char* odd,
+                                                                 const unsigned char* src,
+                                                                 int count) {
+    const __m128i mask = _mm_set1_epi16(0xff);
+
+    int j = 0;
+    for (; j + 16 <= count; j += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * j));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * j + 16));
+        if (even) {
+            __m128i v = _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(even + j), v);
+        }
+        if (odd) {
+            __m128i v = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(odd + j), v);
+        }
+    }
+    return j;
+}
+
+__attribute__((target("sse4.2"))) static int interleaveRowSse42(unsigned char* dst,
+                                                               const unsigned char* even,
+                                                               const unsigned char* odd,
+                                                               int count) {
+    int j = 0;
+    for (; j + 16 <= count; j += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(even + j));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(odd + j));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * j), _mm_unpacklo_epi8(a, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * j + 16), _mm_unpackhi_epi8(a, b));
+    }
+    return j;
+}
+
+// The sums of 4 samples of 10 bits fit in the 16 bits lanes
+__attribute__((target("sse4.2"))) static int demosaicRowSse42(short* own, short* g, short* other,
+                                                             const short* above, const short* cur,
+                                                             const short* below, int count,
+                                                             bool siteEven) {
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi16(2);
+    const __m128i site =
+        siteEven ? _mm_set1_epi32(0x0000ffff) : _mm_set1_epi32(static_cast<int>(0xffff0000));
+
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + j));
+        __m128i lr = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + j - 1)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + j + 1)));
+        __m128i ud = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(above + j)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(below + j)));
+        __m128i diag = _mm_add_epi16(
+            _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(above + j - 1)),
+                          _mm_loadu_si128(reinterpret_cast<const __m128i*>(above + j + 1))),
+            _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(below + j - 1)),
+                          _mm_loadu_si128(reinterpret_cast<const __m128i*>(below + j + 1))));
+
+        __m128i h = _mm_srli_epi16(_mm_add_epi16(lr, one), 1);
+        __m128i v = _mm_srli_epi16(_mm_add_epi16(ud, one), 1);
+        __m128i cross = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lr, ud), two), 2);
+        diag = _mm_srli_epi16(_mm_add_epi16(diag, two), 2);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(own + j), _mm_blendv_epi8(h, c, site));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(g + j), _mm_blendv_epi8(c, cross, site));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(other + j), _mm_blendv_epi8(v, diag, site));
+    }
+    return j;
+}
+
+// (c0 * x + c1 * y + c2 * z + 16384) >> 15 of 8 lanes, x/y and z/1 are multiplied in pairs
+__attribute__((target("sse4.2"))) static inline __m128i weightedSum(__m128i x, __m128i y,
+                                                                   __m128i z, __m128i c01,
+                                                                   __m128i c2) {
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(x, y), c01),
+                               _mm_madd_epi16(_mm_unpacklo_epi16(z, one), c2));
+    __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(x, y), c01),
+                               _mm_madd_epi16(_mm_unpackhi_epi16(z, one), c2));
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 15), _mm_srai_epi32(hi, 15));
+}
+
+__attribute__((target("sse4.2"))) static int rgbToYRowSse42(unsigned char* y, const short* r,
+                                                           const short* g, const short* b,
+                                                           int count) {
+    const __m128i cRG = _mm_setr_epi16(2105, 4129, 2105, 4129, 2105, 4129, 2105, 4129);
+    const __m128i cB = _mm_setr_epi16(803, 16384, 803, 16384, 803, 16384, 803, 16384);
+    const __m128i offset = _mm_set1_epi16(16);
+
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m128i vr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r + j));
+        __m128i vg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(g + j));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+        __m128i vy = _mm_add_epi16(weightedSum(vr, vg, vb, cRG, cB), offset);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(y + j), _mm_packus_epi16(vy, vy));
+    }
+    return j;
+}
+
+// The rounded average of the pixel pairs in row0 (and row1), 8 pairs
+__attribute__((target("sse4.2"))) static inline __m128i averagePairs(const short* row0,
+                                                                    const short* row1) {
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i lo = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0)), one);
+    __m128i hi = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8)), one);
+    if (!row1) {
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, _mm_set1_epi32(1)), 1);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, _mm_set1_epi32(1)), 1);
+        return _mm_packs_epi32(lo, hi);
+    }
+    lo = _mm_add_epi32(
+        lo, _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1)), one));
+    hi = _mm_add_epi32(
+        hi, _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8)), one));
+    lo = _mm_srai_epi32(_mm_add_epi32(lo, _mm_set1_epi32(2)), 2);
+    hi = _mm_srai_epi32(_mm_add_epi32(hi, _mm_set1_epi32(2)), 2);
+    return _mm_packs_epi32(lo, hi);
+}
+
+__attribute__((target("sse4.2"))) static int rgbToUVRowSse42(unsigned char* uv, const short* r0,
+                                                            const short* g0, const short* b0,
+                                                            const short* r1, const short* g1,
+                                                            const short* b1, int count) {
+    const __m128i cuRG = _mm_setr_epi16(-1212, -2384, -1212, -2384, -1212, -2384, -1212, -2384);
+    const __m128i cuB = _mm_setr_epi16(3596, 16384, 3596, 16384, 3596, 16384, 3596, 16384);
+    const __m128i cvRG = _mm_setr_epi16(3596, -3015, 3596, -3015, 3596, -3015, 3596, -3015);
+    const __m128i cvB = _mm_setr_epi16(-582, 16384, -582, 16384, -582, 16384, -582, 16384);
+    const __m128i offset = _mm_set1_epi16(128);
+
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m128i vr = averagePairs(r0 + 2 * j, r1 ? r1 + 2 * j : nullptr);
+        __m128i vg = averagePairs(g0 + 2 * j, g1 ? g1 + 2 * j : nullptr);
+        __m128i vb = averagePairs(b0 + 2 * j, b1 ? b1 + 2 * j : nullptr);
+        __m128i vu = _mm_add_epi16(weightedSum(vr, vg, vb, cuRG, cuB), offset);
+        __m128i vv = _mm_add_epi16(weightedSum(vr, vg, vb, cvRG, cvB), offset);
+        __m128i lo = _mm_unpacklo_epi16(vu, vv);
+        __m128i hi = _mm_unpackhi_epi16(vu, vv);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + 2 * j), _mm_packus_epi16(lo, hi));
+    }
+    return j;
+}
+#endif
+
+int SimdKernels::bilinearRow(unsigned char* dst, const unsigned char* row0,
+                             const unsigned char* row1, int count, int groupShift, int step,
+                             int offset, int scale, int dy, int limit) {
+#ifdef SIMD_X86
+    if (getSimdLevel() >= SIMD_LEVEL_AVX2 && groupShift == 2 && step == 4) {
+        return bilinearRowQuadAvx2(dst, row0, row1, count, offset, scale, dy, limit);
+    }
+    if (getSimdLevel() >= SIMD_LEVEL_AVX2 && step <= 2) {
+        return bilinearRowAvx2(dst, row0, row1, count, groupShift, step, offset, scale, dy,
+                               limit);
+    }
+#endif
+    return 0;
+}
+
+int SimdKernels::bilinearRowQ16(unsigned char* dst, const unsigned char* row0,
+                                const unsigned char* row1, int count, unsigned int sx0,
+                                unsigned int sxd, unsigned int fy, int limit) {
+#ifdef SIMD_X86
+    if (getSimdLevel() >= SIMD_LEVEL_AVX2) {
+        return bilinearRowQ16Avx2(dst, row0, row1, count, sx0, sxd, fy, limit);
+    }
+#endif
+    return 0;
+}
+
+int SimdKernels::average2x2Row(unsigned char* dst, const unsigned char* row0,
+                               const unsigned char* row1, int count, bool interleaved) {
+#ifdef SIMD_X86
+    if (getSimdLevel() >= SIMD_LEVEL_SSE42) {
+        return average2x2RowSse42(dst, row0, row1, count, interleaved);
+    }
+#endif
+    return 0;
+}
+
+int SimdKernels::swapBytePairsRow(unsigned char* dst, const unsigned char* src, int count) {
+#ifdef SIMD_X86
+    if (getSimdLevel() >= SIMD_LEVEL_SSE42) {
+        return swapBytePairsRowSse42(dst, src, count);
+    }
+#endif
+    return 0;
+}
+
+int SimdKernels::deinterleaveRow(unsigned char* even, unsigned char* odd, const unsigned char* src,
+                                 int count) {
+#ifdef SIMD_X86
+    if (getSimdLevel() >= SIMD_LEVEL_SSE42) {
+        return deinterleaveRowSse42(even, odd, src, count);
+    }
+#endif
+    return 0;
+}
+
+int SimdKernels::interleaveRow(unsigned char* dst, const unsigned char* even,
+                               const unsigned char* odd, int count) {
+#ifdef SIMD_X86
+    if (getSimdLevel() >= SIMD_LEVEL_SSE42) {
+        return interleaveRowSse42(dst, even, odd, count);
+    }
+#endif
+    return 0;
+}
+
+int SimdKernels::demosaicRow(short* own, short* g, short* other, const short* above,
+                             const short* cur, const short* below, int count, bool siteEven) {
+#ifdef SIMD_X86
+    if (getSimdLevel() >= SIMD_LEVEL_SSE42) {
+        return demosaicRowSse42(own, g, other, above, cur, below, count, siteEven);
+    }
+#endif
+    return 0;
+}
+
+int SimdKernels::rgbToYRow(unsigned char* y, const short* r, const short* g, const short* b,
+                           int count) {
+#ifdef SIMD_X86
+    if (getSimdLevel() >= SIMD_LEVEL_SSE42) {
+        return rgbToYRowSse42(y, r, g, b, count);
+    }
+#endif
+    return 0;
+}
+
+int SimdKernels::rgbToUVRow(unsigned char* uv, const short* r0, const short* g0, const short* b0,
+                            const short* r1, const short* g1, const short* b1, int count) {
+#ifdef SIMD_X86
+    if (getSimdLevel() >= SIMD_LEVEL_SSE42) {
+        return rgbToUVRowSse42(uv, r0, g0, b0, r1, g1, b1, count);
+    }
+#endif
+    return 0;
+}
+
+}  // namespace icamera
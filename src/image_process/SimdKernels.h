@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+namespace icamera {
+
+enum SimdLevel {
+    SIMD_LEVEL_NONE = 0,
+    SIMD_LEVEL_SSE42,
+    SIMD_LEVEL_AVX2,
+};
+
+/**
+ * \class SimdKernels
+ *
+ * Runtime dispatched SIMD row kernels for the SW image processing.
+ *
+ * Every kernel produces exactly the same output as the scalar code of its caller,
+ * which is kept as the reference. A kernel handles the head of a row and returns
+ * how many output bytes it has written, the caller finishes the rest with the
+ * scalar code. 0 is returned if the CPU doesn't support the kernel.
+ *
+ * Set the environment variable "cameraSimd" to 0 to run the scalar code only.
+ * tools/simd_kernels_check compares the kernels with the formulas below bit by bit.
+ */
+class SimdKernels {
+ public:
+    /**
+     * \brief Get the SIMD level of the CPU, it is detected only once.
+     */
+    static SimdLevel getSimdLevel();
+
+    /**
+     * \brief Bilinear interpolation with 8 bits fraction.
+     *
+     * For the output byte j, with g = j >> groupShift and c = j & ((1 << groupShift) - 1):
+     *   p = g * scale, dx = p & 0xff, x = ((p >> 8) + offset) * step + c
+     *   h(r) = (r[x] * (256 - dx) + r[x + step] * dx) >> 8
+     *   dst[j] = (h(row0) * (256 - dy) + h(row1) * dy) >> 8
+     * The source bytes beyond row0/row1 + limit are never read.
+     */
+    static int bilinearRow(unsigned char* dst, const unsigned char* row0,
+                           const unsigned char* row1, int count, int groupShift, int step,
+                           int offset, int scale, int dy, int limit);
+
+    /**
+     * \brief Bilinear interpolation with 16 bits fraction, sx = sx0 + j * sxd.
+     *
+     *   h(r) = (r[sx >> 16] * (65536 - fx) + r[(sx >> 16) + 1] * fx) >> 16
+     *   dst[j] = (h(row0) * (65536 - fy) + h(row1) * fy) >> 16
+     */
+    static int bilinearRowQ16(unsigned char* dst, const unsigned char* row0,
+                              const unsigned char* row1, int count, unsigned int sx0,
+                              unsigned int sxd, unsigned int fy, int limit);
+
+    /**
+     * \brief 2x2 average, dst[j] = (a + b + c + d + 2) / 4.
+     *
+     * The samples of one output byte are adjacent in each row if interleaved is false,
+     * otherwise they are 2 bytes apart (NV12 UV plane).
+     */
+    static int average2x2Row(unsigned char* dst, const unsigned char* row0,
+                             const unsigned char* row1, int count, bool interleaved);
+
+    /**
+     * \brief Swap the 2 bytes of every pair, such as UV to VU or YUYV to UYVY.
+     *
+     * count is the number of bytes, the returned count is even.
+     */
+    static int swapBytePairsRow(unsigned char* dst, const unsigned char* src, int count);
+
+    /**
+     * \brief Split byte pairs, even[j] = src[2 * j] and odd[j] = src[2 * j + 1].
+     *
+     * count is the number of pairs, even or odd can be nullptr if it isn't needed.
+     */
+    static int deinterleaveRow(unsigned char* even, unsigned char* odd, const unsigned char* src,
+                               int count);
+
+    /**
+     * \brief Merge 2 rows to byte pairs, dst[2 * j] = even[j] and dst[2 * j + 1] = odd[j].
+     *
+     * count is the number of pairs.
+     */
+    static int interleaveRow(unsigned char* dst, const unsigned char* even,
+                             const unsigned char* odd, int count);
+
+    /**
+     * \brief Bilinear demosaic of one Bayer line with 10 bits samples.
+     *
+     * above, cur and below point to the column 0 of 3 lines, the columns -1 and count are
+     * readable. The color site (R or B) of cur is at the even columns if siteEven, else odd.
+     * With h = (left + right + 1) >> 1, v = (up + down + 1) >> 1,
+     * cross = (left + right + up + down + 2) >> 2 and diag = 4 diagonals average in the same way:
+     *   color site: own = cur, g = cross, other = diag
+     *   G site:     own = h,   g = cur,   other = v
+     * own is the color of the site, R for the R/G lines and B for the G/B lines.
+     */
+    static int demosaicRow(short* own, short* g, short* other, const short* above,
+                           const short* cur, const short* below, int count, bool siteEven);
+
+    /**
+     * \brief Y of 10 bits RGB, y[j] = ((2105 * r + 4129 * g + 803 * b + 16384) >> 15) + 16.
+     */
+    static int rgbToYRow(unsigned char* y, const short* r, const short* g, const short* b,
+                         int count);
+
+    /**
+     * \brief Interleaved UV of 10 bits RGB, count is the number of UV pairs.
+     *
+     * The RGB of the 2x2 pixels of one pair are averaged, (sum + 2) >> 2, or the 2x1 pixels,
+     * (sum + 1) >> 1, if r1 is nullptr. Then with the average r, g and b:
+     *   u = ((-1212 * r - 2384 * g + 3596 * b + 16384) >> 15) + 128
+     *   v = ((3596 * r - 3015 * g - 582 * b + 16384) >> 15) + 128
+     */
+    static int rgbToUVRow(unsigned char* uv, const short* r0, const short* g0, const short* b0,
+                          const short* r1, const short* g1, const short* b1, int count);
+};
+
+}  // namespace icamera
@@ -18,9 +18,15 @@
 
 #include "SwImageConverter.h"
 
-#include "CameraLog.h"
-#include "Errors.h"
-#include "Utils.h"
+#include <algorithm>
+#include <vector>
+
+#include "ImageConverter.h"
+#include "SimdKernels.h"
+#include "iutils/CameraLog.h"
+#include "iutils/Errors.h"
+#include "iutils/ThreadPool.h"
+#include "iutils/Utils.h"
 
 namespace icamera {
 
@@ -414,18 +420,250 @@ void SwImageConverter::convertYuvBlock(unsigned int x, unsigned int y, unsigned
     }
 }
 
+// The packed and semi-planar YUV conversions are done by rows in ImageConverter
+static bool isRowConvertible(unsigned int fmt) {
+    return fmt == V4L2_PIX_FMT_NV12 || fmt == V4L2_PIX_FMT_YUYV || fmt == V4L2_PIX_FMT_UYVY;
+}
+
+// ImageConverter takes the stride of the first plane in pixels
+static int getPixelStride(unsigned int fmt, unsigned int width) {
+    int stride = CameraUtils::getStride(fmt, width);
+    return CameraUtils::isPlanarFormat(fmt) ? stride : stride * 8 / CameraUtils::getBpp(fmt);
+}
+
+// The layout of the unpacked Bayer formats
+struct BayerLayout {
+    bool redFirst;  // the first line is R/G and the second one is G/B, or the opposite
+    bool siteEven;  // the R or B samples of the first line are at the even columns
+    int shift;      // left shift to 10 bits, negative for right shift
+};
+
+static bool getBayerLayout(unsigned int fmt, BayerLayout* layout) {
+    switch (fmt) {
+        case V4L2_PIX_FMT_SRGGB8:
+        case V4L2_PIX_FMT_SRGGB10:
+        case V4L2_PIX_FMT_SRGGB12:
+            *layout = {true, true, 0};
+            break;
+        case V4L2_PIX_FMT_SGRBG8:
+        case V4L2_PIX_FMT_SGRBG10:
+        case V4L2_PIX_FMT_SGRBG12:
+            *layout = {true, false, 0};
+            break;
+        case V4L2_PIX_FMT_SGBRG8:
+        case V4L2_PIX_FMT_SGBRG10:
+        case V4L2_PIX_FMT_SGBRG12:
+            *layout = {false, false, 0};
+            break;
+        case V4L2_PIX_FMT_SBGGR8:
+        case V4L2_PIX_FMT_SBGGR10:
+        case V4L2_PIX_FMT_SBGGR12:
+            *layout = {false, true, 0};
+            break;
+        default:
+            return false;
+    }
+
+    switch (fmt) {
+        case V4L2_PIX_FMT_SRGGB8:
+        case V4L2_PIX_FMT_SGRBG8:
+        case V4L2_PIX_FMT_SGBRG8:
+        case V4L2_PIX_FMT_SBGGR8:
+            layout->shift = 2;
+            break;
+        case V4L2_PIX_FMT_SRGGB12:
+        case V4L2_PIX_FMT_SGRBG12:
+        case V4L2_PIX_FMT_SGBRG12:
+        case V4L2_PIX_FMT_SBGGR12:
+            layout->shift = -2;
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+static bool isBayerToYuvSupported(unsigned int srcFmt, unsigned int dstFmt, unsigned int width,
+                                  unsigned int height) {
+    BayerLayout layout;
+    if (!getBayerLayout(srcFmt, &layout)) return false;
+    if (dstFmt != V4L2_PIX_FMT_NV12 && dstFmt != V4L2_PIX_FMT_YUYV && dstFmt != V4L2_PIX_FMT_UYVY)
+        return false;
+
+    return width >= 2 && height >= 2 && width % 2 == 0 && height % 2 == 0;
+}
+
+// Load one Bayer line as 10 bits samples, line[0] and line[width + 1] are the mirrored
+// columns -1 and width, which have the same color as the columns 0 and width - 1.
+static void loadBayerLine(const unsigned char* inBuf, int srcStride, unsigned int srcFmt,
+                          const BayerLayout& layout, int width, int y, short* line) {
+    short* dst = line + 1;
+    if (CameraUtils::getBpp(srcFmt) == 8) {
+        const unsigned char* src = inBuf + y * srcStride;
+        for (int x = 0; x < width; x++) {
+            dst[x] = src[x] << layout.shift;
+        }
+    } else {
+        const unsigned short* src = reinterpret_cast<const unsigned short*>(inBuf + y * srcStride);
+        for (int x = 0; x < width; x++) {
+            int val = layout.shift >= 0 ? src[x] << layout.shift : src[x] >> -layout.shift;
+            dst[x] = val & 0x3ff;
+        }
+    }
+    line[0] = dst[1];
+    line[width + 1] = dst[width - 2];
+}
+
+static void demosaicLine(short* own, short* g, short* other, const short* above,
+                         const short* cur, const short* below, int width, bool siteEven) {
+    int x = SimdKernels::demosaicRow(own, g, other, above, cur, below, width, siteEven);
+    for (; x < width; x++) {
+        int lr = cur[x - 1] + cur[x + 1];
+        int ud = above[x] + below[x];
+        if (((x & 1) == 0) == siteEven) {
+            own[x] = cur[x];
+            g[x] = (lr + ud + 2) >> 2;
+            other[x] = (above[x - 1] + above[x + 1] + below[x - 1] + below[x + 1] + 2) >> 2;
+        } else {
+            own[x] = (lr + 1) >> 1;
+            g[x] = cur[x];
+            other[x] = (ud + 1) >> 1;
+        }
+    }
+}
+
+static inline unsigned char clampByte(int val) {
+    return static_cast<unsigned char>(std::min(std::max(val, 0), 255));
+}
+
+// The same BT.601 coefficients as RGB2YUV, in 15 bits fixed point
+static void rgbToYLine(unsigned char* y, const short* r, const short* g, const short* b,
+                       int width) {
+    int x = SimdKernels::rgbToYRow(y, r, g, b, width);
+    for (; x < width; x++) {
+        y[x] = clampByte(((2105 * r[x] + 4129 * g[x] + 803 * b[x] + 16384) >> 15) + 16);
+    }
+}
+
+static void rgbToUVLine(unsigned char* uv, const short* r0, const short* g0, const short* b0,
+                        const short* r1, const short* g1, const short* b1, int count) {
+    int j = SimdKernels::rgbToUVRow(uv, r0, g0, b0, r1, g1, b1, count);
+    for (; j < count; j++) {
+        int r = r0[2 * j] + r0[2 * j + 1];
+        int g = g0[2 * j] + g0[2 * j + 1];
+        int b = b0[2 * j] + b0[2 * j + 1];
+        if (r1) {
+            r = (r + r1[2 * j] + r1[2 * j + 1] + 2) >> 2;
+            g = (g + g1[2 * j] + g1[2 * j + 1] + 2) >> 2;
+            b = (b + b1[2 * j] + b1[2 * j + 1] + 2) >> 2;
+        } else {
+            r = (r + 1) >> 1;
+            g = (g + 1) >> 1;
+            b = (b + 1) >> 1;
+        }
+        uv[2 * j] = clampByte(((-1212 * r - 2384 * g + 3596 * b + 16384) >> 15) + 128);
+        uv[2 * j + 1] = clampByte(((3596 * r - 3015 * g - 582 * b + 16384) >> 15) + 128);
+    }
+}
+
+// Bilinear demosaic of the lines [start, end) fused with the RGB to YUV conversion, start
+// is even. The lines around are mirrored at the image borders to keep the Bayer order.
+static void convertBayerToYuvRows(unsigned int width, unsigned int height,
+                                  const unsigned char* inBuf, unsigned int srcFmt,
+                                  unsigned char* outBuf, unsigned int dstFmt, int start,
+                                  int end) {
+    BayerLayout layout;
+    getBayerLayout(srcFmt, &layout);
+    int w = width;
+    int h = height;
+    int srcStride = CameraUtils::getStride(srcFmt, width);
+    int dstStride = CameraUtils::getStride(dstFmt, width);
+
+    // The scratch lines are kept by the calling thread (the pool workers live as long as
+    // the process), so they're allocated only when a frame is wider than all before.
+    static thread_local std::vector<short> sLineBuffer;
+    static thread_local std::vector<unsigned char> sYuvLineBuffer;
+
+    const int lineSize = w + 2;
+    size_t bufferSize = lineSize * 4 + w * 6;
+    if (sLineBuffer.size() < bufferSize) sLineBuffer.resize(bufferSize);
+    short* buffer = sLineBuffer.data();
+    // lines[i] is the line y - 1 + i
+    short* lines[4];
+    for (int i = 0; i < 4; i++) {
+        lines[i] = buffer + lineSize * i;
+    }
+    // rgb[k] is the R, G and B of the line y + k
+    short* rgb[2][3];
+    for (int k = 0; k < 2; k++) {
+        for (int c = 0; c < 3; c++) {
+            rgb[k][c] = buffer + lineSize * 4 + w * (k * 3 + c);
+        }
+    }
+    unsigned char* yLine = nullptr;
+    unsigned char* uvLine = nullptr;
+    if (dstFmt != V4L2_PIX_FMT_NV12) {
+        if (sYuvLineBuffer.size() < static_cast<size_t>(w) * 2) sYuvLineBuffer.resize(w * 2);
+        yLine = sYuvLineBuffer.data();
+        uvLine = yLine + w;
+    }
+
+    auto mirror = [h](int y) { return y < 0 ? -y : (y >= h ? 2 * h - 2 - y : y); };
+    for (int y = start; y < end; y += 2) {
+        if (y == start) {
+            for (int i = 0; i < 4; i++) {
+                loadBayerLine(inBuf, srcStride, srcFmt, layout, w, mirror(y - 1 + i), lines[i]);
+            }
+        } else {
+            std::swap(lines[0], lines[2]);
+            std::swap(lines[1], lines[3]);
+            loadBayerLine(inBuf, srcStride, srcFmt, layout, w, mirror(y + 1), lines[2]);
+            loadBayerLine(inBuf, srcStride, srcFmt, layout, w, mirror(y + 2), lines[3]);
+        }
+
+        for (int k = 0; k < 2; k++) {
+            bool red = (k == 0) == layout.redFirst;
+            bool siteEven = (k == 0) == layout.siteEven;
+            demosaicLine(red ? rgb[k][0] : rgb[k][2], rgb[k][1], red ? rgb[k][2] : rgb[k][0],
+                         lines[k] + 1, lines[k + 1] + 1, lines[k + 2] + 1, w, siteEven);
+        }
+
+        if (dstFmt == V4L2_PIX_FMT_NV12) {
+            unsigned char* yPtr = outBuf + y * dstStride;
+            rgbToYLine(yPtr, rgb[0][0], rgb[0][1], rgb[0][2], w);
+            rgbToYLine(yPtr + dstStride, rgb[1][0], rgb[1][1], rgb[1][2], w);
+            rgbToUVLine(outBuf + dstStride * h + y / 2 * dstStride, rgb[0][0], rgb[0][1],
+                        rgb[0][2], rgb[1][0], rgb[1][1], rgb[1][2], w / 2);
+            continue;
+        }
+
+        // YUYV and UYVY have the UV of every line
+        bool yuyv = dstFmt == V4L2_PIX_FMT_YUYV;
+        for (int k = 0; k < 2; k++) {
+            unsigned char* dst = outBuf + (y + k) * dstStride;
+            rgbToYLine(yLine, rgb[k][0], rgb[k][1], rgb[k][2], w);
+            rgbToUVLine(uvLine, rgb[k][0], rgb[k][1], rgb[k][2], nullptr, nullptr, nullptr,
+                        w / 2);
+            int x = yuyv ? SimdKernels::interleaveRow(dst, yLine, uvLine, w)
+                         : SimdKernels::interleaveRow(dst, uvLine, yLine, w);
+            for (; x < w; x++) {
+                dst[x * 2 + (yuyv ? 0 : 1)] = yLine[x];
+                dst[x * 2 + (yuyv ? 1 : 0)] = uvLine[x];
+            }
+        }
+    }
+}
+
 int SwImageConverter::convertFormat(unsigned int width, unsigned int height, unsigned char* inBuf,
                                     unsigned int inLength, unsigned int srcFmt,
                                     unsigned char* outBuf, unsigned int outLength,
-                                    unsigned int dstFmt) {
+                                    unsigned int dstFmt, int parallelism) {
     CheckAndLogError((inBuf == nullptr || outBuf == nullptr), BAD_VALUE,
                      "Invalid input(%p) or output buffer(%p)", inBuf, outBuf);
 
-    unsigned int x, y;
-    unsigned short bayer_data[4];
-
-    LOG2("%s srcFmt %s => dstFmt %s %dx%d", __func__, CameraUtils::format2string(srcFmt).c_str(),
-         CameraUtils::format2string(dstFmt).c_str(), width, height);
+    LOG2("%s srcFmt %s => dstFmt %s %dx%d, parallelism %d", __func__,
+         CameraUtils::format2string(srcFmt).c_str(), CameraUtils::format2string(dstFmt).c_str(),
+         width, height, parallelism);
 
     if (dstFmt == srcFmt) {
         // No need do format convertion.
@@ -434,29 +672,51 @@ int SwImageConverter::convertFormat(unsigned int width, unsigned int height, uns
         return 0;
     }
 
+    if (isRowConvertible(srcFmt) && isRowConvertible(dstFmt) &&
+        ImageConverter::isConversionSupported(srcFmt, dstFmt)) {
+        return ImageConverter::convertImage(srcFmt, dstFmt, width, height,
+                                            getPixelStride(srcFmt, width),
+                                            getPixelStride(dstFmt, width), inBuf, outBuf,
+                                            parallelism);
+    }
+
+    if (isBayerToYuvSupported(srcFmt, dstFmt, width, height)) {
+        ThreadPool::forEachBand(height, parallelism, 2, [&](int start, int end) {
+            convertBayerToYuvRows(width, height, inBuf, srcFmt, outBuf, dstFmt, start, end);
+        });
+        return 0;
+    }
+
     // for not vector raw
     int srcStride = CameraUtils::getStride(srcFmt, width);
-    for (y = 0; y < height; y += 2) {
-        for (x = 0; x < width; x += 2) {
-            if (CameraUtils::isRaw(srcFmt)) {
-                if (CameraUtils::getBpp(srcFmt) == 8) {
-                    bayer_data[0] = inBuf[y * srcStride + x];
-                    bayer_data[1] = inBuf[y * srcStride + x + 1];
-                    bayer_data[2] = inBuf[(y + 1) * srcStride + x];
-                    bayer_data[3] = inBuf[(y + 1) * srcStride + x + 1];
+    // The 2x2 blocks of different block lines don't share output, so the bands of even
+    // lines can be converted at the same time.
+    auto convertRows = [&](int start, int end) {
+        unsigned short bayer_data[4];
+        for (unsigned int y = start; y < static_cast<unsigned int>(end); y += 2) {
+            for (unsigned int x = 0; x < width; x += 2) {
+                if (CameraUtils::isRaw(srcFmt)) {
+                    if (CameraUtils::getBpp(srcFmt) == 8) {
+                        bayer_data[0] = inBuf[y * srcStride + x];
+                        bayer_data[1] = inBuf[y * srcStride + x + 1];
+                        bayer_data[2] = inBuf[(y + 1) * srcStride + x];
+                        bayer_data[3] = inBuf[(y + 1) * srcStride + x + 1];
+                    } else {
+                        int offset = srcStride / (CameraUtils::getBpp(srcFmt) / 8);
+                        bayer_data[0] = *((unsigned short*)inBuf + y * offset + x);
+                        bayer_data[1] = *((unsigned short*)inBuf + y * offset + x + 1);
+                        bayer_data[2] = *((unsigned short*)inBuf + (y + 1) * offset + x);
+                        bayer_data[3] = *((unsigned short*)inBuf + (y + 1) * offset + x + 1);
+                    }
+                    convertBayerBlock(x, y, width, height, bayer_data, outBuf, srcFmt, dstFmt);
                 } else {
-                    int offset = srcStride / (CameraUtils::getBpp(srcFmt) / 8);
-                    bayer_data[0] = *((unsigned short*)inBuf + y * offset + x);
-                    bayer_data[1] = *((unsigned short*)inBuf + y * offset + x + 1);
-                    bayer_data[2] = *((unsigned short*)inBuf + (y + 1) * offset + x);
-                    bayer_data[3] = *((unsigned short*)inBuf + (y + 1) * offset + x + 1);
+                    convertYuvBlock(x, y, width, height, inBuf, outBuf, srcFmt, dstFmt);
                 }
-                convertBayerBlock(x, y, width, height, bayer_data, outBuf, srcFmt, dstFmt);
-            } else {
-                convertYuvBlock(x, y, width, height, inBuf, outBuf, srcFmt, dstFmt);
             }
         }
-    }
+    };
+
+    ThreadPool::forEachBand(height, parallelism, 2, convertRows);
     return 0;
 }
 
@@ -33,10 +33,12 @@ void convertYuvBlock(unsigned int x, unsigned int y, unsigned int width, unsigne
                      unsigned char* in_buf, unsigned char* out_buf, unsigned int src_fmt,
                      unsigned int dst_fmt);
 
-// convert the buffer from the src_fmt to the dst_fmt
+// convert the buffer from the src_fmt to the dst_fmt, the rows are split into bands
+// and converted by at most parallelism threads, 0 means using all the pool workers.
+// The unpacked Bayer formats are demosaiced bilinearly to NV12, YUYV and UYVY.
 int convertFormat(unsigned int width, unsigned int height, unsigned char* inBuf,
                   unsigned int inLength, unsigned int srcFmt, unsigned char* outBuf,
-                  unsigned int outLength, unsigned int dstFmt);
+                  unsigned int outLength, unsigned int dstFmt, int parallelism = 1);
 }  // namespace SwImageConverter
 
 }  // namespace icamera
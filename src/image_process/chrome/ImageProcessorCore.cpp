@@ -18,8 +18,11 @@
 
 #include "ImageProcessorCore.h"
 
+#include <atomic>
+
 #include "ImageConverter.h"
 #include "iutils/CameraLog.h"
+#include "iutils/ThreadPool.h"
 
 namespace icamera {
 
@@ -139,16 +142,33 @@ status_t ImageProcessorCore::rotateFrame(const std::shared_ptr<camera3::Camera3B
         libyuv::CopyPlane(inBuffer + inH * inStride, inStride, outBuffer + outH * outStride,
                           outStride, inW, inH / 2);
     } else {
-        int ret = libyuv::NV12ToI420Rotate(inBuffer, inStride, inBuffer + inH * inStride, inStride,
-                                           I420Buffer, outW, I420Buffer + outW * outH, outW / 2,
-                                           I420Buffer + outW * outH * 5 / 4, outW / 2, inW, inH,
-                                           mRotationMode[angle]);
-        CheckAndLogError((ret < 0), UNKNOWN_ERROR, "NV12ToI420Rotate failed [%d]", ret);
-
-        ret = libyuv::I420ToNV12(I420Buffer, outW, I420Buffer + outW * outH, outW / 2,
-                                 I420Buffer + outW * outH * 5 / 4, outW / 2, outBuffer, outStride,
-                                 outBuffer + outStride * outH, outStride, outW, outH);
-        CheckAndLogError((ret < 0), UNKNOWN_ERROR, "I420ToNV12 failed [%d]", ret);
+        libyuv::RotationMode mode = mRotationMode[angle];
+        uint8_t* I420BufferU = I420Buffer + outW * outH;
+        uint8_t* I420BufferV = I420Buffer + outW * outH * 5 / 4;
+        std::atomic<int> ret(0);
+
+        // The input line bands are rotated to the output column bands, with 90 degree the
+        // last input line is the first output column.
+        ThreadPool::forEachBand(inH, mParallelism, 2, [&](int start, int end) {
+            int col = (mode == libyuv::RotationMode::kRotate90) ? inH - end : start;
+            int r = libyuv::NV12ToI420Rotate(
+                inBuffer + start * inStride, inStride, inBuffer + (inH + start / 2) * inStride,
+                inStride, I420Buffer + col, outW, I420BufferU + col / 2, outW / 2,
+                I420BufferV + col / 2, outW / 2, inW, end - start, mode);
+            if (r < 0) ret = r;
+        });
+        CheckAndLogError((ret < 0), UNKNOWN_ERROR, "NV12ToI420Rotate failed [%d]", ret.load());
+
+        ThreadPool::forEachBand(outH, mParallelism, 2, [&](int start, int end) {
+            int r = libyuv::I420ToNV12(I420Buffer + start * outW, outW,
+                                       I420BufferU + (start / 2) * (outW / 2), outW / 2,
+                                       I420BufferV + (start / 2) * (outW / 2), outW / 2,
+                                       outBuffer + start * outStride, outStride,
+                                       outBuffer + (outH + start / 2) * outStride, outStride, outW,
+                                       end - start);
+            if (r < 0) ret = r;
+        });
+        CheckAndLogError((ret < 0), UNKNOWN_ERROR, "I420ToNV12 failed [%d]", ret.load());
     }
 
     return OK;
@@ -159,29 +179,11 @@ status_t ImageProcessorCore::convertFrame(const std::shared_ptr<camera3::Camera3
     LOG2("%s: src: %dx%d,format 0x%x, dest: %dx%d format 0x%x", __func__, input->width(),
          input->height(), input->v4l2Fmt(), output->width(), output->height(), output->v4l2Fmt());
 
-    switch (output->v4l2Fmt()) {
-        case V4L2_PIX_FMT_YVU420:
-            // XXX -> YV12
-            ImageConverter::convertBuftoYV12(input->v4l2Fmt(), input->width(), input->height(),
-                                             input->stride(), output->stride(), input->data(),
-                                             output->data());
-            break;
-        case V4L2_PIX_FMT_NV21:
-            // XXX -> NV21
-            ImageConverter::convertBuftoNV21(input->v4l2Fmt(), input->width(), input->height(),
-                                             input->stride(), output->stride(), input->data(),
-                                             output->data());
-            break;
-        case V4L2_PIX_FMT_YUYV:
-            // XXX -> YUYV
-            ImageConverter::convertBuftoYUYV(input->v4l2Fmt(), input->width(), input->height(),
-                                             input->stride(), output->stride(), input->data(),
-                                             output->data());
-            break;
-        default:
-            LOGE("Not implement conversion 0x%x -> 0x%x!", input->v4l2Fmt(), output->v4l2Fmt());
-            return UNKNOWN_ERROR;
-    }
+    int ret = ImageConverter::convertImage(input->v4l2Fmt(), output->v4l2Fmt(), input->width(),
+                                           input->height(), input->stride(), output->stride(),
+                                           input->data(), output->data(), mParallelism);
+    CheckAndLogError(ret != OK, UNKNOWN_ERROR, "Not implement conversion 0x%x -> 0x%x!",
+                     input->v4l2Fmt(), output->v4l2Fmt());
 
     return OK;
 }
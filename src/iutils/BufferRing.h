@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace icamera {
+
+/**
+ * BufferRing is an unbounded FIFO with a lock-free fast path.
+ *
+ * Any number of threads may push concurrently, while front/pop must be
+ * serialized by the consumer (the BufferQueue users already hold their queue
+ * lock there). The ring slots are allocated at construction time, so push and
+ * pop don't touch the heap while the ring has room.
+ *
+ * When the ring is full, the items spill into a locked overflow list, and the
+ * later pushes go there too until the consumer drains it, so the items of one
+ * producer keep their order.
+ *
+ * The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class BufferRing {
+ public:
+    static const size_t kDefaultCapacity = 64;
+
+    explicit BufferRing(size_t capacity = kDefaultCapacity) : mMask(0), mHead(HEAD_NONE) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+
+        mMask = size - 1;
+        mCells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++) {
+            mCells[i].seq.store(i, std::memory_order_relaxed);
+        }
+        mEnqueuePos.store(0, std::memory_order_relaxed);
+        mDequeuePos.store(0, std::memory_order_relaxed);
+        mOverflowSize.store(0, std::memory_order_relaxed);
+    }
+
+    ~BufferRing() {}
+
+    /**
+     * \brief Push one item to the tail, safe to be called from multiple threads.
+     */
+    void push(const T& item) {
+        if (mOverflowSize.load(std::memory_order_acquire) == 0 && pushRing(item)) return;
+
+        std::lock_guard<std::mutex> l(mOverflowLock);
+        mOverflow.push_back(item);
+        mOverflowSize.store(mOverflow.size(), std::memory_order_release);
+    }
+
+    /**
+     * \brief Check if there is no published item. Consumer side only.
+     */
+    bool empty() const { return locateHead() == HEAD_NONE; }
+
+    /**
+     * \brief Number of items, including the ring slots being filled by producers.
+     */
+    size_t size() const {
+        return mEnqueuePos.load(std::memory_order_acquire) -
+               mDequeuePos.load(std::memory_order_acquire) +
+               mOverflowSize.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return mMask + 1; }
+
+    /**
+     * \brief Access the head item. Consumer side only, it MUST NOT be empty.
+     */
+    T& front() {
+        if (locateHead() == HEAD_RING) {
+            return mCells[mDequeuePos.load(std::memory_order_relaxed) & mMask].data;
+        }
+
+        // The overflow items stay in place when others are pushed behind them.
+        std::lock_guard<std::mutex> l(mOverflowLock);
+        return mOverflow.front();
+    }
+
+    /**
+     * \brief Remove the head item. Consumer side only, it MUST NOT be empty.
+     */
+    void pop() {
+        if (locateHead() == HEAD_RING) {
+            size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+            Cell& cell = mCells[pos & mMask];
+            cell.data = T();
+            cell.seq.store(pos + mMask + 1, std::memory_order_release);
+            mDequeuePos.store(pos + 1, std::memory_order_release);
+        } else {
+            std::lock_guard<std::mutex> l(mOverflowLock);
+            mOverflow.pop_front();
+            mOverflowSize.store(mOverflow.size(), std::memory_order_release);
+        }
+        mHead = HEAD_NONE;
+    }
+
+    /**
+     * \brief Remove the items pushed before it's called. Consumer side only.
+     *
+     * The ring is kept, so producers can push to it at the same time, and the items they push
+     * meanwhile may stay.
+     */
+    void clear() {
+        for (size_t count = size(); count > 0 && !empty(); count--) pop();
+    }
+
+ private:
+    BufferRing(const BufferRing&) = delete;
+    BufferRing& operator=(const BufferRing&) = delete;
+
+    bool pushRing(const T& item) {
+        Cell* cell = nullptr;
+        size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &mCells[pos & mMask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = item;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    enum Head {
+        HEAD_NONE,
+        HEAD_RING,
+        HEAD_OVERFLOW,
+    };
+
+    /*
+     * The ring items are older than the overflow ones of the same producer. Once the head is
+     * found, it's kept until pop(), so front() and pop() agree even if a producer publishes
+     * to the ring in between.
+     */
+    Head locateHead() const {
+        if (mHead != HEAD_NONE) return mHead;
+
+        size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+        const Cell& cell = mCells[pos & mMask];
+        if (cell.seq.load(std::memory_order_acquire) == pos + 1) {
+            mHead = HEAD_RING;
+        } else if (mOverflowSize.load(std::memory_order_acquire) > 0) {
+            mHead = HEAD_OVERFLOW;
+        }
+        return mHead;
+    }
+
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> mCells;
+    size_t mMask;
+    std::atomic<size_t> mEnqueuePos;
+    std::atomic<size_t> mDequeuePos;
+
+    std::mutex mOverflowLock;  // protect mOverflow
+    std::deque<T> mOverflow;
+    std::atomic<size_t> mOverflowSize;
+    mutable Head mHead;  // consumer side only
+};
+
+}  // namespace icamera
@@ -74,6 +74,7 @@ const char* tagNames[] = {
     "CameraStream",
     "Camera_PolicyManager",
     "CaptureUnit",
+    "CiprBufferRegistry",
     "ColorConverter",
     "CsiMetaDevice",
     "Customized3A",
@@ -192,18 +193,22 @@ const char* tagNames[] = {
     "SensorManager",
     "SensorOB",
     "ShareRefer",
+    "SimdKernels",
     "SofSource",
     "StreamBuffer",
     "SwImageConverter",
     "SwImageProcessor",
     "SyncManager",
     "SysCall",
+    "SysCallTrace",
     "TCPServer",
     "Thread",
+    "ThreadPool",
     "Trace",
     "TunningParser",
     "Utils",
     "V4l2DeviceFactory",
+    "V4l2EventReactor",
     "V4l2_device_cc",
     "V4l2_subdevice_cc",
     "V4l2_video_node_cc",
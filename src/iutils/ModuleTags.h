@@ -82,149 +82,154 @@ enum ModuleTags {
       GENERATED_TAGS_CameraStream = 52,
       GENERATED_TAGS_Camera_PolicyManager = 53,
       GENERATED_TAGS_CaptureUnit = 54,
-      GENERATED_TAGS_ColorConverter = 55,
-      GENERATED_TAGS_CsiMetaDevice = 56,
-      GENERATED_TAGS_Customized3A = 57,
-      GENERATED_TAGS_CustomizedAic = 58,
-      GENERATED_TAGS_CvfPrivacyChecker = 59,
-      GENERATED_TAGS_DLCClient = 60,
-      GENERATED_TAGS_DeviceBase = 61,
-      GENERATED_TAGS_Dvs = 62,
-      GENERATED_TAGS_EXIFMaker = 63,
-      GENERATED_TAGS_EXIFMetaData = 64,
-      GENERATED_TAGS_ExifCreater = 65,
-      GENERATED_TAGS_FaceDetection = 66,
-      GENERATED_TAGS_FaceDetectionPVL = 67,
-      GENERATED_TAGS_FaceDetectionResultCallbackManager = 68,
-      GENERATED_TAGS_FaceSSD = 69,
-      GENERATED_TAGS_FileSource = 70,
-      GENERATED_TAGS_GPUExecutor = 71,
-      GENERATED_TAGS_GenGfx = 72,
-      GENERATED_TAGS_GfxGen = 73,
-      GENERATED_TAGS_GraphConfig = 74,
-      GENERATED_TAGS_GraphConfigImpl = 75,
-      GENERATED_TAGS_GraphConfigImplClient = 76,
-      GENERATED_TAGS_GraphConfigManager = 77,
-      GENERATED_TAGS_GraphConfigPipe = 78,
-      GENERATED_TAGS_GraphConfigServer = 79,
-      GENERATED_TAGS_GraphUtils = 80,
-      GENERATED_TAGS_HAL_FACE_DETECTION_TEST = 81,
-      GENERATED_TAGS_HAL_basic = 82,
-      GENERATED_TAGS_HAL_jpeg = 83,
-      GENERATED_TAGS_HAL_multi_streams_test = 84,
-      GENERATED_TAGS_HAL_rotation_test = 85,
-      GENERATED_TAGS_HAL_yuv = 86,
-      GENERATED_TAGS_HalAdaptor = 87,
-      GENERATED_TAGS_HalV3Utils = 88,
-      GENERATED_TAGS_I3AControlFactory = 89,
-      GENERATED_TAGS_IA_CIPR_UTILS = 90,
-      GENERATED_TAGS_ICBMThread = 91,
-      GENERATED_TAGS_ICamera = 92,
-      GENERATED_TAGS_IFaceDetection = 93,
-      GENERATED_TAGS_IPCIntelPGParam = 94,
-      GENERATED_TAGS_IPC_FACE_DETECTION = 95,
-      GENERATED_TAGS_IPC_GRAPH_CONFIG = 96,
-      GENERATED_TAGS_ImageProcessorCore = 97,
-      GENERATED_TAGS_ImageScalerCore = 98,
-      GENERATED_TAGS_Intel3AParameter = 99,
-      GENERATED_TAGS_IntelAEStateMachine = 100,
-      GENERATED_TAGS_IntelAFStateMachine = 101,
-      GENERATED_TAGS_IntelAWBStateMachine = 102,
-      GENERATED_TAGS_IntelAlgoClient = 103,
-      GENERATED_TAGS_IntelAlgoCommonClient = 104,
-      GENERATED_TAGS_IntelAlgoServer = 105,
-      GENERATED_TAGS_IntelCPUAlgoServer = 106,
-      GENERATED_TAGS_IntelCca = 107,
-      GENERATED_TAGS_IntelCcaClient = 108,
-      GENERATED_TAGS_IntelCcaServer = 109,
-      GENERATED_TAGS_IntelFDServer = 110,
-      GENERATED_TAGS_IntelFaceDetection = 111,
-      GENERATED_TAGS_IntelFaceDetectionClient = 112,
-      GENERATED_TAGS_IntelGPUAlgoServer = 113,
-      GENERATED_TAGS_IntelICBM = 114,
-      GENERATED_TAGS_IntelICBMClient = 115,
-      GENERATED_TAGS_IntelICBMServer = 116,
-      GENERATED_TAGS_IntelPGParam = 117,
-      GENERATED_TAGS_IntelPGParamClient = 118,
-      GENERATED_TAGS_IntelPGParamS = 119,
-      GENERATED_TAGS_IntelTNR7US = 120,
-      GENERATED_TAGS_IntelTNR7USClient = 121,
-      GENERATED_TAGS_IntelTNRServer = 122,
-      GENERATED_TAGS_IspControlUtils = 123,
-      GENERATED_TAGS_IspParamAdaptor = 124,
-      GENERATED_TAGS_JpegEncoderCore = 125,
-      GENERATED_TAGS_JpegMaker = 126,
-      GENERATED_TAGS_LensHw = 127,
-      GENERATED_TAGS_LensManager = 128,
-      GENERATED_TAGS_LiveTuning = 129,
-      GENERATED_TAGS_Ltm = 130,
-      GENERATED_TAGS_MANUAL_POST_PROCESSING = 131,
-      GENERATED_TAGS_MakerNote = 132,
-      GENERATED_TAGS_MediaControl = 133,
-      GENERATED_TAGS_MetadataConvert = 134,
-      GENERATED_TAGS_MockCamera3HAL = 135,
-      GENERATED_TAGS_MockCameraHal = 136,
-      GENERATED_TAGS_MockSysCall = 137,
-      GENERATED_TAGS_MsgHandler = 138,
-      GENERATED_TAGS_OnePunchIC2 = 139,
-      GENERATED_TAGS_OpenSourceGFX = 140,
-      GENERATED_TAGS_PGCommon = 141,
-      GENERATED_TAGS_PGUtils = 142,
-      GENERATED_TAGS_PSysDAG = 143,
-      GENERATED_TAGS_PSysPipe = 144,
-      GENERATED_TAGS_PSysProcessor = 145,
-      GENERATED_TAGS_ParameterGenerator = 146,
-      GENERATED_TAGS_ParameterHelper = 147,
-      GENERATED_TAGS_ParameterResult = 148,
-      GENERATED_TAGS_Parameters = 149,
-      GENERATED_TAGS_ParserBase = 150,
-      GENERATED_TAGS_PipeExecutor = 151,
-      GENERATED_TAGS_PipeLiteExecutor = 152,
-      GENERATED_TAGS_PlatformData = 153,
-      GENERATED_TAGS_PnpDebugControl = 154,
-      GENERATED_TAGS_PolicyParser = 155,
-      GENERATED_TAGS_PostProcessor = 156,
-      GENERATED_TAGS_PostProcessorBase = 157,
-      GENERATED_TAGS_PostProcessorCore = 158,
-      GENERATED_TAGS_PrivacyControl = 159,
-      GENERATED_TAGS_PrivateStream = 160,
-      GENERATED_TAGS_ProcessorManager = 161,
-      GENERATED_TAGS_RequestManager = 162,
-      GENERATED_TAGS_RequestThread = 163,
-      GENERATED_TAGS_ResultProcessor = 164,
-      GENERATED_TAGS_SWJpegEncoder = 165,
-      GENERATED_TAGS_SWPostProcessor = 166,
-      GENERATED_TAGS_SchedPolicy = 167,
-      GENERATED_TAGS_Scheduler = 168,
-      GENERATED_TAGS_SensorHwCtrl = 169,
-      GENERATED_TAGS_SensorManager = 170,
-      GENERATED_TAGS_SensorOB = 171,
-      GENERATED_TAGS_ShareRefer = 172,
-      GENERATED_TAGS_SofSource = 173,
-      GENERATED_TAGS_StreamBuffer = 174,
-      GENERATED_TAGS_SwImageConverter = 175,
-      GENERATED_TAGS_SwImageProcessor = 176,
-      GENERATED_TAGS_SyncManager = 177,
-      GENERATED_TAGS_SysCall = 178,
-      GENERATED_TAGS_TCPServer = 179,
-      GENERATED_TAGS_Thread = 180,
-      GENERATED_TAGS_Trace = 181,
-      GENERATED_TAGS_TunningParser = 182,
-      GENERATED_TAGS_Utils = 183,
-      GENERATED_TAGS_V4l2DeviceFactory = 184,
-      GENERATED_TAGS_V4l2_device_cc = 185,
-      GENERATED_TAGS_V4l2_subdevice_cc = 186,
-      GENERATED_TAGS_V4l2_video_node_cc = 187,
-      GENERATED_TAGS_VendorTags = 188,
-      GENERATED_TAGS_camera_metadata_tests = 189,
-      GENERATED_TAGS_icamera_metadata_base = 190,
-      GENERATED_TAGS_metadata_test = 191,
-      ST_FPS = 192,
-      ST_GPU_TNR = 193,
-      ST_STATS = 194,
+      GENERATED_TAGS_CiprBufferRegistry = 55,
+      GENERATED_TAGS_ColorConverter = 56,
+      GENERATED_TAGS_CsiMetaDevice = 57,
+      GENERATED_TAGS_Customized3A = 58,
+      GENERATED_TAGS_CustomizedAic = 59,
+      GENERATED_TAGS_CvfPrivacyChecker = 60,
+      GENERATED_TAGS_DLCClient = 61,
+      GENERATED_TAGS_DeviceBase = 62,
+      GENERATED_TAGS_Dvs = 63,
+      GENERATED_TAGS_EXIFMaker = 64,
+      GENERATED_TAGS_EXIFMetaData = 65,
+      GENERATED_TAGS_ExifCreater = 66,
+      GENERATED_TAGS_FaceDetection = 67,
+      GENERATED_TAGS_FaceDetectionPVL = 68,
+      GENERATED_TAGS_FaceDetectionResultCallbackManager = 69,
+      GENERATED_TAGS_FaceSSD = 70,
+      GENERATED_TAGS_FileSource = 71,
+      GENERATED_TAGS_GPUExecutor = 72,
+      GENERATED_TAGS_GenGfx = 73,
+      GENERATED_TAGS_GfxGen = 74,
+      GENERATED_TAGS_GraphConfig = 75,
+      GENERATED_TAGS_GraphConfigImpl = 76,
+      GENERATED_TAGS_GraphConfigImplClient = 77,
+      GENERATED_TAGS_GraphConfigManager = 78,
+      GENERATED_TAGS_GraphConfigPipe = 79,
+      GENERATED_TAGS_GraphConfigServer = 80,
+      GENERATED_TAGS_GraphUtils = 81,
+      GENERATED_TAGS_HAL_FACE_DETECTION_TEST = 82,
+      GENERATED_TAGS_HAL_basic = 83,
+      GENERATED_TAGS_HAL_jpeg = 84,
+      GENERATED_TAGS_HAL_multi_streams_test = 85,
+      GENERATED_TAGS_HAL_rotation_test = 86,
+      GENERATED_TAGS_HAL_yuv = 87,
+      GENERATED_TAGS_HalAdaptor = 88,
+      GENERATED_TAGS_HalV3Utils = 89,
+      GENERATED_TAGS_I3AControlFactory = 90,
+      GENERATED_TAGS_IA_CIPR_UTILS = 91,
+      GENERATED_TAGS_ICBMThread = 92,
+      GENERATED_TAGS_ICamera = 93,
+      GENERATED_TAGS_IFaceDetection = 94,
+      GENERATED_TAGS_IPCIntelPGParam = 95,
+      GENERATED_TAGS_IPC_FACE_DETECTION = 96,
+      GENERATED_TAGS_IPC_GRAPH_CONFIG = 97,
+      GENERATED_TAGS_ImageProcessorCore = 98,
+      GENERATED_TAGS_ImageScalerCore = 99,
+      GENERATED_TAGS_Intel3AParameter = 100,
+      GENERATED_TAGS_IntelAEStateMachine = 101,
+      GENERATED_TAGS_IntelAFStateMachine = 102,
+      GENERATED_TAGS_IntelAWBStateMachine = 103,
+      GENERATED_TAGS_IntelAlgoClient = 104,
+      GENERATED_TAGS_IntelAlgoCommonClient = 105,
+      GENERATED_TAGS_IntelAlgoServer = 106,
+      GENERATED_TAGS_IntelCPUAlgoServer = 107,
+      GENERATED_TAGS_IntelCca = 108,
+      GENERATED_TAGS_IntelCcaClient = 109,
+      GENERATED_TAGS_IntelCcaServer = 110,
+      GENERATED_TAGS_IntelFDServer = 111,
+      GENERATED_TAGS_IntelFaceDetection = 112,
+      GENERATED_TAGS_IntelFaceDetectionClient = 113,
+      GENERATED_TAGS_IntelGPUAlgoServer = 114,
+      GENERATED_TAGS_IntelICBM = 115,
+      GENERATED_TAGS_IntelICBMClient = 116,
+      GENERATED_TAGS_IntelICBMServer = 117,
+      GENERATED_TAGS_IntelPGParam = 118,
+      GENERATED_TAGS_IntelPGParamClient = 119,
+      GENERATED_TAGS_IntelPGParamS = 120,
+      GENERATED_TAGS_IntelTNR7US = 121,
+      GENERATED_TAGS_IntelTNR7USClient = 122,
+      GENERATED_TAGS_IntelTNRServer = 123,
+      GENERATED_TAGS_IspControlUtils = 124,
+      GENERATED_TAGS_IspParamAdaptor = 125,
+      GENERATED_TAGS_JpegEncoderCore = 126,
+      GENERATED_TAGS_JpegMaker = 127,
+      GENERATED_TAGS_LensHw = 128,
+      GENERATED_TAGS_LensManager = 129,
+      GENERATED_TAGS_LiveTuning = 130,
+      GENERATED_TAGS_Ltm = 131,
+      GENERATED_TAGS_MANUAL_POST_PROCESSING = 132,
+      GENERATED_TAGS_MakerNote = 133,
+      GENERATED_TAGS_MediaControl = 134,
+      GENERATED_TAGS_MetadataConvert = 135,
+      GENERATED_TAGS_MockCamera3HAL = 136,
+      GENERATED_TAGS_MockCameraHal = 137,
+      GENERATED_TAGS_MockSysCall = 138,
+      GENERATED_TAGS_MsgHandler = 139,
+      GENERATED_TAGS_OnePunchIC2 = 140,
+      GENERATED_TAGS_OpenSourceGFX = 141,
+      GENERATED_TAGS_PGCommon = 142,
+      GENERATED_TAGS_PGUtils = 143,
+      GENERATED_TAGS_PSysDAG = 144,
+      GENERATED_TAGS_PSysPipe = 145,
+      GENERATED_TAGS_PSysProcessor = 146,
+      GENERATED_TAGS_ParameterGenerator = 147,
+      GENERATED_TAGS_ParameterHelper = 148,
+      GENERATED_TAGS_ParameterResult = 149,
+      GENERATED_TAGS_Parameters = 150,
+      GENERATED_TAGS_ParserBase = 151,
+      GENERATED_TAGS_PipeExecutor = 152,
+      GENERATED_TAGS_PipeLiteExecutor = 153,
+      GENERATED_TAGS_PlatformData = 154,
+      GENERATED_TAGS_PnpDebugControl = 155,
+      GENERATED_TAGS_PolicyParser = 156,
+      GENERATED_TAGS_PostProcessor = 157,
+      GENERATED_TAGS_PostProcessorBase = 158,
+      GENERATED_TAGS_PostProcessorCore = 159,
+      GENERATED_TAGS_PrivacyControl = 160,
+      GENERATED_TAGS_PrivateStream = 161,
+      GENERATED_TAGS_ProcessorManager = 162,
+      GENERATED_TAGS_RequestManager = 163,
+      GENERATED_TAGS_RequestThread = 164,
+      GENERATED_TAGS_ResultProcessor = 165,
+      GENERATED_TAGS_SWJpegEncoder = 166,
+      GENERATED_TAGS_SWPostProcessor = 167,
+      GENERATED_TAGS_SchedPolicy = 168,
+      GENERATED_TAGS_Scheduler = 169,
+      GENERATED_TAGS_SensorHwCtrl = 170,
+      GENERATED_TAGS_SensorManager = 171,
+      GENERATED_TAGS_SensorOB = 172,
+      GENERATED_TAGS_ShareRefer = 173,
+      GENERATED_TAGS_SimdKernels = 174,
+      GENERATED_TAGS_SofSource = 175,
+      GENERATED_TAGS_StreamBuffer = 176,
+      GENERATED_TAGS_SwImageConverter = 177,
+      GENERATED_TAGS_SwImageProcessor = 178,
+      GENERATED_TAGS_SyncManager = 179,
+      GENERATED_TAGS_SysCall = 180,
+      GENERATED_TAGS_SysCallTrace = 181,
+      GENERATED_TAGS_TCPServer = 182,
+      GENERATED_TAGS_Thread = 183,
+      GENERATED_TAGS_ThreadPool = 184,
+      GENERATED_TAGS_Trace = 185,
+      GENERATED_TAGS_TunningParser = 186,
+      GENERATED_TAGS_Utils = 187,
+      GENERATED_TAGS_V4l2DeviceFactory = 188,
+      GENERATED_TAGS_V4l2EventReactor = 189,
+      GENERATED_TAGS_V4l2_device_cc = 190,
+      GENERATED_TAGS_V4l2_subdevice_cc = 191,
+      GENERATED_TAGS_V4l2_video_node_cc = 192,
+      GENERATED_TAGS_VendorTags = 193,
+      GENERATED_TAGS_camera_metadata_tests = 194,
+      GENERATED_TAGS_icamera_metadata_base = 195,
+      GENERATED_TAGS_metadata_test = 196,
+      ST_FPS = 197,
+      ST_GPU_TNR = 198,
+      ST_STATS = 199,
 };
 
-#define TAGS_MAX_NUM 195
+#define TAGS_MAX_NUM 200
 
 #endif
 // !!! DO NOT EDIT THIS FILE !!!
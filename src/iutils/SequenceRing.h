@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace icamera {
+
+/**
+ * SequenceRing stores up to N values keyed by frame sequence.
+ *
+ * The value of one sequence lives in slot (sequence % N), or in the next free slot after it if
+ * that one is taken, so find/insert/erase are O(1) for the sequences that come in order and no
+ * memory is allocated after construction. Inserting into a full ring evicts the oldest
+ * sequence, which replaces the manual "erase begin() when too big" trimming of std::map.
+ *
+ * oldest/latest/findNearest scan the N slots, they are meant for small N.
+ * It is not thread safe, the owner should protect it with its own lock.
+ */
+template <typename T, size_t N>
+class SequenceRing {
+ public:
+    SequenceRing() : mSize(0), mMaxProbe(0) {}
+    ~SequenceRing() {}
+
+    bool empty() const { return mSize == 0; }
+    size_t size() const { return mSize; }
+    size_t capacity() const { return N; }
+
+    void clear() {
+        for (size_t i = 0; i < N; i++) {
+            resetSlot(&mSlots[i]);
+        }
+        mSize = 0;
+        mMaxProbe = 0;
+    }
+
+    /**
+     * \brief Get the value of the sequence.
+     *
+     * \return nullptr if the sequence is not stored.
+     */
+    T* find(int64_t sequence) {
+        Slot* slot = findSlot(sequence);
+        return slot ? &slot->value : nullptr;
+    }
+
+    const T* find(int64_t sequence) const {
+        const Slot* slot = findSlot(sequence);
+        return slot ? &slot->value : nullptr;
+    }
+
+    bool contains(int64_t sequence) const { return find(sequence) != nullptr; }
+
+    /**
+     * \brief Insert or update the value of the sequence.
+     *
+     * The oldest stored sequence is evicted if the ring is full, so it always succeeds, also
+     * for a sequence older than the stored ones.
+     */
+    void insert(int64_t sequence, const T& value) {
+        Slot* slot = findSlot(sequence);
+        if (!slot) {
+            size_t home = index(sequence);
+            size_t probe = 0;
+            while (probe < N && mSlots[(home + probe) % N].valid) probe++;
+            if (probe == N) {
+                size_t oldest = oldestIndex();
+                resetSlot(&mSlots[oldest]);
+                mSize--;
+                probe = (oldest + N - home) % N;
+            }
+            slot = &mSlots[(home + probe) % N];
+            if (probe > mMaxProbe) mMaxProbe = probe;
+            slot->valid = true;
+            slot->sequence = sequence;
+            mSize++;
+        }
+        slot->value = value;
+    }
+
+    /**
+     * \brief Remove the sequence, the value is reset to T().
+     *
+     * \return false if the sequence is not stored.
+     */
+    bool erase(int64_t sequence) {
+        Slot* slot = findSlot(sequence);
+        if (!slot) return false;
+
+        resetSlot(slot);
+        if (--mSize == 0) mMaxProbe = 0;
+        return true;
+    }
+
+    /**
+     * \brief Remove all the sequences which are not bigger than the given one.
+     */
+    void eraseUntil(int64_t sequence) {
+        for (size_t i = 0; i < N; i++) {
+            if (mSlots[i].valid && mSlots[i].sequence <= sequence) {
+                resetSlot(&mSlots[i]);
+                mSize--;
+            }
+        }
+        if (mSize == 0) mMaxProbe = 0;
+    }
+
+    /**
+     * \brief Get the smallest stored sequence.
+     *
+     * \return false if the ring is empty.
+     */
+    bool oldest(int64_t* sequence) const {
+        size_t found = oldestIndex();
+        if (found < N) *sequence = mSlots[found].sequence;
+        return found < N;
+    }
+
+    /**
+     * \brief Get the biggest stored sequence.
+     *
+     * \return false if the ring is empty.
+     */
+    bool latest(int64_t* sequence) const {
+        const Slot* found = nullptr;
+        for (size_t i = 0; i < N; i++) {
+            if (mSlots[i].valid && (!found || mSlots[i].sequence > found->sequence)) {
+                found = &mSlots[i];
+            }
+        }
+        if (found) *sequence = found->sequence;
+        return found != nullptr;
+    }
+
+    /**
+     * \brief Get the value of the biggest stored sequence which is not bigger than the given one.
+     *
+     * \return nullptr if there isn't such sequence.
+     */
+    T* findNearest(int64_t sequence) {
+        T* value = find(sequence);
+        if (value) return value;
+
+        Slot* found = nullptr;
+        for (size_t i = 0; i < N; i++) {
+            if (mSlots[i].valid && mSlots[i].sequence <= sequence &&
+                (!found || mSlots[i].sequence > found->sequence)) {
+                found = &mSlots[i];
+            }
+        }
+        return found ? &found->value : nullptr;
+    }
+
+ private:
+    struct Slot {
+        Slot() : valid(false), sequence(-1), value() {}
+
+        bool valid;
+        int64_t sequence;
+        T value;
+    };
+
+    // A sequence is at most mMaxProbe slots after its own one
+    Slot* findSlot(int64_t sequence) {
+        size_t home = index(sequence);
+        for (size_t probe = 0; probe <= mMaxProbe; probe++) {
+            Slot& slot = mSlots[(home + probe) % N];
+            if (slot.valid && slot.sequence == sequence) return &slot;
+        }
+        return nullptr;
+    }
+
+    const Slot* findSlot(int64_t sequence) const {
+        return const_cast<SequenceRing*>(this)->findSlot(sequence);
+    }
+
+    // Return N if the ring is empty
+    size_t oldestIndex() const {
+        size_t found = N;
+        for (size_t i = 0; i < N; i++) {
+            if (mSlots[i].valid && (found == N || mSlots[i].sequence < mSlots[found].sequence)) {
+                found = i;
+            }
+        }
+        return found;
+    }
+
+    static size_t index(int64_t sequence) {
+        int64_t i = sequence % static_cast<int64_t>(N);
+        return static_cast<size_t>(i < 0 ? i + static_cast<int64_t>(N) : i);
+    }
+
+    static void resetSlot(Slot* slot) {
+        slot->valid = false;
+        slot->sequence = -1;
+        slot->value = T();
+    }
+
+ private:
+    Slot mSlots[N];
+    size_t mSize;
+    size_t mMaxProbe;  // the farthest slot a stored sequence is from its own one
+};
+
+}  // namespace icamera
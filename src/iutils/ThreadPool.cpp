@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG ThreadPool
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <string>
+
+#include "CameraLog.h"
+
+namespace icamera {
+
+ThreadPool* ThreadPool::sInstance = nullptr;
+Mutex ThreadPool::sLock;
+
+ThreadPool* ThreadPool::getInstance() {
+    AutoMutex lock(sLock);
+    if (!sInstance) {
+        sInstance = new ThreadPool();
+    }
+    return sInstance;
+}
+
+void ThreadPool::releaseInstance() {
+    AutoMutex lock(sLock);
+    if (sInstance) {
+        delete sInstance;
+        sInstance = nullptr;
+    }
+}
+
+ThreadPool::ThreadPool() : mNextWorker(0), mPendingTasks(0), mExiting(false) {
+    // The calling thread works as well, so one core is left for it
+    int cpuNum = static_cast<int>(std::thread::hardware_concurrency());
+    int workerNum = std::min(std::max(cpuNum - 1, 0), kMaxWorkerNum);
+    LOG1("%s, cpu number %d, worker number %d", __func__, cpuNum, workerNum);
+
+    for (int i = 0; i < workerNum; i++) {
+        mWorkers.emplace_back(new Worker(this, i));
+    }
+    for (int i = 0; i < workerNum; i++) {
+        mWorkers[i]->run("ThreadPool" + std::to_string(i), PRIORITY_NORMAL);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        AutoMutex lock(mLock);
+        mExiting = true;
+    }
+    for (auto& worker : mWorkers) {
+        worker->requestExit();
+    }
+    mTaskCondition.broadcast();
+
+    for (auto& worker : mWorkers) {
+        worker->requestExitAndWait();
+    }
+    mWorkers.clear();
+}
+
+bool ThreadPool::Job::runBand() {
+    int band = nextBand.fetch_add(1);
+    if (band >= bands) return false;
+
+    int start = band * bandRows;
+    int end = std::min(start + bandRows, rows);
+    func(start, end);
+
+    if (doneBands.fetch_add(1) + 1 == bands) {
+        AutoMutex l(lock);
+        doneCondition.broadcast();
+    }
+    return true;
+}
+
+int ThreadPool::getThreadNum(int parallelism) const {
+    int threadNum = getWorkerNum() + 1;
+    if (parallelism > 0) threadNum = std::min(threadNum, parallelism);
+    return threadNum;
+}
+
+void ThreadPool::parallelFor(int rows, int parallelism, int align, const BandFunc& func) {
+    if (rows <= 0) return;
+
+    int threadNum = getThreadNum(parallelism);
+    align = std::max(align, 1);
+
+    // 2 bands per thread, to balance the threads which start late
+    int bandRows = std::max((rows + threadNum * 2 - 1) / (threadNum * 2), kMinBandRows);
+    bandRows = (bandRows + align - 1) / align * align;
+    runJob(rows, bandRows, threadNum, func);
+}
+
+void ThreadPool::runJob(int rows, int bandRows, int threadNum, const BandFunc& func) {
+    int bands = (rows + bandRows - 1) / bandRows;
+    if (threadNum <= 1 || bands <= 1) {
+        func(0, rows);
+        return;
+    }
+
+    std::shared_ptr<Job> job = std::make_shared<Job>(rows, bandRows, bands, func);
+    // The helper tasks only claim the bands, the ones running after the job is done
+    // return immediately.
+    int helperNum = std::min(threadNum, bands) - 1;
+    for (int i = 0; i < helperNum; i++) {
+        pushTask(mNextWorker.fetch_add(1) % getWorkerNum(), job);
+    }
+    {
+        AutoMutex lock(mLock);
+        mTaskCondition.broadcast();
+    }
+
+    while (job->runBand()) {
+    }
+
+    ConditionLock lock(job->lock);
+    while (job->doneBands.load() < bands) {
+        job->doneCondition.wait(lock);
+    }
+}
+
+void ThreadPool::forEachBand(int rows, int parallelism, int align, const BandFunc& func) {
+    if (parallelism == 1) {
+        if (rows > 0) func(0, rows);
+        return;
+    }
+    getInstance()->parallelFor(rows, parallelism, align, func);
+}
+
+void ThreadPool::forEachItem(int count, int parallelism, const BandFunc& func) {
+    if (count <= 0) return;
+
+    if (parallelism == 1) {
+        func(0, count);
+        return;
+    }
+    ThreadPool* pool = getInstance();
+    pool->runJob(count, 1, pool->getThreadNum(parallelism), func);
+}
+
+void ThreadPool::pushTask(int index, const std::shared_ptr<Job>& job) {
+    Worker* worker = mWorkers[index].get();
+    {
+        AutoMutex lock(worker->mLock);
+        worker->mTasks.push_back(job);
+    }
+    mPendingTasks++;
+}
+
+bool ThreadPool::fetchTask(int index, std::shared_ptr<Job>* job) {
+    int workerNum = getWorkerNum();
+    // Take the oldest task of its own, otherwise steal the newest one of the others
+    for (int i = 0; i < workerNum; i++) {
+        Worker* worker = mWorkers[(index + i) % workerNum].get();
+        AutoMutex lock(worker->mLock);
+        if (worker->mTasks.empty()) continue;
+
+        if (i == 0) {
+            *job = worker->mTasks.front();
+            worker->mTasks.pop_front();
+        } else {
+            *job = worker->mTasks.back();
+            worker->mTasks.pop_back();
+        }
+        mPendingTasks--;
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::waitTask() {
+    ConditionLock lock(mLock);
+    while (!mExiting && mPendingTasks.load() <= 0) {
+        mTaskCondition.wait(lock);
+    }
+    return !mExiting;
+}
+
+bool ThreadPool::Worker::threadLoop() {
+    std::shared_ptr<Job> job;
+    if (!mPool->fetchTask(mIndex, &job)) {
+        return mPool->waitTask();
+    }
+
+    while (job->runBand()) {
+    }
+    return true;
+}
+
+}  // namespace icamera
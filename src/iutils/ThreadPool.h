@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "iutils/Thread.h"
+
+namespace icamera {
+
+/**
+ * \class ThreadPool
+ *
+ * A small work-stealing thread pool used to split the SW image processing of one
+ * frame into row bands, or to run a few heavy tasks of one frame in parallel.
+ *
+ * Every parallelFor call is a job whose bands are claimed one by one from an atomic
+ * counter, by the calling thread and by the workers which take the job's helper
+ * tasks. Each worker has its own task deque and steals from the others when it's
+ * idle. The calling thread always processes bands too, so parallelFor can be
+ * called from a worker or when all the workers are busy.
+ */
+class ThreadPool {
+ public:
+    typedef std::function<void(int start, int end)> BandFunc;
+
+    static ThreadPool* getInstance();
+    static void releaseInstance();
+
+    /**
+     * \brief Get the number of the worker threads, the calling thread isn't counted.
+     */
+    int getWorkerNum() const { return static_cast<int>(mWorkers.size()); }
+
+    /**
+     * \brief Run func on the row bands of [0, rows) and wait for all of them.
+     *
+     * \param[in] rows: the row number
+     * \param[in] parallelism: the max thread number including the calling thread,
+     *                         0 means using all the workers
+     * \param[in] align: the band boundaries are multiple of it, such as 2 for YUV420
+     * \param[in] func: called with [start, end) of one band, it may run in any thread
+     */
+    void parallelFor(int rows, int parallelism, int align, const BandFunc& func);
+
+    /**
+     * \brief Same as parallelFor, but func is called directly with [0, rows) if parallelism
+     * is 1, so the pool isn't created by the callers which don't run in parallel.
+     */
+    static void forEachBand(int rows, int parallelism, int align, const BandFunc& func);
+
+    /**
+     * \brief Run func on the items of [0, count) and wait for all of them.
+     *
+     * Unlike parallelFor, the items aren't grouped into bands, it's for the few tasks
+     * which are heavy enough to run in their own threads. func is called with one item
+     * each time when they run in parallel, or directly with [0, count) if parallelism is 1.
+     */
+    static void forEachItem(int count, int parallelism, const BandFunc& func);
+
+ private:
+    ThreadPool();
+    ~ThreadPool();
+
+    struct Job {
+        Job(int rowNum, int bandRowNum, int bandCount, const BandFunc& f)
+                : rows(rowNum),
+                  bandRows(bandRowNum),
+                  bands(bandCount),
+                  func(f),
+                  nextBand(0),
+                  doneBands(0) {}
+
+        // Return false if there is no band left
+        bool runBand();
+
+        const int rows;
+        const int bandRows;
+        const int bands;
+        const BandFunc& func;
+        std::atomic<int> nextBand;
+        std::atomic<int> doneBands;
+        Mutex lock;
+        Condition doneCondition;
+    };
+
+    class Worker : public Thread {
+     public:
+        Worker(ThreadPool* pool, int index) : mPool(pool), mIndex(index) {}
+        ~Worker() {}
+
+        Mutex mLock;  // protect mTasks
+        std::deque<std::shared_ptr<Job>> mTasks;
+
+     private:
+        bool threadLoop() override;
+
+        ThreadPool* mPool;
+        int mIndex;
+    };
+
+    int getThreadNum(int parallelism) const;
+    void runJob(int rows, int bandRows, int threadNum, const BandFunc& func);
+    void pushTask(int index, const std::shared_ptr<Job>& job);
+    bool fetchTask(int index, std::shared_ptr<Job>* job);
+    bool waitTask();
+
+ private:
+    static ThreadPool* sInstance;
+    static Mutex sLock;
+
+    static const int kMaxWorkerNum = 15;
+    // Bands smaller than it aren't worth the dispatching
+    static const int kMinBandRows = 16;
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::atomic<int> mNextWorker;
+    std::atomic<int> mPendingTasks;
+
+    Mutex mLock;  // protect mExiting and used with mTaskCondition
+    Condition mTaskCondition;
+    bool mExiting;
+};
+
+}  // namespace icamera
@@ -19,19 +19,27 @@
 
 #include "CameraMetadata.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "iutils/CameraLog.h"
 #include "iutils/Utils.h"
 
 namespace icamera {
 
+std::atomic<uint64_t> CameraMetadata::sResizeCount(0);
+
 CameraMetadata::CameraMetadata() : mBuffer(nullptr), mLocked(false) {}
 
 CameraMetadata::CameraMetadata(size_t entryCapacity, size_t dataCapacity) : mLocked(false) {
     mBuffer = allocate_icamera_metadata(entryCapacity, dataCapacity);
+    rebuildTagIndex();
 }
 
 CameraMetadata::CameraMetadata(const CameraMetadata& other) : mLocked(false) {
     mBuffer = clone_icamera_metadata(other.mBuffer);
+    // The clone keeps the order of the entries
+    mTagIndex = other.mTagIndex;
 }
 
 CameraMetadata::CameraMetadata(icamera_metadata_t* buffer) : mBuffer(nullptr), mLocked(false) {
@@ -52,6 +60,7 @@ CameraMetadata& CameraMetadata::operator=(const icamera_metadata_t* buffer) {
         icamera_metadata_t* newBuffer = clone_icamera_metadata(buffer);
         clear();
         mBuffer = newBuffer;
+        rebuildTagIndex();
     }
     return *this;
 }
@@ -75,10 +84,15 @@ status_t CameraMetadata::unlock(const icamera_metadata_t* buffer) {
     return OK;
 }
 
+const icamera_metadata_t* CameraMetadata::getBuffer() const {
+    return mBuffer;
+}
+
 icamera_metadata_t* CameraMetadata::release() {
     CheckAndLogError(mLocked, nullptr, "%s: CameraMetadata is locked", __func__);
     icamera_metadata_t* released = mBuffer;
     mBuffer = nullptr;
+    mTagIndex.clear();
     return released;
 }
 
@@ -88,12 +102,14 @@ void CameraMetadata::clear() {
         free_icamera_metadata(mBuffer);
         mBuffer = nullptr;
     }
+    mTagIndex.clear();
 }
 
 void CameraMetadata::acquire(icamera_metadata_t* buffer) {
     CheckAndLogError(mLocked, VOID_VALUE, "%s: CameraMetadata is locked", __func__);
     clear();
     mBuffer = buffer;
+    rebuildTagIndex();
 
     if (validate_icamera_metadata_structure(mBuffer, /*size*/ nullptr) != OK) {
         LOGE("%s: Failed to validate metadata structure %p", __func__, buffer);
@@ -115,20 +131,54 @@ status_t CameraMetadata::append(const icamera_metadata_t* other) {
     size_t extraData = get_icamera_metadata_data_count(other);
     resizeIfNeeded(extraEntries, extraData);
 
-    return append_icamera_metadata(mBuffer, other);
+    status_t res = append_icamera_metadata(mBuffer, other);
+    rebuildTagIndex();
+    return res;
 }
 
 size_t CameraMetadata::entryCount() const {
     return (mBuffer == nullptr) ? 0 : get_icamera_metadata_entry_count(mBuffer);
 }
 
+size_t CameraMetadata::dataCount() const {
+    return (mBuffer == nullptr) ? 0 : get_icamera_metadata_data_count(mBuffer);
+}
+
 bool CameraMetadata::isEmpty() const {
     return entryCount() == 0;
 }
 
+status_t CameraMetadata::reserve(size_t entryCapacity, size_t dataCapacity) {
+    CheckAndLogError(mLocked, INVALID_OPERATION, "%s: CameraMetadata is locked", __func__);
+    if (mBuffer && get_icamera_metadata_entry_capacity(mBuffer) >= entryCapacity &&
+        get_icamera_metadata_data_capacity(mBuffer) >= dataCapacity) {
+        return OK;
+    }
+
+    icamera_metadata_t* newBuffer = allocate_icamera_metadata(
+        std::max(entryCapacity, entryCount()), std::max(dataCapacity, dataCount()));
+    CheckAndLogError(newBuffer == nullptr, NO_MEMORY, "%s: Can't allocate metadata buffer",
+                     __func__);
+    if (mBuffer) {
+        append_icamera_metadata(newBuffer, mBuffer);
+        free_icamera_metadata(mBuffer);
+    }
+    mBuffer = newBuffer;
+    // The order of the entries is kept, so only the new buffer needs the index
+    if (mTagIndex.empty()) rebuildTagIndex();
+
+    return OK;
+}
+
+uint64_t CameraMetadata::getResizeCount() {
+    return sResizeCount;
+}
+
 status_t CameraMetadata::sort() {
     CheckAndLogError(mLocked, INVALID_OPERATION, "%s: CameraMetadata is locked", __func__);
-    return sort_icamera_metadata(mBuffer);
+    status_t res = sort_icamera_metadata(mBuffer);
+    rebuildTagIndex();
+    return res;
 }
 
 status_t CameraMetadata::checkType(uint32_t tag, uint8_t expectedType) {
@@ -218,12 +268,20 @@ status_t CameraMetadata::updateImpl(uint32_t tag, const void* data, size_t data_
     res = resizeIfNeeded(1, data_size);
 
     if (res == OK) {
-        icamera_metadata_entry_t entry;
-        res = find_icamera_metadata_entry(mBuffer, tag, &entry);
-        if (res == NAME_NOT_FOUND) {
+        int index = findIndex(tag);
+        if (index < 0) {
             res = add_icamera_metadata_entry(mBuffer, tag, data, data_count);
-        } else if (res == OK) {
-            res = update_icamera_metadata_entry(mBuffer, entry.index, data, data_count, nullptr);
+            int slot = get_icamera_metadata_tag_slot(tag);
+            if (res == OK && slot >= 0 && !mTagIndex.empty()) {
+                size_t newIndex = entryCount() - 1;
+                if (newIndex > static_cast<size_t>(std::numeric_limits<int16_t>::max())) {
+                    mTagIndex.clear();
+                } else {
+                    mTagIndex[slot] = static_cast<int16_t>(newIndex);
+                }
+            }
+        } else {
+            res = update_icamera_metadata_entry(mBuffer, index, data, data_count, nullptr);
         }
     }
 
@@ -241,8 +299,7 @@ status_t CameraMetadata::updateImpl(uint32_t tag, const void* data, size_t data_
 }
 
 bool CameraMetadata::exists(uint32_t tag) const {
-    icamera_metadata_ro_entry entry;
-    return find_icamera_metadata_ro_entry(mBuffer, tag, &entry) == 0;
+    return findIndex(tag) >= 0;
 }
 
 icamera_metadata_entry_t CameraMetadata::find(uint32_t tag) {
@@ -254,7 +311,8 @@ icamera_metadata_entry_t CameraMetadata::find(uint32_t tag) {
         entry.count = 0;
         return entry;
     }
-    res = find_icamera_metadata_entry(mBuffer, tag, &entry);
+    int index = findIndex(tag);
+    res = (index < 0) ? NAME_NOT_FOUND : get_icamera_metadata_entry(mBuffer, index, &entry);
     if (res != OK) {
         entry.count = 0;
         entry.data.u8 = nullptr;
@@ -265,7 +323,8 @@ icamera_metadata_entry_t CameraMetadata::find(uint32_t tag) {
 icamera_metadata_ro_entry_t CameraMetadata::find(uint32_t tag) const {
     status_t res;
     icamera_metadata_ro_entry entry;
-    res = find_icamera_metadata_ro_entry(mBuffer, tag, &entry);
+    int index = findIndex(tag);
+    res = (index < 0) ? NAME_NOT_FOUND : get_icamera_metadata_ro_entry(mBuffer, index, &entry);
     if (res != OK) {
         entry.count = 0;
         entry.data.u8 = nullptr;
@@ -274,22 +333,18 @@ icamera_metadata_ro_entry_t CameraMetadata::find(uint32_t tag) const {
 }
 
 status_t CameraMetadata::erase(uint32_t tag) {
-    icamera_metadata_entry_t entry;
     status_t res;
     CheckAndLogError(mLocked, INVALID_OPERATION, "%s: CameraMetadata is locked", __func__);
-    res = find_icamera_metadata_entry(mBuffer, tag, &entry);
-    if (res == NAME_NOT_FOUND) {
-        return OK;
-    } else if (res != OK) {
-        LOGE("%s: Error looking for entry %s.%s (%x): %s %d", __func__,
-             get_icamera_metadata_section_name(tag), get_icamera_metadata_tag_name(tag), tag,
-             strerror(-res), res);
-        return res;
-    }
-    res = delete_icamera_metadata_entry(mBuffer, entry.index);
+    int index = findIndex(tag);
+    if (index < 0) return OK;
+
+    res = delete_icamera_metadata_entry(mBuffer, index);
     CheckAndLogError(res != OK, res, "%s: Error deleting entry %s.%s (%x): %s %d", __func__,
                      get_icamera_metadata_section_name(tag), get_icamera_metadata_tag_name(tag),
                      tag, strerror(-res), res);
+
+    // The entries after the deleted one are moved forward
+    rebuildTagIndex();
     return res;
 }
 
@@ -302,6 +357,7 @@ status_t CameraMetadata::resizeIfNeeded(size_t extraEntries, size_t extraData) {
         mBuffer = allocate_icamera_metadata(extraEntries * 2, extraData * 2);
         CheckAndLogError(mBuffer == nullptr, NO_MEMORY, "%s: Can't allocate larger metadata buffer",
                          __func__);
+        rebuildTagIndex();
     } else {
         size_t currentEntryCount = get_icamera_metadata_entry_count(mBuffer);
         size_t currentEntryCap = get_icamera_metadata_entry_capacity(mBuffer);
@@ -320,6 +376,7 @@ status_t CameraMetadata::resizeIfNeeded(size_t extraEntries, size_t extraData) {
                              "%s: Can't allocate larger metadata buffer", __func__);
             append_icamera_metadata(mBuffer, oldBuffer);
             free_icamera_metadata(oldBuffer);
+            sResizeCount++;
         }
     }
     return OK;
@@ -334,6 +391,36 @@ void CameraMetadata::swap(CameraMetadata& other) {
 
     other.mBuffer = thisBuf;
     mBuffer = otherBuf;
+    mTagIndex.swap(other.mTagIndex);
+}
+
+void CameraMetadata::rebuildTagIndex() {
+    mTagIndex.clear();
+    size_t count = entryCount();
+    if (mBuffer == nullptr ||
+        count > static_cast<size_t>(std::numeric_limits<int16_t>::max())) {
+        return;
+    }
+
+    mTagIndex.assign(get_icamera_metadata_tag_slot_count(), -1);
+    icamera_metadata_ro_entry_t entry;
+    for (size_t i = 0; i < count; i++) {
+        if (get_icamera_metadata_ro_entry(mBuffer, i, &entry) != OK) continue;
+
+        int slot = get_icamera_metadata_tag_slot(entry.tag);
+        // Keep the first one of the duplicated tags, like the linear search
+        if (slot >= 0 && mTagIndex[slot] < 0) mTagIndex[slot] = static_cast<int16_t>(i);
+    }
+}
+
+int CameraMetadata::findIndex(uint32_t tag) const {
+    int slot = get_icamera_metadata_tag_slot(tag);
+    if (slot >= 0 && !mTagIndex.empty()) return mTagIndex[slot];
+
+    // Unknown tag or the buffer isn't indexed
+    icamera_metadata_ro_entry_t entry;
+    if (find_icamera_metadata_ro_entry(mBuffer, tag, &entry) != OK) return -1;
+    return static_cast<int>(entry.index);
 }
 
 }  // namespace icamera
@@ -17,7 +17,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 #include "icamera_metadata_base.h"
 #include "iutils/Errors.h"
@@ -66,6 +68,13 @@ class CameraMetadata {
      */
     status_t unlock(const icamera_metadata_t* buffer);
 
+    /**
+     * Get the underlying metadata buffer for read only access, it's valid until the
+     * next non-const call. Unlike getAndLock(), the object isn't changed, so it can be
+     * used with the metadata shared between threads.
+     */
+    const icamera_metadata_t* getBuffer() const;
+
     /**
      * Release a raw metadata buffer to the caller. After this call,
      * CameraMetadata no longer references the buffer, and the caller takes
@@ -108,11 +117,27 @@ class CameraMetadata {
      */
     size_t entryCount() const;
 
+    /**
+     * Number of bytes of the entry data.
+     */
+    size_t dataCount() const;
+
     /**
      * Is the buffer empty (no entires)
      */
     bool isEmpty() const;
 
+    /**
+     * Make sure the buffer has space for entryCapacity entries and dataCapacity
+     * bytes of data, so the updates within the capacity don't reallocate it.
+     */
+    status_t reserve(size_t entryCapacity, size_t dataCapacity);
+
+    /**
+     * Number of the buffer reallocations made by the updates, for the statistics.
+     */
+    static uint64_t getResizeCount();
+
     /**
      * Sort metadata buffer for faster find
      */
@@ -170,9 +195,28 @@ class CameraMetadata {
     void dump(int fd, int verbosity = 1, int indentation = 0) const;
 
  private:
+    static std::atomic<uint64_t> sResizeCount;
+
     icamera_metadata_t* mBuffer;
     bool mLocked;
 
+    /**
+     * Entry index of each tag slot (see get_icamera_metadata_tag_slot()), -1 if the tag
+     * isn't in the buffer. It's kept up to date by all the methods changing the buffer,
+     * so finding a tag doesn't scan the entries. Empty if the buffer isn't indexed.
+     */
+    std::vector<int16_t> mTagIndex;
+
+    /**
+     * Rebuild the tag index from the entries of the buffer
+     */
+    void rebuildTagIndex();
+
+    /**
+     * Get the entry index of a tag, -1 if it isn't found
+     */
+    int findIndex(uint32_t tag) const;
+
     /**
      * Check if tag has a given type
      */
@@ -18,6 +18,7 @@
 
 #include <math.h>
 
+#include <algorithm>
 #include <set>
 #include <memory>
 #include <vector>
@@ -41,6 +42,8 @@ namespace icamera {
 ParameterGenerator::ParameterGenerator(int cameraId)
         : mCameraId(cameraId),
           mCallback(nullptr),
+          mResultEntryCapacity(0),
+          mResultDataCapacity(0),
           mTonemapMaxCurvePoints(0) {
     reset();
 
@@ -80,19 +83,25 @@ int ParameterGenerator::reset() {
     mRequestParamMap.clear();
     CLEAR(mPaCcm);
 
+    LOG1("<id%d>%s, result metadata capacity: entry %zu data %zu, resized %lu", mCameraId,
+         __func__, mResultEntryCapacity, mResultDataCapacity, CameraMetadata::getResizeCount());
+    mResultEntryCapacity = 0;
+    mResultDataCapacity = 0;
+
     return OK;
 }
 
 std::shared_ptr<RequestParam> ParameterGenerator::getRequestParamBuf() {
     AutoMutex l(mParamsLock);
 
-    if (mRequestParamMap.size() < kStorageSize) {
+    int64_t oldest = -1;
+    if (mRequestParamMap.size() < static_cast<size_t>(kStorageSize) ||
+        !mRequestParamMap.oldest(&oldest)) {
         return std::make_shared<RequestParam>();
     }
 
-    auto it = mRequestParamMap.begin();
-    std::shared_ptr<RequestParam> requestParam = it->second;
-    mRequestParamMap.erase(it->first);
+    std::shared_ptr<RequestParam> requestParam = *mRequestParamMap.find(oldest);
+    mRequestParamMap.erase(oldest);
 
     return requestParam;
 }
@@ -103,16 +112,20 @@ int ParameterGenerator::saveParameters(int64_t sequence, long requestId,
     CHECK_SEQUENCE(sequence);
 
     AutoMutex l(mParamsLock);
-    if (!requestParam && mRequestParamMap.empty()) return BAD_VALUE;
+    int64_t latest = -1;
+    if (!requestParam && !mRequestParamMap.latest(&latest)) return BAD_VALUE;
 
     if (!requestParam) {
         requestParam = std::make_shared<RequestParam>();
-        requestParam->param = mRequestParamMap.rbegin()->second->param;
+        requestParam->param = (*mRequestParamMap.find(latest))->param;
     }
     requestParam->requestId = requestId;
-    mRequestParamMap[sequence] = requestParam;
+    mRequestParamMap.insert(sequence, requestParam);
 
-    LOG2("<req%ld:seq%ld>%s", requestParam->requestId, sequence, __func__);
+    uint64_t sharedCount = 0, copyCount = 0;
+    ParameterHelper::getCopyCount(&sharedCount, &copyCount);
+    LOG2("<req%ld:seq%ld>%s, metadata shared %lu, copied %lu", requestParam->requestId, sequence,
+         __func__, sharedCount, copyCount);
 
     return OK;
 }
@@ -124,13 +137,26 @@ void ParameterGenerator::updateParameters(int64_t sequence, const Parameters* pa
 
     AutoMutex l(mParamsLock);
     std::shared_ptr<RequestParam> requestParam = nullptr;
-    if (mRequestParamMap.find(sequence) != mRequestParamMap.end()) {
-        requestParam = mRequestParamMap[sequence];
+    int64_t oldest = -1;
+    if (mRequestParamMap.contains(sequence)) {
+        requestParam = *mRequestParamMap.find(sequence);
+    } else if (mRequestParamMap.oldest(&oldest)) {
+        // Start from the oldest parameters, reuse them only if the insertion evicts them anyway
+        if (mRequestParamMap.size() < mRequestParamMap.capacity()) {
+            const std::shared_ptr<RequestParam>& oldestParam = *mRequestParamMap.find(oldest);
+            requestParam = std::make_shared<RequestParam>();
+            requestParam->requestId = oldestParam->requestId;
+            requestParam->param = oldestParam->param;
+        } else {
+            requestParam = *mRequestParamMap.find(oldest);
+            mRequestParamMap.erase(oldest);
+        }
     } else {
-        auto it = mRequestParamMap.begin();
-        requestParam = it->second;
-        mRequestParamMap.erase(it->first);
+        requestParam = std::make_shared<RequestParam>();
     }
+    // Lock both Parameters once for all the tags below
+    ParameterHelper::ReadView srcView(*param);
+    ParameterHelper::WriteTransaction dstTransaction(&requestParam->param);
     int32_t userRequestId = 0;
     int ret = param->getUserRequestId(userRequestId);
     if (ret == OK) {
@@ -185,7 +211,7 @@ void ParameterGenerator::updateParameters(int64_t sequence, const Parameters* pa
     // disable stats callback for reprocessing request
     requestParam->param.setCallbackRgbs(false);
 
-    mRequestParamMap[sequence] = requestParam;
+    mRequestParamMap.insert(sequence, requestParam);
 }
 
 int ParameterGenerator::getParameters(int64_t sequence, Parameters* param, bool setting,
@@ -195,60 +221,95 @@ int ParameterGenerator::getParameters(int64_t sequence, Parameters* param, bool
     if (setting) {
         AutoMutex l(mParamsLock);
         if (!mRequestParamMap.empty()) {
+            int64_t latest = -1;
             if (sequence < 0) {
-                *param = mRequestParamMap.rbegin()->second->param;
+                if (mRequestParamMap.latest(&latest)) {
+                    *param = (*mRequestParamMap.find(latest))->param;
+                }
             } else {
                 // Find nearest parameter
                 // The sequence of parameter should <= sequence
-                auto it = mRequestParamMap.upper_bound(sequence);
-                if (it == mRequestParamMap.begin()) {
+                std::shared_ptr<RequestParam>* requestParam =
+                    mRequestParamMap.findNearest(sequence);
+                if (!requestParam) {
                     LOGE("Can't find settings for seq %ld", sequence);
                 } else {
-                    *param = (--it)->second->param;
+                    *param = (*requestParam)->param;
                 }
             }
         }
     }
 
     if (result) {
+        reserveResultMetadata(param);
         generateParametersL(sequence, param);
+        updateResultCapacity(*param);
     }
     return OK;
 }
 
+void ParameterGenerator::reserveResultMetadata(Parameters* params) {
+    size_t entryCapacity = 0, dataCapacity = 0;
+    {
+        AutoMutex l(mParamsLock);
+        entryCapacity = mResultEntryCapacity;
+        dataCapacity = mResultDataCapacity;
+    }
+    if (entryCapacity == 0) return;
+
+    // The settings and results are copied into one buffer, instead of growing it tag by tag
+    ParameterHelper::reserve(params, entryCapacity, dataCapacity);
+}
+
+void ParameterGenerator::updateResultCapacity(const Parameters& params) {
+    const CameraMetadata& metadata = ParameterHelper::getMetadata(params);
+    size_t entryCount = metadata.entryCount();
+    size_t dataCount = metadata.dataCount();
+
+    AutoMutex l(mParamsLock);
+    mResultEntryCapacity = std::max(mResultEntryCapacity, entryCount);
+    mResultDataCapacity = std::max(mResultDataCapacity, dataCount);
+    LOG2("%s, result metadata entry %zu data %zu, resized %lu", __func__, entryCount, dataCount,
+         CameraMetadata::getResizeCount());
+}
+
 int ParameterGenerator::getIspParameters(int64_t sequence, Parameters* param) {
     CheckAndLogError((param == nullptr), UNKNOWN_ERROR, "nullptr to get param!");
     CHECK_SEQUENCE(sequence);
 
     AutoMutex l(mParamsLock);
-    if (mRequestParamMap.find(sequence) != mRequestParamMap.end()) {
+    std::shared_ptr<RequestParam>* requestParam = mRequestParamMap.find(sequence);
+    if (requestParam) {
+        const Parameters& savedParam = (*requestParam)->param;
+        ParameterHelper::ReadView srcView(savedParam);
+        ParameterHelper::WriteTransaction dstTransaction(param);
         camera_image_enhancement_t enhancement;
-        int ret = mRequestParamMap[sequence]->param.getImageEnhancement(enhancement);
+        int ret = savedParam.getImageEnhancement(enhancement);
         if (ret == OK) {
             param->setImageEnhancement(enhancement);
         }
         camera_edge_mode_t edgeMode;
-        ret = mRequestParamMap[sequence]->param.getEdgeMode(edgeMode);
+        ret = savedParam.getEdgeMode(edgeMode);
         if (ret == OK) {
             param->setEdgeMode(edgeMode);
         }
         camera_nr_mode_t nrMode;
-        ret = mRequestParamMap[sequence]->param.getNrMode(nrMode);
+        ret = savedParam.getNrMode(nrMode);
         if (ret == OK) {
             param->setNrMode(nrMode);
         }
         camera_nr_level_t nrLevel;
-        ret = mRequestParamMap[sequence]->param.getNrLevel(nrLevel);
+        ret = savedParam.getNrLevel(nrLevel);
         if (ret == OK) {
             param->setNrLevel(nrLevel);
         }
         camera_video_stabilization_mode_t stabilizationMode;
-        ret = mRequestParamMap[sequence]->param.getVideoStabilizationMode(stabilizationMode);
+        ret = savedParam.getVideoStabilizationMode(stabilizationMode);
         if (ret == OK) {
             param->setVideoStabilizationMode(stabilizationMode);
         }
         float hdrRatio;
-        ret = mRequestParamMap[sequence]->param.getHdrRatio(hdrRatio);
+        ret = savedParam.getHdrRatio(hdrRatio);
         if (ret == OK) {
             param->setHdrRatio(hdrRatio);
         }
@@ -263,8 +324,9 @@ int ParameterGenerator::getZoomRegion(int64_t sequence, camera_zoom_region_t& re
     CHECK_SEQUENCE(sequence);
 
     AutoMutex l(mParamsLock);
-    if (mRequestParamMap.find(sequence) != mRequestParamMap.end()) {
-        return mRequestParamMap[sequence]->param.getZoomRegion(&region);
+    std::shared_ptr<RequestParam>* requestParam = mRequestParamMap.find(sequence);
+    if (requestParam) {
+        return (*requestParam)->param.getZoomRegion(&region);
     }
 
     return UNKNOWN_ERROR;
@@ -274,8 +336,9 @@ int ParameterGenerator::getRawOutputMode(int64_t sequence, raw_data_output_t& ra
     CHECK_SEQUENCE(sequence);
 
     AutoMutex l(mParamsLock);
-    if (mRequestParamMap.find(sequence) != mRequestParamMap.end()) {
-        return mRequestParamMap[sequence]->param.getRawDataOutput(rawOutputMode);
+    std::shared_ptr<RequestParam>* requestParam = mRequestParamMap.find(sequence);
+    if (requestParam) {
+        return (*requestParam)->param.getRawDataOutput(rawOutputMode);
     }
 
     return UNKNOWN_ERROR;
@@ -285,8 +348,9 @@ int ParameterGenerator::getUserRequestId(int64_t sequence, int32_t& userRequestI
     CHECK_SEQUENCE(sequence);
 
     AutoMutex l(mParamsLock);
-    if (mRequestParamMap.find(sequence) != mRequestParamMap.end()) {
-        return mRequestParamMap[sequence]->param.getUserRequestId(userRequestId);
+    std::shared_ptr<RequestParam>* requestParam = mRequestParamMap.find(sequence);
+    if (requestParam) {
+        return (*requestParam)->param.getUserRequestId(userRequestId);
     }
 
     return UNKNOWN_ERROR;
@@ -296,8 +360,9 @@ int ParameterGenerator::getRequestId(int64_t sequence, long& requestId) {
     CHECK_SEQUENCE(sequence);
 
     AutoMutex l(mParamsLock);
-    if (mRequestParamMap.find(sequence) != mRequestParamMap.end()) {
-        return mRequestParamMap[sequence]->requestId;
+    std::shared_ptr<RequestParam>* requestParam = mRequestParamMap.find(sequence);
+    if (requestParam) {
+        return (*requestParam)->requestId;
     }
 
     LOGE("<seq%ld>Can't find requestId", sequence);
@@ -316,6 +381,9 @@ int ParameterGenerator::updateWithAiqResultsL(int64_t sequence, Parameters* para
     CheckAndLogError((aiqResult == nullptr), UNKNOWN_ERROR,
                      "%s Aiq result of sequence %ld does not exist", __func__, sequence);
 
+    // Lock the params once for all the result metadata
+    ParameterHelper::WriteTransaction transaction(params);
+
     // Update AE related parameters
     camera_ae_state_t aeState =
         aiqResult->mAeResults.exposures[0].converged ? AE_STATE_CONVERGED : AE_STATE_NOT_CONVERGED;
@@ -20,6 +20,7 @@
 #include <memory>
 
 #include "Parameters.h"
+#include "iutils/SequenceRing.h"
 #include "iutils/Thread.h"
 
 namespace icamera {
@@ -92,6 +93,9 @@ class ParameterGenerator {
 
     int updateCommonMetadata(Parameters* params, const AiqResult* aiqResult);
 
+    void reserveResultMetadata(Parameters* params);
+    void updateResultCapacity(const Parameters& params);
+
  private:
     int mCameraId;
     camera_callback_ops_t* mCallback;
@@ -99,8 +103,13 @@ class ParameterGenerator {
 
     // Guard for ParameterGenerator public API.
     Mutex mParamsLock;
-    // first: sequence id, second: RequestParam data
-    std::map<int64_t, std::shared_ptr<RequestParam> > mRequestParamMap;
+    // key: sequence id, value: RequestParam data
+    SequenceRing<std::shared_ptr<RequestParam>, kStorageSize> mRequestParamMap;
+
+    // The high-water marks of the result metadata size since the stream is configured,
+    // used to allocate the result metadata buffer once.
+    size_t mResultEntryCapacity;
+    size_t mResultDataCapacity;
 
     std::unique_ptr<float[]> mTonemapCurveRed;
     std::unique_ptr<float[]> mTonemapCurveBlue;
@@ -16,6 +16,8 @@
 
 #define LOG_TAG ParameterHelper
 
+#include <algorithm>
+
 #include "iutils/Utils.h"
 #include "iutils/CameraLog.h"
 
@@ -24,9 +26,82 @@
 
 namespace icamera {
 
+std::atomic<uint64_t> ParameterHelper::sSharedCount(0);
+std::atomic<uint64_t> ParameterHelper::sCopyCount(0);
+thread_local const ParameterHelper::BatchNode* ParameterHelper::sBatchTop = nullptr;
+
+void* ParameterHelper::getData(const Parameters& param) {
+    return param.mData;
+}
+
+ParameterHelper::ReadView::ReadView(const Parameters& param)
+        : mParam(param),
+          mNode({getData(param), false, sBatchTop}) {
+    // Nothing to lock if the Parameters is already in a batch of the current thread
+    if (findBatch(mNode.data)) {
+        mNode.data = nullptr;
+        return;
+    }
+
+    getInternalData(mNode.data).mRwLock.readLock();
+    sBatchTop = &mNode;
+}
+
+ParameterHelper::ReadView::~ReadView() {
+    if (!mNode.data) return;
+
+    sBatchTop = mNode.prev;
+    getInternalData(mNode.data).mRwLock.unlock();
+}
+
+ParameterHelper::WriteTransaction::WriteTransaction(Parameters* param)
+        : mParam(param),
+          mNode({getData(*param), true, sBatchTop}) {
+    const BatchNode* node = findBatch(mNode.data);
+    if (node) {
+        // Not locked here, so the destructor mustn't unlock the lock of the outer batch
+        mNode.data = nullptr;
+        // Upgrading the read lock of the same thread would deadlock
+        CheckAndLogError(!node->write, VOID_VALUE, "%s, the Parameters is in a ReadView",
+                         __func__);
+        return;
+    }
+
+    getInternalData(mNode.data).mRwLock.writeLock();
+    sBatchTop = &mNode;
+}
+
+ParameterHelper::WriteTransaction::~WriteTransaction() {
+    if (!mNode.data) return;
+
+    sBatchTop = mNode.prev;
+    getInternalData(mNode.data).mRwLock.unlock();
+}
+
+ParameterHelper::AutoWLock::AutoWLock(void* data)
+        : mLock(getInternalData(data).mRwLock),
+          mLocked(true) {
+    const BatchNode* node = findBatch(data);
+    mLocked = !(node && node->write);
+    // The read lock of the ReadView is never released while waiting here
+    if (node && !node->write) {
+        LOGE("%s, updating the Parameters in its ReadView deadlocks", __func__);
+    }
+    if (mLocked) mLock.writeLock();
+}
+
 void ParameterHelper::merge(const Parameters& src, Parameters* dst) {
-    AutoRLock rl(src.mData);
-    merge(getMetadata(src.mData), dst);
+    std::shared_ptr<CameraMetadata> snapshot = getSnapshot(src.mData);
+    {
+        AutoWLock wl(dst->mData);
+        // Nothing to be merged into, so just share the source
+        if (getConstMetadata(dst->mData).isEmpty()) {
+            getInternalData(dst->mData).mMetadata = snapshot;
+            return;
+        }
+    }
+    // The snapshot isn't changed while it's referenced here
+    merge(*snapshot, dst);
 }
 
 void ParameterHelper::merge(const CameraMetadata& metadata, Parameters* dst) {
@@ -36,7 +111,8 @@ void ParameterHelper::merge(const CameraMetadata& metadata, Parameters* dst) {
     }
 
     AutoWLock wl(dst->mData);
-    const icamera_metadata_t* src = const_cast<CameraMetadata*>(&metadata)->getAndLock();
+    // The metadata may be a snapshot shared with other threads, so it isn't locked
+    const icamera_metadata_t* src = metadata.getBuffer();
     size_t count = metadata.entryCount();
     icamera_metadata_ro_entry_t entry;
     for (size_t i = 0; i < count; i++) {
@@ -68,18 +144,68 @@ void ParameterHelper::merge(const CameraMetadata& metadata, Parameters* dst) {
                 break;
         }
     }
-    const_cast<CameraMetadata*>(&metadata)->unlock(src);
 }
 
 void ParameterHelper::copyMetadata(const Parameters& source, CameraMetadata* metadata) {
     CheckAndLogError((!metadata), VOID_VALUE, "null metadata to be updated!");
 
+    // The metadata is copied deeply rather than shared, so it isn't taken as a snapshot
     AutoRLock rl(source.mData);
-    *metadata = getMetadata(source.mData);
+    *metadata = getConstMetadata(source.mData);
+    sCopyCount++;
 }
 
 const CameraMetadata& ParameterHelper::getMetadata(const Parameters& source) {
-    return getMetadata(source.mData);
+    return getConstMetadata(source.mData);
+}
+
+void ParameterHelper::getCopyCount(uint64_t* sharedCount, uint64_t* copyCount) {
+    if (sharedCount) *sharedCount = sSharedCount;
+    if (copyCount) *copyCount = sCopyCount;
+}
+
+void ParameterHelper::reserve(Parameters* dst, size_t entryCapacity, size_t dataCapacity) {
+    CheckAndLogError(!dst, VOID_VALUE, "dst is nullptr");
+
+    AutoWLock wl(dst->mData);
+    std::shared_ptr<CameraMetadata>& metadata = getInternalData(dst->mData).mMetadata;
+    if (metadata.use_count() == 1) {
+        metadata->reserve(entryCapacity, dataCapacity);
+        return;
+    }
+
+    std::shared_ptr<CameraMetadata> newMetadata =
+        std::make_shared<CameraMetadata>(std::max(entryCapacity, metadata->entryCount()),
+                                         std::max(dataCapacity, metadata->dataCount()));
+    if (!metadata->isEmpty()) newMetadata->append(*metadata);
+    metadata = newMetadata;
+    sCopyCount++;
+}
+
+void ParameterHelper::copy(void* srcData, void* dstData) {
+    // Get the snapshot before locking dstData, to avoid the lock order issue of a=b and b=a
+    std::shared_ptr<CameraMetadata> snapshot = getSnapshot(srcData);
+    AutoWLock wl(dstData);
+    getInternalData(dstData).mMetadata = snapshot;
+}
+
+std::shared_ptr<CameraMetadata> ParameterHelper::getSnapshot(void* data) {
+    AutoRLock rl(data);
+    sSharedCount++;
+    return getInternalData(data).mMetadata;
+}
+
+CameraMetadata& ParameterHelper::getMetadata(void* data) {
+    std::shared_ptr<CameraMetadata>& metadata = getInternalData(data).mMetadata;
+    /*
+     * Others can only take a new reference with the read lock, so the count doesn't
+     * increase here. If it drops at the same time, the copy is just unnecessary.
+     */
+    if (metadata.use_count() > 1) {
+        metadata = std::make_shared<CameraMetadata>(*metadata);
+        sCopyCount++;
+    }
+    return *metadata;
 }
 
 void ParameterHelper::mergeTag(const icamera_metadata_ro_entry& entry, Parameters* dst) {
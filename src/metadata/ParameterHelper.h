@@ -16,7 +16,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include "iutils/RWLock.h"
+#include "iutils/Utils.h"
 #include "CameraMetadata.h"
 
 namespace icamera {
@@ -93,6 +97,83 @@ class ParameterHelper {
      */
     static const CameraMetadata& getMetadata(const Parameters& source);
 
+    /**
+     * \brief Get the copy statistics of the Parameters metadata.
+     *
+     * \param[out] uint64_t sharedCount: the times a Parameters copy shares the metadata.
+     * \param[out] uint64_t copyCount: the times the metadata is copied deeply, on write or
+     *                                 by copyMetadata.
+     *
+     * \return void
+     */
+    static void getCopyCount(uint64_t* sharedCount, uint64_t* copyCount);
+
+    /**
+     * \brief Make sure the metadata of dst has the capacity, so the updates within it don't
+     * reallocate the metadata buffer. The shared metadata is copied into a buffer of the
+     * capacity directly.
+     *
+     * \param[out] Parameters dst: the parameter to be updated.
+     * \param[in] size_t entryCapacity: the entry number.
+     * \param[in] size_t dataCapacity: the bytes of the entry data.
+     *
+     * \return void
+     */
+    static void reserve(Parameters* dst, size_t entryCapacity, size_t dataCapacity);
+
+    // The batches of the current thread, the innermost one is at the top
+    struct BatchNode {
+        void* data;  // nullptr if the Parameters is already in an outer batch
+        bool write;
+        const BatchNode* prev;
+    };
+
+    /**
+     * \class ReadView
+     *
+     * \brief Take the read lock of Parameters once for a batch of its getters.
+     *
+     * The getters of the Parameters called by the same thread in the scope of the view
+     * don't take the lock again. The Parameters must not be updated in the scope: its
+     * setters wait for the write lock behind the read lock of the view and deadlock, and a
+     * WriteTransaction of it fails without locking.
+     */
+    class ReadView {
+     public:
+        explicit ReadView(const Parameters& param);
+        ~ReadView();
+
+        const Parameters* operator->() const { return &mParam; }
+
+     private:
+        const Parameters& mParam;
+        BatchNode mNode;
+
+        DISALLOW_COPY_AND_ASSIGN(ReadView);
+    };
+
+    /**
+     * \class WriteTransaction
+     *
+     * \brief Take the write lock of Parameters once for a batch of its getters and setters.
+     *
+     * Like ReadView, the accesses of the Parameters by the same thread in the scope of the
+     * transaction don't take the lock again.
+     */
+    class WriteTransaction {
+     public:
+        explicit WriteTransaction(Parameters* param);
+        ~WriteTransaction();
+
+        Parameters* operator->() const { return mParam; }
+
+     private:
+        Parameters* mParam;
+        BatchNode mNode;
+
+        DISALLOW_COPY_AND_ASSIGN(WriteTransaction);
+    };
+
  private:
     // The definitions and interfaces in this private section are only for Parameters internal
     // use, HAL other code shouldn't and cannot access them.
@@ -103,62 +184,99 @@ class ParameterHelper {
      *
      * \brief The definition of Parameters' internal data structure used to hide implementation
      *        details of Parameters.
+     *
+     * The metadata is an immutable snapshot shared by the copies of Parameters, it's copied
+     * only when one of them updates the metadata, so passing Parameters between threads
+     * doesn't copy the metadata buffer.
      */
     class ParameterData {
      public:
-        ParameterData() {}
+        ParameterData() : mMetadata(std::make_shared<CameraMetadata>()) {}
+        explicit ParameterData(const std::shared_ptr<CameraMetadata>& metadata)
+                : mMetadata(metadata) {}
         ~ParameterData() {}
 
-        ParameterData(const ParameterData& other) : mMetadata(other.mMetadata) {}
-        ParameterData& operator=(const ParameterData& other) {
-            mMetadata = other.mMetadata;
-            return *this;
-        }
+        // The data structure to save all of the parameters, shared with other Parameters
+        // when use_count() > 1.
+        std::shared_ptr<CameraMetadata> mMetadata;
+        RWLock mRwLock;  // Read-write lock to make Parameters class thread-safe
 
-        CameraMetadata mMetadata;  // The data structure to save all of the parameters.
-        RWLock mRwLock;            // Read-write lock to make Parameters class thread-safe
+     private:
+        DISALLOW_COPY_AND_ASSIGN(ParameterData);
     };
 
+    static thread_local const BatchNode* sBatchTop;
+
+    static const BatchNode* findBatch(void* data) {
+        for (const BatchNode* node = sBatchTop; node; node = node->prev) {
+            if (node->data == data) return node;
+        }
+        return nullptr;
+    }
+
     // Customized wrappers of RWLock to make the implementation of Parameters much cleaner.
+    // The lock is skipped if it's already held by the batch of the current thread.
     class AutoRLock {
      public:
-        AutoRLock(void* data) : mLock(getInternalData(data).mRwLock) { mLock.readLock(); }
-        ~AutoRLock() { mLock.unlock(); }
+        AutoRLock(void* data)
+                : mLock(getInternalData(data).mRwLock),
+                  mLocked(findBatch(data) == nullptr) {
+            if (mLocked) mLock.readLock();
+        }
+        ~AutoRLock() {
+            if (mLocked) mLock.unlock();
+        }
 
      private:
         RWLock& mLock;
+        bool mLocked;
     };
 
     class AutoWLock {
      public:
-        AutoWLock(void* data) : mLock(getInternalData(data).mRwLock) { mLock.writeLock(); }
-        ~AutoWLock() { mLock.unlock(); }
+        AutoWLock(void* data);
+        ~AutoWLock() {
+            if (mLocked) mLock.unlock();
+        }
 
      private:
         RWLock& mLock;
+        bool mLocked;
     };
 
+    static void* getData(const Parameters& param);
+
     static ParameterData& getInternalData(void* data) {
         return *reinterpret_cast<ParameterData*>(data);
     }
 
     static void* createParameterData() { return new ParameterData(); }
 
-    static void* createParameterData(void* data) {
-        return new ParameterData(getInternalData(data));
-    }
+    static void* createParameterData(void* data) { return new ParameterData(getSnapshot(data)); }
 
     static void releaseParameterData(void* data) { delete &getInternalData(data); }
 
-    static void deepCopy(void* srcData, void* dstData) {
-        getInternalData(dstData) = getInternalData(srcData);
-    }
+    // Share the metadata snapshot of srcData with dstData
+    static void copy(void* srcData, void* dstData);
+
+    // Get the metadata snapshot with the read lock, it isn't changed while it's referenced.
+    static std::shared_ptr<CameraMetadata> getSnapshot(void* data);
 
-    static CameraMetadata& getMetadata(void* data) { return getInternalData(data).mMetadata; }
+    // Get the metadata to be updated, called with the write lock. The snapshot is copied
+    // first if it's shared with other Parameters.
+    static CameraMetadata& getMetadata(void* data);
+
+    // Get the metadata for read only access, called with the read or write lock.
+    static const CameraMetadata& getConstMetadata(void* data) {
+        return *getInternalData(data).mMetadata;
+    }
 
     static icamera_metadata_ro_entry_t getMetadataEntry(void* data, uint32_t tag) {
-        return const_cast<const CameraMetadata*>(&getMetadata(data))->find(tag);
+        return getConstMetadata(data).find(tag);
     }
+
+    static std::atomic<uint64_t> sSharedCount;
+    static std::atomic<uint64_t> sCopyCount;
 };
 
 }  // namespace icamera
@@ -34,8 +34,7 @@ Parameters::Parameters(const Parameters& other)
         : mData(ParameterHelper::createParameterData(other.mData)) {}
 
 Parameters& Parameters::operator=(const Parameters& other) {
-    ParameterHelper::AutoWLock wl(mData);
-    ParameterHelper::deepCopy(other.mData, mData);
+    ParameterHelper::copy(other.mData, mData);
     return *this;
 }
 
@@ -748,6 +748,57 @@ int get_icamera_metadata_tag_type(uint32_t tag) {
     return -1;
 }
 
+/**
+ * The slots of the tags: the sections are laid out one by one, the camera sections
+ * first and then the vendor sections, and a tag takes the slot of its index in the
+ * section.
+ */
+struct tag_slot_table {
+    tag_slot_table() : count(0) {
+        for (uint32_t i = 0; i < CAMERA_SECTION_COUNT; i++) {
+            section_start[i] = count;
+            count += icamera_metadata_section_bounds[i][1] - icamera_metadata_section_bounds[i][0];
+        }
+        for (uint32_t i = 0; i < INTEL_VENDOR_SECTION_COUNT; i++) {
+            section_start[CAMERA_SECTION_COUNT + i] = count;
+            count += vendor_metadata_section_bounds[i][1] - vendor_metadata_section_bounds[i][0];
+        }
+    }
+
+    uint32_t section_start[CAMERA_SECTION_COUNT + INTEL_VENDOR_SECTION_COUNT];
+    uint32_t count;
+};
+
+static const tag_slot_table& get_tag_slot_table() {
+    static const tag_slot_table table;
+    return table;
+}
+
+int get_icamera_metadata_tag_slot(uint32_t tag) {
+    uint32_t tag_section = tag >> 16;
+    uint32_t tag_index = tag & 0xFFFF;
+
+    if (tag_section < CAMERA_SECTION_COUNT &&
+        tag >= icamera_metadata_section_bounds[tag_section][0] &&
+        tag < icamera_metadata_section_bounds[tag_section][1]) {
+        return get_tag_slot_table().section_start[tag_section] + tag_index;
+    } else if (tag_section >= INTEL_VENDOR_CAMERA_SECTION &&
+               tag_section < INTEL_VENDOR_CAMERA_SECTION_END) {
+        tag_section -= INTEL_VENDOR_CAMERA_SECTION;
+        if (tag >= vendor_metadata_section_bounds[tag_section][0] &&
+            tag < vendor_metadata_section_bounds[tag_section][1]) {
+            return get_tag_slot_table().section_start[CAMERA_SECTION_COUNT + tag_section] +
+                   tag_index;
+        }
+    }
+
+    return -1;
+}
+
+size_t get_icamera_metadata_tag_slot_count() {
+    return get_tag_slot_table().count;
+}
+
 static void print_data(int fd, const uint8_t* data_ptr, uint32_t tag, int type, int count,
                        int indentation);
 
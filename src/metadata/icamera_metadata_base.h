@@ -403,6 +403,18 @@ const char* get_icamera_metadata_tag_name(uint32_t tag);
  */
 int get_icamera_metadata_tag_type(uint32_t tag);
 
+/**
+ * Retrieve the slot of a tag, which is unique in [0, get_icamera_metadata_tag_slot_count())
+ * for each defined tag, so it works as a perfect hash of the tags. Returns -1 if no such
+ * tag is defined.
+ */
+int get_icamera_metadata_tag_slot(uint32_t tag);
+
+/**
+ * Retrieve the number of the tag slots.
+ */
+size_t get_icamera_metadata_tag_slot_count();
+
 /**
  * Print fields in the metadata to the log.
  * verbosity = 0: Only tag entry information
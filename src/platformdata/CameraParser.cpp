@@ -710,8 +710,23 @@ void CameraParser::handleSensor(CameraParser* profiles, const char* name, const
         pCurrentCam->mMsPsysAlignWithSystem = val > 0 ? val : 0;
     } else if (strcmp(name, "psysBundleWithAic") == 0) {
         pCurrentCam->mPsysBundleWithAic = strcmp(atts[1], "true") == 0;
+    } else if (strcmp(name, "psysPipelineCacheSize") == 0) {
+        int val = atoi(atts[1]);
+        pCurrentCam->mPsysPipelineCacheSize = val > 0 ? val : 0;
+    } else if (strcmp(name, "psysAsyncSubmission") == 0) {
+        pCurrentCam->mPsysAsyncSubmission = strcmp(atts[1], "true") == 0;
     } else if (strcmp(name, "swProcessingAlignWithIsp") == 0) {
         pCurrentCam->mSwProcessingAlignWithIsp = strcmp(atts[1], "true") == 0;
+    } else if (strcmp(name, "swProcessingThreads") == 0) {
+        int val = atoi(atts[1]);
+        pCurrentCam->mSwProcessingThreads = val > 0 ? val : 0;
+    } else if (strcmp(name, "ispAdaptThreads") == 0) {
+        int val = atoi(atts[1]);
+        pCurrentCam->mIspAdaptThreads = val > 0 ? val : 0;
+    } else if (strcmp(name, "isysEventReactor") == 0) {
+        pCurrentCam->mIsysEventReactor = strcmp(atts[1], "true") == 0;
+    } else if (strcmp(name, "incrementalMediaCtl") == 0) {
+        pCurrentCam->mIncrementalMediaCtl = strcmp(atts[1], "true") == 0;
     } else if (strcmp(name, "faceEngineVendor") == 0) {
         int val = atoi(atts[1]);
         pCurrentCam->mFaceEngineVendor = val >= 0 ? val : FACE_ENGINE_INTEL_PVL;
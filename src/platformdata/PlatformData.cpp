@@ -526,6 +526,30 @@ bool PlatformData::swProcessingAlignWithIsp(int cameraId) {
     return getInstance()->mStaticCfg.mCameras[cameraId].mSwProcessingAlignWithIsp;
 }
 
+int PlatformData::getPsysPipelineCacheSize(int cameraId) {
+    return getInstance()->mStaticCfg.mCameras[cameraId].mPsysPipelineCacheSize;
+}
+
+bool PlatformData::isPsysAsyncSubmissionEnabled(int cameraId) {
+    return getInstance()->mStaticCfg.mCameras[cameraId].mPsysAsyncSubmission;
+}
+
+int PlatformData::getSwProcessingThreads(int cameraId) {
+    return getInstance()->mStaticCfg.mCameras[cameraId].mSwProcessingThreads;
+}
+
+int PlatformData::getIspAdaptThreads(int cameraId) {
+    return getInstance()->mStaticCfg.mCameras[cameraId].mIspAdaptThreads;
+}
+
+bool PlatformData::isIsysEventReactorEnabled(int cameraId) {
+    return getInstance()->mStaticCfg.mCameras[cameraId].mIsysEventReactor;
+}
+
+bool PlatformData::isIncrementalMediaCtlEnabled(int cameraId) {
+    return getInstance()->mStaticCfg.mCameras[cameraId].mIncrementalMediaCtl;
+}
+
 bool PlatformData::isUsingSensorDigitalGain(int cameraId) {
     return getInstance()->mStaticCfg.mCameras[cameraId].mUseSensorDigitalGain;
 }
@@ -197,7 +197,13 @@ class PlatformData {
                       mPsysAlignWithSof(false),
                       mMsPsysAlignWithSystem(0),
                       mPsysBundleWithAic(false),
+                      mPsysPipelineCacheSize(0),
+                      mPsysAsyncSubmission(false),
                       mSwProcessingAlignWithIsp(false),
+                      mSwProcessingThreads(1),
+                      mIspAdaptThreads(1),
+                      mIsysEventReactor(false),
+                      mIncrementalMediaCtl(false),
                       mMaxNvmDataSize(0),
                       mNvmOverwrittenFileSize(0),
                       mTnrExtraFrameNum(0),
@@ -330,7 +336,13 @@ class PlatformData {
             bool mPsysAlignWithSof;
             int mMsPsysAlignWithSystem;  // Aligned with system time
             bool mPsysBundleWithAic;
+            int mPsysPipelineCacheSize;  // 0 means the pipelines aren't kept
+            bool mPsysAsyncSubmission;
             bool mSwProcessingAlignWithIsp;
+            int mSwProcessingThreads;  // 0 means using all the pool workers
+            int mIspAdaptThreads;      // 0 means using all the pool workers
+            bool mIsysEventReactor;
+            bool mIncrementalMediaCtl;
 
             /* key: camera_test_pattern_mode_t, value: sensor test pattern mode */
             std::unordered_map<int32_t, int32_t> mTestPatternMap;
@@ -975,6 +987,23 @@ class PlatformData {
      */
     static bool psysBundleWithAic(int cameraId);
 
+    /**
+     * Get the number of the configured PSYS pipelines kept for the reconfiguration
+     *
+     * \param cameraId: [0, MAX_CAMERA_NUMBER - 1]
+     * \return the max number of the pipelines kept after stop, 0 means not keeping them.
+     */
+    static int getPsysPipelineCacheSize(int cameraId);
+
+    /**
+     * Check if the PSYS commands are submitted asynchronously
+     *
+     * \param cameraId: [0, MAX_CAMERA_NUMBER - 1]
+     * \return true if the PSYS events are reaped by a thread of each PG, and the executors
+     *         prepare the next PG while the previous one is running.
+     */
+    static bool isPsysAsyncSubmissionEnabled(int cameraId);
+
     /**
      * Check software processing align with isp is enabled or not
      *
@@ -983,6 +1012,42 @@ class PlatformData {
      */
     static bool swProcessingAlignWithIsp(int cameraId);
 
+    /**
+     * Get the thread number of the software image processing
+     *
+     * \param cameraId: [0, MAX_CAMERA_NUMBER - 1]
+     * \return the max thread number for one frame, 1 (default) means the frame is processed
+     *         serially, 0 means using all the pool workers.
+     */
+    static int getSwProcessingThreads(int cameraId);
+
+    /**
+     * Get the thread number of the ISP parameter adaptation
+     *
+     * \param cameraId: [0, MAX_CAMERA_NUMBER - 1]
+     * \return the max thread number to run the AIC of the streams for one frame, 1 means
+     *         the streams run serially, 0 means using all the pool workers.
+     */
+    static int getIspAdaptThreads(int cameraId);
+
+    /**
+     * Check if the ISYS devices are waited by the shared event reactor
+     *
+     * \param cameraId: [0, MAX_CAMERA_NUMBER - 1]
+     * \return true if the capture, SOF and CSI meta devices are waited by the epoll thread
+     *         shared by all the cameras, instead of one poll thread per device.
+     */
+    static bool isIsysEventReactorEnabled(int cameraId);
+
+    /**
+     * Check if the media controller is configured incrementally
+     *
+     * \param cameraId: [0, MAX_CAMERA_NUMBER - 1]
+     * \return true if the links, routes, formats and selections which are the same as the
+     *         ones applied by the last configuration are skipped.
+     */
+    static bool isIncrementalMediaCtlEnabled(int cameraId);
+
     /**
      * Get the max digital gain of sensor
      *
@@ -22,6 +22,7 @@
 #include <linux/v4l2-mediabus.h>
 #include <linux/videodev2.h>
 
+#include <algorithm>
 #include <stack>
 #include <string>
 
@@ -67,6 +68,21 @@ static const string ivscName = "Intel IVSC CSI";
 MediaControl* MediaControl::sInstance = nullptr;
 Mutex MediaControl::sLock;
 
+/*
+ * The entities enumerated by the last MediaControl instance. They are reused by the next
+ * instance of the same media device if its topology version isn't changed, to skip the
+ * entity enumeration and the sysfs lookups. The links are always enumerated again since
+ * their flags are changed by the setup.
+ */
+struct EntitySnapshot {
+    media_entity_desc info;
+    char devname[32];
+};
+static string sSnapshotDevName;
+static uint64_t sSnapshotVersion = 0;
+static int sSnapshotMediaCfgId = IPU6_DOWNSTREAM_MEDIA_CFG;
+static vector<EntitySnapshot> sEntitySnapshot;
+
 MediaControl* MediaControl::getMediaControlInstance() {
     MediaControl* mediaControlInstance = nullptr;
 
@@ -129,7 +145,10 @@ void MediaControl::releaseInstance() {
 
 MediaControl::MediaControl(const char* devName)
         : mDevName(devName),
-          mMediaCfgId(IPU6_DOWNSTREAM_MEDIA_CFG) {
+          mMediaCfgId(IPU6_DOWNSTREAM_MEDIA_CFG),
+          mIncremental(false),
+          mAppliedCount(0),
+          mSkippedCount(0) {
     LOG1("@%s device: %s", __func__, devName);
 }
 
@@ -162,6 +181,9 @@ void MediaControl::clearEntities() {
         entity->links = nullptr;
         entity = mEntities.erase(entity);
     }
+
+    AutoMutex l(mSetupLock);
+    clearAppliedState();
 }
 
 MediaEntity* MediaControl::getEntityByName(const char* name) {
@@ -209,6 +231,10 @@ int MediaControl::resetAllLinks() {
 int MediaControl::resetAllRoutes(int cameraId) {
     LOG1("<id%d> %s", cameraId, __func__);
 
+    // The formats are reset by the driver with the routes.
+    AutoMutex l(mSetupLock);
+    clearAppliedState();
+
     for (MediaEntity& entity : mEntities) {
         struct v4l2_subdev_route routes[entity.info.pads];
         uint32_t numRoutes = entity.info.pads;
@@ -299,28 +325,36 @@ done:
     return ret;
 }
 
-int MediaControl::setupLink(uint32_t srcEntity, uint32_t srcPad, uint32_t sinkEntity,
-                            uint32_t sinkPad, bool enable) {
-    LOG1("@%s srcEntity %d srcPad %d sinkEntity %d sinkPad %d enable %d", __func__, srcEntity,
-         srcPad, sinkEntity, sinkPad, enable);
-
+MediaLink* MediaControl::findLink(uint32_t srcEntity, uint32_t srcPad, uint32_t sinkEntity,
+                                  uint32_t sinkPad) {
     for (auto& entity : mEntities) {
         for (uint32_t j = 0; j < entity.numLinks; j++) {
             MediaLink* link = &entity.links[j];
 
             if ((link->source->entity->info.id == srcEntity) && (link->source->index == srcPad) &&
                 (link->sink->entity->info.id == sinkEntity) && (link->sink->index == sinkPad)) {
-                if (enable)
-                    link->flags |= MEDIA_LNK_FL_ENABLED;
-                else
-                    link->flags &= ~MEDIA_LNK_FL_ENABLED;
-
-                return setupLink(link->source, link->sink, link->flags);
+                return link;
             }
         }
     }
 
-    return -1;
+    return nullptr;
+}
+
+int MediaControl::setupLink(uint32_t srcEntity, uint32_t srcPad, uint32_t sinkEntity,
+                            uint32_t sinkPad, bool enable) {
+    LOG1("@%s srcEntity %d srcPad %d sinkEntity %d sinkPad %d enable %d", __func__, srcEntity,
+         srcPad, sinkEntity, sinkPad, enable);
+
+    MediaLink* link = findLink(srcEntity, srcPad, sinkEntity, sinkPad);
+    if (!link) return -1;
+
+    // The link keeps its flags until the driver takes the new ones, otherwise a failed
+    // enabling would be taken as done and skipped by the incremental setup.
+    uint32_t flags = enable ? (link->flags | MEDIA_LNK_FL_ENABLED)
+                            : (link->flags & ~MEDIA_LNK_FL_ENABLED);
+
+    return setupLink(link->source, link->sink, flags);
 }
 
 int MediaControl::openDevice() {
@@ -382,6 +416,8 @@ int MediaControl::enumInfo() {
     }
 
     media_device_info info;
+    uint64_t topologyVersion = 0;
+    bool hasVersion = false;
     int ret = sc->ioctl(fd, MEDIA_IOC_DEVICE_INFO, &info);
     if (ret < 0) {
         LOGE("Unable to retrieve media device information for device %s (%s)", mDevName.c_str(),
@@ -391,10 +427,17 @@ int MediaControl::enumInfo() {
 
     if (Log::isDumpMediaInfo()) dumpInfo(info);
 
-    ret = enumEntities(fd, info);
-    if (ret < 0) {
-        LOGE("Unable to enumerate entities for device %s", mDevName.c_str());
-        goto done;
+    hasVersion = getTopologyVersion(fd, &topologyVersion) == OK;
+    if (hasVersion && restoreEntities(topologyVersion)) {
+        LOG1("Reuse the entities of %s, topology version %llu", mDevName.c_str(),
+             static_cast<unsigned long long>(topologyVersion));
+    } else {
+        ret = enumEntities(fd, info);
+        if (ret < 0) {
+            LOGE("Unable to enumerate entities for device %s", mDevName.c_str());
+            goto done;
+        }
+        if (hasVersion) saveEntities(topologyVersion);
     }
 
     LOG1("Found %lu entities, enumerating pads and links", mEntities.size());
@@ -493,6 +536,67 @@ int MediaControl::enumEntities(int fd, media_device_info& devInfo) {
     return OK;
 }
 
+int MediaControl::getTopologyVersion(int fd, uint64_t* version) {
+#ifdef MEDIA_IOC_G_TOPOLOGY
+    // Only the version and the object numbers are returned without the arrays.
+    struct media_v2_topology topology;
+    CLEAR(topology);
+    int ret = SysCall::getInstance()->ioctl(fd, MEDIA_IOC_G_TOPOLOGY,
+                                            static_cast<void*>(&topology));
+    CheckAndLogError(ret < 0, UNKNOWN_ERROR, "Unable to get the topology of %s (%s)",
+                     mDevName.c_str(), strerror(errno));
+
+    *version = topology.topology_version;
+    return OK;
+#else
+    UNUSED(fd);
+    UNUSED(version);
+    return INVALID_OPERATION;
+#endif
+}
+
+bool MediaControl::restoreEntities(uint64_t topologyVersion) {
+    if (sEntitySnapshot.empty() || sSnapshotDevName != mDevName ||
+        sSnapshotVersion != topologyVersion) {
+        return false;
+    }
+
+    for (const auto& snapshot : sEntitySnapshot) {
+        MediaEntity entity;
+        memset(&entity, 0, sizeof(MediaEntity));
+        entity.info = snapshot.info;
+        MEMCPY_S(entity.devname, sizeof(entity.devname), snapshot.devname,
+                 sizeof(snapshot.devname));
+
+        entity.maxLinks = entity.info.pads + entity.info.links;
+        entity.pads = new MediaPad[entity.info.pads];
+        entity.links = new MediaLink[entity.maxLinks];
+        mEntities.push_back(entity);
+
+        // Set after push_back, the same as enumEntities
+        for (uint32_t i = 0; i < entity.info.pads; ++i) {
+            entity.pads[i].entity = getEntityById(entity.info.id);
+        }
+    }
+    mMediaCfgId = sSnapshotMediaCfgId;
+
+    return true;
+}
+
+void MediaControl::saveEntities(uint64_t topologyVersion) {
+    sEntitySnapshot.clear();
+    for (const auto& entity : mEntities) {
+        EntitySnapshot snapshot;
+        snapshot.info = entity.info;
+        MEMCPY_S(snapshot.devname, sizeof(snapshot.devname), entity.devname,
+                 sizeof(entity.devname));
+        sEntitySnapshot.push_back(snapshot);
+    }
+    sSnapshotDevName = mDevName;
+    sSnapshotVersion = topologyVersion;
+    sSnapshotMediaCfgId = mMediaCfgId;
+}
+
 int MediaControl::getDevnameFromSysfs(MediaEntity* entity) {
     char sysName[MAX_SYS_NAME] = {'\0'};
     char target[MAX_TARGET_NAME] = {'\0'};
@@ -728,10 +832,24 @@ void MediaControl::setMediaMcCtl(int cameraId, vector<McCtl> ctls) {
         V4L2Subdevice* subDev = V4l2DeviceFactory::getSubDev(cameraId, entity->devname);
         LOG1("set Ctl %s [%d] cmd %s [0x%08x] value %d", ctl.entityName.c_str(), ctl.entity,
              ctl.ctlName.c_str(), ctl.ctlCmd, ctl.ctlValue);
-        if (subDev->SetControl(ctl.ctlCmd, ctl.ctlValue) != OK) {
+        // The controls are always set since they may be changed by others, like the flip.
+        int ret = subDev->SetControl(ctl.ctlCmd, ctl.ctlValue);
+        if (ret != OK) {
             LOGW("set Ctl %s [%d] cmd %s [0x%08x] value %d failed.", ctl.entityName.c_str(),
                  ctl.entity, ctl.ctlName.c_str(), ctl.ctlCmd, ctl.ctlValue);
         }
+
+        // A new value may change the formats of the entity, like the sensor binning mode.
+        auto key = std::make_pair(ctl.entity, ctl.ctlCmd);
+        auto applied = mAppliedCtls.find(key);
+        if (ret != OK || applied == mAppliedCtls.end() || applied->second != ctl.ctlValue) {
+            invalidateEntityState(ctl.entity);
+        }
+        if (ret == OK) {
+            mAppliedCtls[key] = ctl.ctlValue;
+        } else {
+            mAppliedCtls.erase(key);
+        }
     }
 }
 
@@ -740,6 +858,15 @@ int MediaControl::setMediaMcLink(vector<McLink> links) {
         LOG1("setup Link %s [%d:%d] ==> %s [%dx%d] enable %d.", link.srcEntityName.c_str(),
              link.srcEntity, link.srcPad, link.sinkEntityName.c_str(), link.sinkEntity,
              link.sinkPad, link.enable);
+        MediaLink* mediaLink = findLink(link.srcEntity, link.srcPad, link.sinkEntity,
+                                        link.sinkPad);
+        if (mIncremental && mediaLink &&
+            ((mediaLink->flags & MEDIA_LNK_FL_ENABLED) != 0) == link.enable) {
+            mSkippedCount++;
+            continue;
+        }
+
+        mAppliedCount++;
         int ret =
             setupLink(link.srcEntity, link.srcPad, link.sinkEntity, link.sinkPad, link.enable);
         CheckAndLogError(ret < 0, ret, "setup Link %s [%d:%d] ==> %s [%dx%d] enable %d failed.",
@@ -788,40 +915,86 @@ int MediaControl::setFormat(int cameraId, const McFormat* format, int targetWidt
     // VIRTUAL_CHANNEL_S
     fmt.stream = format->stream;
     // VIRTUAL_CHANNEL_E
+
+    PadKey key = std::make_tuple(format->entity, format->pad, format->stream);
+    auto applied = mAppliedFormats.find(key);
+    if (mIncremental && applied != mAppliedFormats.end() &&
+        memcmp(&applied->second, &mbusfmt, sizeof(mbusfmt)) == 0) {
+        LOG2("skip the same format %s [%d:%d/%d]", format->entityName.c_str(), format->entity,
+             format->pad, format->stream);
+        mSetupFormats.insert(key);
+        mSkippedCount++;
+
+        // The sink pads may be reset by their own settings since the last setup
+        auto source = mSourceFormats.find(key);
+        if ((pad->flags & MEDIA_PAD_FL_SOURCE) && source != mSourceFormats.end()) {
+            propagateFormat(cameraId, pad, source->second, format->stream, true);
+        }
+        return 0;
+    }
+
+    // The driver may propagate the format to the other pads of the entity.
+    invalidateEntityState(format->entity);
+    mAppliedCount++;
     ret = subDev->SetFormat(fmt);
     CheckAndLogError(ret < 0, BAD_VALUE, "set format %s [%d:%d] [%dx%d] %s failed.",
                      format->entityName.c_str(), format->entity, format->pad, format->width,
                      format->height, CameraUtils::pixelCode2String(format->pixelCode));
 
+    mAppliedFormats[key] = mbusfmt;
+    mSetupFormats.insert(key);
     mbusfmt = fmt.format;
 
     /* If the pad is an output pad, automatically set the same format on
      * the remote subdev input pads, if any.
      */
     if (pad->flags & MEDIA_PAD_FL_SOURCE) {
-        for (unsigned int i = 0; i < pad->entity->numLinks; ++i) {
-            MediaLink* link = &pad->entity->links[i];
-
-            if (!(link->flags & MEDIA_LNK_FL_ENABLED)) continue;
-
-            if (link->source == pad && link->sink->entity->info.type == MEDIA_ENT_T_V4L2_SUBDEV) {
-                auto subDev = V4l2DeviceFactory::getSubDev(cameraId, link->sink->entity->devname);
-
-                struct v4l2_subdev_format tmt = {};
-                tmt.format = mbusfmt;
-                tmt.pad = link->sink->index;
-                tmt.which = V4L2_SUBDEV_FORMAT_ACTIVE;
-                // VIRTUAL_CHANNEL_S
-                tmt.stream = format->stream;
-                // VIRTUAL_CHANNEL_E
-                subDev->SetFormat(tmt);
-            }
-        }
+        mSourceFormats[key] = mbusfmt;
+        propagateFormat(cameraId, pad, mbusfmt, format->stream, false);
     }
 
     return 0;
 }
 
+void MediaControl::propagateFormat(int cameraId, MediaPad* pad, const v4l2_mbus_framefmt& mbusfmt,
+                                   int stream, bool changedOnly) {
+    for (unsigned int i = 0; i < pad->entity->numLinks; ++i) {
+        MediaLink* link = &pad->entity->links[i];
+
+        if (!(link->flags & MEDIA_LNK_FL_ENABLED)) continue;
+        if (link->source != pad || link->sink->entity->info.type != MEDIA_ENT_T_V4L2_SUBDEV) {
+            continue;
+        }
+
+        int sinkEntity = link->sink->entity->info.id;
+        PadKey sinkKey = std::make_tuple(sinkEntity, static_cast<int>(link->sink->index), stream);
+        auto applied = mAppliedFormats.find(sinkKey);
+        if (changedOnly && applied != mAppliedFormats.end() &&
+            memcmp(&applied->second, &mbusfmt, sizeof(mbusfmt)) == 0) {
+            mSetupFormats.insert(sinkKey);
+            mSkippedCount++;
+            continue;
+        }
+
+        auto subDev = V4l2DeviceFactory::getSubDev(cameraId, link->sink->entity->devname);
+
+        struct v4l2_subdev_format tmt = {};
+        tmt.format = mbusfmt;
+        tmt.pad = link->sink->index;
+        tmt.which = V4L2_SUBDEV_FORMAT_ACTIVE;
+        // VIRTUAL_CHANNEL_S
+        tmt.stream = stream;
+        // VIRTUAL_CHANNEL_E
+
+        invalidateEntityState(sinkEntity);
+        mAppliedCount++;
+        if (subDev->SetFormat(tmt) == OK) {
+            mAppliedFormats[sinkKey] = mbusfmt;
+            mSetupFormats.insert(sinkKey);
+        }
+    }
+}
+
 int MediaControl::setSelection(int cameraId, const McFormat* format, int targetWidth,
                                int targetHeight) {
     PERF_CAMERA_ATRACE();
@@ -832,34 +1005,47 @@ int MediaControl::setSelection(int cameraId, const McFormat* format, int targetW
     LOG1("<id%d> @%s, targetWidth:%d, targetHeight:%d", cameraId, __func__, targetWidth,
          targetHeight);
 
+    struct v4l2_subdev_selection selection = {};
+    selection.pad = format->pad;
+    selection.which = V4L2_SUBDEV_FORMAT_ACTIVE;
+    selection.target = format->selCmd;
+    selection.flags = 0;
     if (format->top != -1 && format->left != -1 && format->width != 0 && format->height != 0) {
-        struct v4l2_subdev_selection selection = {};
-        selection.pad = format->pad;
-        selection.which = V4L2_SUBDEV_FORMAT_ACTIVE;
-        selection.target = format->selCmd;
-        selection.flags = 0;
         selection.r.top = format->top;
         selection.r.left = format->left;
         selection.r.width = format->width;
         selection.r.height = format->height;
-
-        ret = subDev->SetSelection(selection);
     } else if (format->selCmd == V4L2_SEL_TGT_CROP || format->selCmd == V4L2_SEL_TGT_COMPOSE) {
-        struct v4l2_subdev_selection selection = {};
-        selection.pad = format->pad;
-        selection.which = V4L2_SUBDEV_FORMAT_ACTIVE;
-        selection.target = format->selCmd;
-        selection.flags = 0;
         selection.r.top = 0;
         selection.r.left = 0;
         selection.r.width = targetWidth;
         selection.r.height = targetHeight;
-
-        ret = subDev->SetSelection(selection);
     } else {
         ret = BAD_VALUE;
     }
 
+    if (ret == OK) {
+        PadKey key = std::make_tuple(format->entity, format->pad, format->selCmd);
+        auto applied = mAppliedSelections.find(key);
+        if (mIncremental && applied != mAppliedSelections.end() &&
+            memcmp(&applied->second, &selection.r, sizeof(selection.r)) == 0) {
+            LOG2("skip the same selection %s [%d:%d] selCmd: %d", format->entityName.c_str(),
+                 format->entity, format->pad, format->selCmd);
+            mSetupSelections.insert(key);
+            mSkippedCount++;
+            return OK;
+        }
+
+        // The crop and compose rectangles change the source formats of the entity.
+        invalidateEntityState(format->entity);
+        mAppliedCount++;
+        ret = subDev->SetSelection(selection);
+        if (ret == OK) {
+            mAppliedSelections[key] = selection.r;
+            mSetupSelections.insert(key);
+        }
+    }
+
     CheckAndLogError(ret < 0, BAD_VALUE,
                      "set selection %s [%d:%d] selCmd: %d [%d, %d] [%dx%d] failed",
                      format->entityName.c_str(), format->entity, format->pad, format->selCmd,
@@ -868,8 +1054,85 @@ int MediaControl::setSelection(int cameraId, const McFormat* format, int targetW
     return OK;
 }
 
+// VIRTUAL_CHANNEL_S
+int MediaControl::setRouting(int cameraId, const string& entityName,
+                             const vector<McRoute>& routing) {
+    LOG1("<id%d> route entity:%s:", cameraId, entityName.c_str());
+    auto applied = mAppliedRoutes.find(entityName);
+    if (mIncremental && applied != mAppliedRoutes.end() &&
+        applied->second.size() == routing.size() &&
+        std::equal(routing.begin(), routing.end(), applied->second.begin(),
+                   [](const McRoute& a, const McRoute& b) {
+                       return a.sinkPad == b.sinkPad && a.sinkStream == b.sinkStream &&
+                              a.srcPad == b.srcPad && a.srcStream == b.srcStream &&
+                              a.flag == b.flag;
+                   })) {
+        mSkippedCount++;
+        return OK;
+    }
+
+    int num = routing.size();
+    v4l2_subdev_route* routes = new v4l2_subdev_route[num];
+    CheckAndLogError(!routes, NO_MEMORY, "Failed to alloc routes");
+    for (int i = 0; i < num; i++) {
+        const McRoute& route = routing[i];
+        v4l2_subdev_route r = {route.sinkPad, route.sinkStream, route.srcPad, route.srcStream,
+                               route.flag};
+        LOG1("   sinkPad:%d, srcPad:%d, sinkStream:%d, srcStream:%d, flag:%d", r.sink_pad,
+             r.source_pad, r.sink_stream, r.source_stream, route.flag);
+
+        routes[i] = r;
+    }
+    string subDeviceNodeName;
+    CameraUtils::getSubDeviceName(entityName.c_str(), subDeviceNodeName);
+    V4L2Subdevice* subDev = V4l2DeviceFactory::getSubDev(cameraId, subDeviceNodeName);
+
+    // The driver resets the formats of the entity with the new routes.
+    mAppliedRoutes.erase(entityName);
+    invalidateEntityState(getEntityIdByName(entityName.c_str()));
+    mAppliedCount++;
+    int ret = subDev->SetRouting(routes, num);
+    delete[] routes;
+    CheckAndLogError(ret != 0, ret, "setRouting fail, ret:%d", ret);
+
+    mAppliedRoutes[entityName] = routing;
+    return OK;
+}
+// VIRTUAL_CHANNEL_E
+
+void MediaControl::clearAppliedState() {
+    mAppliedFormats.clear();
+    mSourceFormats.clear();
+    mAppliedSelections.clear();
+    mAppliedCtls.clear();
+    mSetupFormats.clear();
+    mSetupSelections.clear();
+    // VIRTUAL_CHANNEL_S
+    mAppliedRoutes.clear();
+    // VIRTUAL_CHANNEL_E
+}
+
+void MediaControl::invalidateEntityState(int entity) {
+    for (auto it = mAppliedFormats.begin(); it != mAppliedFormats.end();) {
+        bool stale = std::get<0>(it->first) == entity && mSetupFormats.count(it->first) == 0;
+        it = stale ? mAppliedFormats.erase(it) : ++it;
+    }
+    for (auto it = mAppliedSelections.begin(); it != mAppliedSelections.end();) {
+        bool stale = std::get<0>(it->first) == entity && mSetupSelections.count(it->first) == 0;
+        it = stale ? mAppliedSelections.erase(it) : ++it;
+    }
+}
+
 int MediaControl::mediaCtlSetup(int cameraId, MediaCtlConf* mc, int width, int height, int field) {
     LOG1("<id%d> %s", cameraId, __func__);
+    AutoMutex l(mSetupLock);
+    // The applied state is always recorded, and only used when the incremental setup is enabled.
+    mIncremental = PlatformData::isIncrementalMediaCtlEnabled(cameraId);
+    mAppliedCount = 0;
+    mSkippedCount = 0;
+    mSetupFormats.clear();
+    mSetupSelections.clear();
+
     /* Setup controls in format Configuration */
     setMediaMcCtl(cameraId, mc->ctls);
 
@@ -877,25 +1140,11 @@ int MediaControl::mediaCtlSetup(int cameraId, MediaCtlConf* mc, int width, int h
     // VIRTUAL_CHANNEL_S
     /* Set routing */
     for (auto& routing : mc->routings) {
-        LOG1("<id%d> route entity:%s:", cameraId, routing.first.c_str());
-        int num = routing.second.size();
-        v4l2_subdev_route* routes = new v4l2_subdev_route[num];
-        CheckAndLogError(!routes, NO_MEMORY, "Failed to alloc routes");
-        for (int i = 0; i < num; i++) {
-            const McRoute& route = routing.second[i];
-            v4l2_subdev_route r = {route.sinkPad, route.sinkStream, route.srcPad, route.srcStream,
-                                   route.flag};
-            LOG1("   sinkPad:%d, srcPad:%d, sinkStream:%d, srcStream:%d, flag:%d", r.sink_pad,
-                 r.source_pad, r.sink_stream, r.source_stream, route.flag);
-
-            routes[i] = r;
+        ret = setRouting(cameraId, routing.first, routing.second);
+        if (ret != OK) {
+            clearAppliedState();
+            return ret;
         }
-        string subDeviceNodeName;
-        CameraUtils::getSubDeviceName(routing.first.c_str(), subDeviceNodeName);
-        V4L2Subdevice* subDev = V4l2DeviceFactory::getSubDev(cameraId, subDeviceNodeName);
-        ret = subDev->SetRouting(routes, num);
-        delete[] routes;
-        CheckAndLogError(ret != 0, ret, "setRouting fail, ret:%d", ret);
     }
     // VIRTUAL_CHANNEL_E
 
@@ -937,7 +1186,10 @@ int MediaControl::mediaCtlSetup(int cameraId, MediaCtlConf* mc, int width, int h
 
     /* Set link in format Configuration */
     ret = setMediaMcLink(mc->links);
+    if (ret != OK) clearAppliedState();
     CheckAndLogError(ret != OK, ret, "set MediaCtlConf McLink failed: ret = %d", ret);
+    LOG1("<id%d> %s: %d settings applied, %d skipped", cameraId, __func__, mAppliedCount,
+         mSkippedCount);
 
     // DUMP_ENTITY_TOPOLOGY_S
     dumpEntityTopology();
@@ -963,6 +1215,9 @@ int MediaControl::getVCMI2CAddr(const char* vcmName, string* vcmI2CAddr) {
 
 void MediaControl::mediaCtlClear(int cameraId, MediaCtlConf* mc) {
     LOG1("<id%d> %s", cameraId, __func__);
+    // The device is closed, the next setup applies all the settings.
+    AutoMutex l(mSetupLock);
+    clearAppliedState();
 
     // VIRTUAL_CHANNEL_S
     /* Clear routing */
@@ -29,7 +29,10 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <map>
+#include <set>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #ifdef HAVE_CHROME_OS
@@ -266,6 +269,9 @@ class MediaControl {
     /**
      * \brief Set up media controller pipe
      *
+     * With the incrementalMediaCtl camera setting, the links, routes, formats and selections
+     * which are the same as the ones applied by the last setup are skipped.
+     *
      * \param cameraId: the current camera id
      * \param mc: the MediaCtlConf got from platform data
      * \param sensorName: the sensor name get from platform data
@@ -314,6 +320,9 @@ class MediaControl {
     int getMediaCfgId() { return mMediaCfgId; }
 
  private:
+    // key: entity id, pad index, stream id or selection target
+    typedef std::tuple<int, int, int> PadKey;
+
     MediaControl& operator=(const MediaControl&);
     MediaControl(const char* devName);
     ~MediaControl();
@@ -326,6 +335,9 @@ class MediaControl {
     int enumInfo();
     int enumLinks(int fd);
     int enumEntities(int fd, media_device_info& devInfo);
+    int getTopologyVersion(int fd, uint64_t* version);
+    bool restoreEntities(uint64_t topologyVersion);
+    void saveEntities(uint64_t topologyVersion);
 
     // get entity info.
     int getDevnameFromSysfs(MediaEntity* entity);
@@ -336,6 +348,8 @@ class MediaControl {
     // set up entity link.
 
     MediaLink* entityAddLink(MediaEntity* entity);
+    MediaLink* findLink(uint32_t srcEntity, uint32_t srcPad, uint32_t sinkEntity,
+                        uint32_t sinkPad);
     int setupLink(uint32_t srcEntity, uint32_t srcPad, uint32_t sinkEntity, uint32_t sinkPad,
                   bool enable);
     int setupLink(MediaPad* source, MediaPad* sink, uint32_t flags);
@@ -346,6 +360,20 @@ class MediaControl {
     int setFormat(int cameraId, const McFormat* format, int targetWidth, int targetHeight,
                   int field);
     int setSelection(int cameraId, const McFormat* format, int targetWidth, int targetHeight);
+    /**
+     * Set the format of the source pad on the linked sub-device sink pads. If changedOnly is
+     * true, the sink pads whose applied format is the same are skipped.
+     */
+    void propagateFormat(int cameraId, MediaPad* pad, const v4l2_mbus_framefmt& mbusfmt,
+                         int stream, bool changedOnly);
+    // VIRTUAL_CHANNEL_S
+    int setRouting(int cameraId, const std::string& entityName,
+                   const std::vector<McRoute>& routes);
+    // VIRTUAL_CHANNEL_E
+
+    // The applied state, to skip the settings which aren't changed since the last setup
+    void clearAppliedState();
+    void invalidateEntityState(int entity);
 
     /* Dump functions */
     void dumpInfo(media_device_info& devInfo);
@@ -368,6 +396,24 @@ class MediaControl {
     static Mutex sLock;
 
     int mMediaCfgId;
+
+    // Guard the applied state below, which is updated by mediaCtlSetup and mediaCtlClear.
+    Mutex mSetupLock;
+    bool mIncremental;  // skip the unchanged settings in the running mediaCtlSetup
+    int mAppliedCount;
+    int mSkippedCount;
+    std::map<PadKey, v4l2_mbus_framefmt> mAppliedFormats;
+    // The formats the driver took for the source pads, which are propagated to the sink pads
+    std::map<PadKey, v4l2_mbus_framefmt> mSourceFormats;
+    std::map<PadKey, v4l2_rect> mAppliedSelections;
+    // The formats and selections set or skipped by the running setup, which are kept when
+    // the entity is invalidated by the following settings.
+    std::set<PadKey> mSetupFormats;
+    std::set<PadKey> mSetupSelections;
+    std::map<std::pair<int, int>, int> mAppliedCtls;  // key: entity id, ctl cmd
+    // VIRTUAL_CHANNEL_S
+    std::map<std::string, std::vector<McRoute>> mAppliedRoutes;  // key: entity name
+    // VIRTUAL_CHANNEL_E
 };
 
 }  // namespace icamera
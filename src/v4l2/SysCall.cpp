@@ -18,10 +18,17 @@
 
 #include "SysCall.h"
 
+#include <stdlib.h>
+
+#include "SysCallTrace.h"
 #include "iutils/CameraLog.h"
 
 namespace icamera {
 
+static const char* PROP_CAMERA_SYSCALL_RECORD = "cameraSysCallRecord";
+static const char* PROP_CAMERA_SYSCALL_REPLAY = "cameraSysCallReplay";
+static const char* PROP_CAMERA_SYSCALL_REPLAY_SPEED = "cameraSysCallReplaySpeed";
+
 static int sCreatedCount = 0;
 bool SysCall::sIsInitialized = false;
 SysCall* SysCall::sInstance = nullptr;
@@ -31,8 +38,17 @@ Mutex SysCall::sLock;
 /*static*/ SysCall* SysCall::getInstance() {
     AutoMutex lock(sLock);
     if (!sIsInitialized) {
-        // Use real sys call as default
-        sInstance = new SysCall();
+        // Use real sys call as default, or record or replay the calls for the tests
+        const char* recordPath = getenv(PROP_CAMERA_SYSCALL_RECORD);
+        const char* replayPath = getenv(PROP_CAMERA_SYSCALL_REPLAY);
+        if (replayPath) {
+            const char* speed = getenv(PROP_CAMERA_SYSCALL_REPLAY_SPEED);
+            sInstance = new SysCallReplayer(replayPath, speed ? atof(speed) : 1.0f);
+        } else if (recordPath) {
+            sInstance = new SysCallRecorder(recordPath);
+        } else {
+            sInstance = new SysCall();
+        }
         sIsInitialized = true;
     }
     return sInstance;
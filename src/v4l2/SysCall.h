@@ -69,12 +69,13 @@ class SysCall {
     virtual int ioctl(int fd, int request, struct v4l2_exportbuffer* arg);
 
     virtual int poll(struct pollfd* pfd, nfds_t nfds, int timeout);
+    // For the devices without the typed overloads, such as PSYS
+    virtual int ioctl(int fd, int request, void* arg);
 
     static SysCall* getInstance();
     static void updateInstance(SysCall* newSysCall);
 
  private:
-    int ioctl(int fd, int request, void* arg);
 
     SysCall& operator=(const SysCall&);  // Don't call me
 
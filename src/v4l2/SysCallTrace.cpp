@@ -0,0 +1,534 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG SysCallTrace
+
+#include "SysCallTrace.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "iutils/CameraLog.h"
+#include "iutils/Errors.h"
+#include "modules/ia_cipr/include/ipu-psys.h"
+
+namespace icamera {
+
+using namespace SysCallTrace;
+
+static const int kRecordBufferSize = 64 * 1024;
+
+SysCallRecorder::SysCallRecorder(const char* tracePath) : mFile(nullptr), mStartTime(0) {
+    mFile = fopen(tracePath, "wb");
+    CheckAndLogError(!mFile, VOID_VALUE, "failed to open trace %s: %s", tracePath,
+                     strerror(errno));
+    setvbuf(mFile, nullptr, _IOFBF, kRecordBufferSize);
+
+    FileHeader header = {kMagic, kVersion};
+    fwrite(&header, sizeof(header), 1, mFile);
+    mStartTime = CameraUtils::systemTime();
+    LOG1("%s: record the system calls to %s", __func__, tracePath);
+}
+
+SysCallRecorder::~SysCallRecorder() {
+    if (mFile) fclose(mFile);
+}
+
+void SysCallRecorder::writeRecord(CallType type, uint32_t request, int fd, int ret, int error,
+                                  nsecs_t start, const std::vector<Payload>& payloads) {
+    nsecs_t end = CameraUtils::systemTime();
+
+    AutoMutex l(mLock);
+    if (!mFile) return;
+
+    RecordHeader header = {};
+    header.type = type;
+    header.request = request;
+    header.fd = fd;
+    header.ret = ret;
+    header.error = error;
+    header.payloads = payloads.size();
+    header.startNs = start - mStartTime;
+    header.durationNs = end - start;
+    fwrite(&header, sizeof(header), 1, mFile);
+
+    for (const auto& payload : payloads) {
+        uint32_t size = payload.data ? payload.size : 0;
+        fwrite(&size, sizeof(size), 1, mFile);
+        if (size > 0) fwrite(payload.data, size, 1, mFile);
+    }
+
+    // Keep the trace complete after a device is closed, since SysCall is never released.
+    if (type == CALL_CLOSE) fflush(mFile);
+}
+
+int SysCallRecorder::open(const char* pathname, int flags) {
+    nsecs_t start = CameraUtils::systemTime();
+    int ret = SysCall::open(pathname, flags);
+    int error = errno;
+
+    std::vector<Payload> payloads = {
+        {const_cast<char*>(pathname), static_cast<uint32_t>(strlen(pathname) + 1)}};
+    writeRecord(CALL_OPEN, flags, ret, ret, error, start, payloads);
+
+    errno = error;
+    return ret;
+}
+
+int SysCallRecorder::close(int fd) {
+    nsecs_t start = CameraUtils::systemTime();
+    int ret = SysCall::close(fd);
+    int error = errno;
+
+    writeRecord(CALL_CLOSE, 0, fd, ret, error, start, {});
+
+    errno = error;
+    return ret;
+}
+
+int SysCallRecorder::ioctl(int fd, int request, struct media_entity_desc* arg) {
+    nsecs_t start = CameraUtils::systemTime();
+    int ret = SysCall::ioctl(fd, request, reinterpret_cast<void*>(arg));
+    int error = errno;
+
+    if (ret == 0) {
+        AutoMutex l(mLock);
+        mEntityLinks[arg->id] = std::make_pair(arg->pads, arg->links);
+    }
+    writeRecord(CALL_IOCTL, request, fd, ret, error, start, {{arg, sizeof(*arg)}});
+
+    errno = error;
+    return ret;
+}
+
+int SysCallRecorder::ioctl(int fd, int request, struct media_links_enum* arg) {
+    nsecs_t start = CameraUtils::systemTime();
+    int ret = SysCall::ioctl(fd, request, reinterpret_cast<void*>(arg));
+    int error = errno;
+
+    // The arrays are sized by the caller from the entity description.
+    uint32_t pads = 0;
+    uint32_t links = 0;
+    {
+        AutoMutex l(mLock);
+        auto it = mEntityLinks.find(arg->entity);
+        if (it != mEntityLinks.end()) {
+            pads = it->second.first;
+            links = it->second.second;
+        }
+    }
+    std::vector<Payload> payloads = {
+        {arg, sizeof(*arg)},
+        {arg->pads, static_cast<uint32_t>(pads * sizeof(media_pad_desc))},
+        {arg->links, static_cast<uint32_t>(links * sizeof(media_link_desc))}};
+    writeRecord(CALL_IOCTL, request, fd, ret, error, start, payloads);
+
+    errno = error;
+    return ret;
+}
+
+int SysCallRecorder::ioctl(int fd, int request, struct v4l2_buffer* arg) {
+    nsecs_t start = CameraUtils::systemTime();
+    int ret = SysCall::ioctl(fd, request, reinterpret_cast<void*>(arg));
+    int error = errno;
+
+    std::vector<Payload> payloads = {{arg, sizeof(*arg)}};
+    if (V4L2_TYPE_IS_MULTIPLANAR(arg->type)) {
+        payloads.push_back(
+            {arg->m.planes, static_cast<uint32_t>(arg->length * sizeof(v4l2_plane))});
+    }
+    writeRecord(CALL_IOCTL, request, fd, ret, error, start, payloads);
+
+    errno = error;
+    return ret;
+}
+
+int SysCallRecorder::ioctl(int fd, int request, struct v4l2_ext_controls* arg) {
+    nsecs_t start = CameraUtils::systemTime();
+    int ret = SysCall::ioctl(fd, request, reinterpret_cast<void*>(arg));
+    int error = errno;
+
+    std::vector<Payload> payloads = {
+        {arg, sizeof(*arg)},
+        {arg->controls, static_cast<uint32_t>(arg->count * sizeof(v4l2_ext_control))}};
+    writeRecord(CALL_IOCTL, request, fd, ret, error, start, payloads);
+
+    errno = error;
+    return ret;
+}
+
+int SysCallRecorder::ioctl(int fd, int request, struct v4l2_subdev_routing* arg) {
+    nsecs_t start = CameraUtils::systemTime();
+    int ret = SysCall::ioctl(fd, request, reinterpret_cast<void*>(arg));
+    int error = errno;
+
+    uint32_t numRoutes = std::min(arg->num_routes, arg->len_routes);
+    std::vector<Payload> payloads = {
+        {arg, sizeof(*arg)},
+        {reinterpret_cast<void*>(static_cast<uintptr_t>(arg->routes)),
+         static_cast<uint32_t>(numRoutes * sizeof(v4l2_subdev_route))}};
+    writeRecord(CALL_IOCTL, request, fd, ret, error, start, payloads);
+
+    errno = error;
+    return ret;
+}
+
+int SysCallRecorder::ioctl(int fd, int request, void* arg) {
+    nsecs_t start = CameraUtils::systemTime();
+    int ret = SysCall::ioctl(fd, request, arg);
+    int error = errno;
+
+    std::vector<Payload> payloads;
+    switch (static_cast<uint32_t>(request)) {
+        case IPU_IOC_MAPBUF:
+        case IPU_IOC_UNMAPBUF:
+            // The argument is the dma-buf fd itself.
+            break;
+        case IPU_IOC_QCMD:
+        case IPU_IOC_CMD_CANCEL: {
+            struct ipu_psys_command* cmd = static_cast<struct ipu_psys_command*>(arg);
+            payloads = {
+                {arg, sizeof(*cmd)},
+                {cmd->buffers, static_cast<uint32_t>(cmd->bufcount * sizeof(ipu_psys_buffer))},
+                {cmd->pg_manifest, cmd->pg_manifest_size}};
+            break;
+        }
+        case IPU_IOC_GET_MANIFEST: {
+            struct ipu_psys_manifest* manifest = static_cast<struct ipu_psys_manifest*>(arg);
+            payloads = {{arg, sizeof(*manifest)},
+                        {ret == 0 ? manifest->manifest : nullptr, manifest->size}};
+            break;
+        }
+        default:
+            // The arrays referred by other arguments are unknown, only the argument is recorded.
+            payloads = {{arg, static_cast<uint32_t>(_IOC_SIZE(request))}};
+            break;
+    }
+    writeRecord(CALL_IOCTL, request, fd, ret, error, start, payloads);
+
+    errno = error;
+    return ret;
+}
+
+int SysCallRecorder::poll(struct pollfd* pfd, nfds_t nfds, int timeout) {
+    nsecs_t start = CameraUtils::systemTime();
+    int ret = SysCall::poll(pfd, nfds, timeout);
+    int error = errno;
+
+    int fd = nfds > 0 ? pfd[0].fd : -1;
+    writeRecord(CALL_POLL, nfds, fd, ret, error, start,
+                {{pfd, static_cast<uint32_t>(nfds * sizeof(struct pollfd))}});
+
+    errno = error;
+    return ret;
+}
+
+SysCallReplayer::SysCallReplayer(const char* tracePath, float speed)
+        : mSpeed(speed),
+          mReplayedCount(0),
+          mMissedCount(0) {
+    int ret = loadTrace(tracePath);
+    CheckAndLogError(ret != OK, VOID_VALUE, "failed to load trace %s", tracePath);
+    LOG1("%s: replay the system calls from %s, speed %f", __func__, tracePath, mSpeed);
+}
+
+SysCallReplayer::~SysCallReplayer() {
+    LOG1("%s: %zu calls replayed, %zu calls missed", __func__, mReplayedCount, mMissedCount);
+}
+
+int SysCallReplayer::loadTrace(const char* tracePath) {
+    FILE* file = fopen(tracePath, "rb");
+    CheckAndLogError(!file, NAME_NOT_FOUND, "failed to open trace %s: %s", tracePath,
+                     strerror(errno));
+
+    FileHeader fileHeader = {};
+    if (fread(&fileHeader, sizeof(fileHeader), 1, file) != 1 || fileHeader.magic != kMagic ||
+        fileHeader.version != kVersion) {
+        LOGE("%s: invalid trace header of %s", __func__, tracePath);
+        fclose(file);
+        return BAD_VALUE;
+    }
+
+    size_t count = 0;
+    Record record;
+    while (fread(&record.header, sizeof(record.header), 1, file) == 1) {
+        record.payloads.resize(record.header.payloads);
+        bool complete = true;
+        for (auto& payload : record.payloads) {
+            uint32_t size = 0;
+            if (fread(&size, sizeof(size), 1, file) != 1) {
+                complete = false;
+                break;
+            }
+            payload.resize(size);
+            if (size > 0 && fread(payload.data(), size, 1, file) != 1) {
+                complete = false;
+                break;
+            }
+        }
+        // The last record may be cut off if the recording process was killed.
+        if (!complete) break;
+
+        RecordKey key = std::make_pair(record.header.type, record.header.request);
+        mRecords[key].push_back(record);
+        count++;
+    }
+    fclose(file);
+
+    LOG1("%s: %zu records loaded", __func__, count);
+    return OK;
+}
+
+int SysCallReplayer::replay(CallType type, uint32_t request, const std::vector<Payload>& payloads,
+                            bool copyOut, std::vector<std::vector<uint8_t>>* recordedPayloads) {
+    Record record;
+    {
+        AutoMutex l(mLock);
+        auto it = mRecords.find(std::make_pair(static_cast<uint32_t>(type), request));
+        if (it == mRecords.end() || it->second.empty()) {
+            mMissedCount++;
+            LOGW("%s: no record left for call %d, request 0x%x", __func__, type, request);
+            errno = ENODATA;
+            return -1;
+        }
+        record = std::move(it->second.front());
+        it->second.pop_front();
+        mReplayedCount++;
+    }
+
+    if (copyOut) {
+        size_t num = std::min(payloads.size(), record.payloads.size());
+        for (size_t i = 0; i < num; i++) {
+            const std::vector<uint8_t>& recorded = record.payloads[i];
+            if (!payloads[i].data || recorded.empty()) continue;
+
+            MEMCPY_S(payloads[i].data, payloads[i].size, recorded.data(), recorded.size());
+        }
+    }
+
+    if (mSpeed > 0 && record.header.durationNs > 0) {
+        int64_t waitNs = static_cast<int64_t>(record.header.durationNs / mSpeed);
+        struct timespec ts = {static_cast<time_t>(waitNs / 1000000000LL),
+                              static_cast<long>(waitNs % 1000000000LL)};
+        nanosleep(&ts, nullptr);
+    }
+
+    if (recordedPayloads) *recordedPayloads = std::move(record.payloads);
+
+    errno = record.header.error;
+    return record.header.ret;
+}
+
+int SysCallReplayer::open(const char* pathname, int flags) {
+    LOG1("%s: %s", __func__, pathname);
+    return replay(CALL_OPEN, flags, {}, false);
+}
+
+int SysCallReplayer::close(int fd) {
+    UNUSED(fd);
+    return replay(CALL_CLOSE, 0, {}, false);
+}
+
+void* SysCallReplayer::mmap(void* addr, size_t len, int prot, int flag, int filedes,
+                            off_t off) {
+    UNUSED(flag);
+    UNUSED(filedes);
+    UNUSED(off);
+    // No device memory, the caller gets the anonymous memory of the same size.
+    return ::mmap(addr, len, prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+}
+
+int SysCallReplayer::munmap(void* addr, size_t len) {
+    return ::munmap(addr, len);
+}
+
+int SysCallReplayer::ioctl(int fd, int request, struct media_entity_desc* arg) {
+    UNUSED(fd);
+    int ret = replay(CALL_IOCTL, request, {{arg, sizeof(*arg)}}, true);
+    if (ret == 0) {
+        AutoMutex l(mLock);
+        mEntityLinks[arg->id] = std::make_pair(arg->pads, arg->links);
+    }
+    return ret;
+}
+
+int SysCallReplayer::ioctl(int fd, int request, struct media_links_enum* arg) {
+    UNUSED(fd);
+    struct media_pad_desc* pads = arg->pads;
+    struct media_link_desc* links = arg->links;
+    // The arrays are sized by the caller from the replayed entity description.
+    uint32_t numPads = 0;
+    uint32_t numLinks = 0;
+    {
+        AutoMutex l(mLock);
+        auto it = mEntityLinks.find(arg->entity);
+        if (it != mEntityLinks.end()) {
+            numPads = it->second.first;
+            numLinks = it->second.second;
+        }
+    }
+    int ret = replay(CALL_IOCTL, request,
+                     {{arg, sizeof(*arg)},
+                      {pads, static_cast<uint32_t>(numPads * sizeof(media_pad_desc))},
+                      {links, static_cast<uint32_t>(numLinks * sizeof(media_link_desc))}},
+                     true);
+    arg->pads = pads;
+    arg->links = links;
+    return ret;
+}
+
+int SysCallReplayer::ioctl(int fd, int request, struct v4l2_buffer* arg) {
+    UNUSED(fd);
+    // Keep the memory of the caller, the recorded one isn't valid in this process.
+    auto m = arg->m;
+    uint32_t length = arg->length;
+
+    std::vector<Payload> payloads = {{arg, sizeof(*arg)}};
+    if (V4L2_TYPE_IS_MULTIPLANAR(arg->type)) {
+        payloads.push_back({m.planes, static_cast<uint32_t>(length * sizeof(v4l2_plane))});
+    }
+    int ret = replay(CALL_IOCTL, request, payloads, _IOC_DIR(request) & _IOC_READ);
+    arg->m = m;
+    arg->length = length;
+    return ret;
+}
+
+int SysCallReplayer::ioctl(int fd, int request, struct v4l2_ext_controls* arg) {
+    UNUSED(fd);
+    struct v4l2_ext_control* controls = arg->controls;
+    uint32_t count = arg->count;
+    int ret = replay(CALL_IOCTL, request,
+                     {{arg, sizeof(*arg)},
+                      {controls, static_cast<uint32_t>(count * sizeof(v4l2_ext_control))}},
+                     _IOC_DIR(request) & _IOC_READ);
+    arg->controls = controls;
+    arg->count = count;
+    return ret;
+}
+
+int SysCallReplayer::ioctl(int fd, int request, struct v4l2_subdev_routing* arg) {
+    UNUSED(fd);
+    __u64 routes = arg->routes;
+    uint32_t lenRoutes = arg->len_routes;
+    int ret = replay(CALL_IOCTL, request,
+                     {{arg, sizeof(*arg)},
+                      {reinterpret_cast<void*>(static_cast<uintptr_t>(routes)),
+                       static_cast<uint32_t>(lenRoutes * sizeof(v4l2_subdev_route))}},
+                     _IOC_DIR(request) & _IOC_READ);
+    arg->routes = routes;
+    arg->len_routes = lenRoutes;
+    return ret;
+}
+
+int SysCallReplayer::ioctl(int fd, int request, void* arg) {
+    UNUSED(fd);
+    switch (static_cast<uint32_t>(request)) {
+        case IPU_IOC_MAPBUF:
+        case IPU_IOC_UNMAPBUF:
+            // The argument is the dma-buf fd itself.
+            return replay(CALL_IOCTL, request, {}, false);
+        case IPU_IOC_QCMD:
+        case IPU_IOC_CMD_CANCEL:
+            return replayPsysCommand(request, static_cast<struct ipu_psys_command*>(arg));
+        case IPU_IOC_GET_MANIFEST:
+            return replayPsysManifest(request, static_cast<struct ipu_psys_manifest*>(arg));
+        case IPU_IOC_DQEVENT:
+            return replayPsysEvent(request, static_cast<struct ipu_psys_event*>(arg));
+        default:
+            break;
+    }
+
+    return replay(CALL_IOCTL, request, {{arg, static_cast<uint32_t>(_IOC_SIZE(request))}},
+                  _IOC_DIR(request) & _IOC_READ);
+}
+
+int SysCallReplayer::replayPsysCommand(int request, struct ipu_psys_command* cmd) {
+    // Keep the arrays of the caller, the buffers and the manifest are only read by the driver.
+    void* pgManifest = cmd->pg_manifest;
+    uint32_t pgManifestSize = cmd->pg_manifest_size;
+    struct ipu_psys_buffer* buffers = cmd->buffers;
+    uint32_t bufCount = cmd->bufcount;
+    // The issue id is an address in the recording process, the events are mapped back to ours.
+    uint64_t issueId = cmd->issue_id;
+    std::vector<std::vector<uint8_t>> recorded;
+    int ret = replay(CALL_IOCTL, request, {{cmd, sizeof(*cmd)}}, true, &recorded);
+    if (static_cast<uint32_t>(request) == IPU_IOC_QCMD && !recorded.empty() &&
+        recorded[0].size() >= sizeof(*cmd)) {
+        uint64_t recordedId = 0;
+        MEMCPY_S(&recordedId, sizeof(recordedId),
+                 recorded[0].data() + offsetof(struct ipu_psys_command, issue_id),
+                 sizeof(recordedId));
+        AutoMutex l(mLock);
+        mIssueIds[recordedId] = issueId;
+    }
+    cmd->issue_id = issueId;
+    cmd->pg_manifest = pgManifest;
+    cmd->pg_manifest_size = pgManifestSize;
+    cmd->buffers = buffers;
+    cmd->bufcount = bufCount;
+    return ret;
+}
+
+int SysCallReplayer::replayPsysManifest(int request, struct ipu_psys_manifest* manifest) {
+    void* data = manifest->manifest;
+    std::vector<std::vector<uint8_t>> recorded;
+    int ret = replay(CALL_IOCTL, request, {{manifest, sizeof(*manifest)}}, true, &recorded);
+    manifest->manifest = data;
+
+    // The blob is sized by the caller from the size returned by the previous call.
+    if (ret == 0 && data && recorded.size() > 1 && !recorded[1].empty()) {
+        MEMCPY_S(data, manifest->size, recorded[1].data(), recorded[1].size());
+    }
+    return ret;
+}
+
+int SysCallReplayer::replayPsysEvent(int request, struct ipu_psys_event* event) {
+    int ret = replay(CALL_IOCTL, request, {{event, sizeof(*event)}}, true);
+    if (ret != 0) return ret;
+
+    uint64_t recordedId = event->issue_id;
+    AutoMutex l(mLock);
+    auto it = mIssueIds.find(recordedId);
+    if (it != mIssueIds.end()) {
+        event->issue_id = it->second;
+    } else {
+        LOGW("%s: the command of issue id 0x%lx isn't replayed", __func__, recordedId);
+    }
+    return ret;
+}
+
+int SysCallReplayer::poll(struct pollfd* pfd, nfds_t nfds, int timeout) {
+    // Only the returned events are taken, the fds of the caller are kept.
+    std::vector<struct pollfd> recorded(pfd, pfd + nfds);
+    int ret = replay(CALL_POLL, nfds,
+                     {{recorded.data(), static_cast<uint32_t>(nfds * sizeof(pollfd))}}, true);
+    for (nfds_t i = 0; i < nfds; i++) {
+        pfd[i].revents = recorded[i].revents;
+    }
+    if (ret < 0 && errno == ENODATA) {
+        // Keep the polling threads from spinning after the trace is done.
+        int waitMs = timeout >= 0 ? timeout : 10;
+        struct timespec ts = {waitMs / 1000, (waitMs % 1000) * 1000000L};
+        nanosleep(&ts, nullptr);
+        return 0;
+    }
+    return ret;
+}
+
+}  // namespace icamera
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "SysCall.h"
+#include "iutils/Thread.h"
+#include "iutils/Utils.h"
+
+struct ipu_psys_command;
+struct ipu_psys_event;
+struct ipu_psys_manifest;
+
+namespace icamera {
+
+/**
+ * The binary trace of the system calls, which is written by SysCallRecorder and read by
+ * SysCallReplayer. It's the file header followed by the records, and each record is the
+ * record header followed by its payloads: the ioctl argument, the arrays referred by the
+ * argument, the pollfd array or the path of open.
+ */
+namespace SysCallTrace {
+
+const uint32_t kMagic = 0x52544353;  // "SCTR"
+const uint32_t kVersion = 1;
+
+enum CallType {
+    CALL_OPEN = 0,
+    CALL_CLOSE,
+    CALL_IOCTL,
+    CALL_POLL,
+};
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct RecordHeader {
+    uint32_t type;      // CallType
+    uint32_t request;   // the ioctl request, the open flags or the number of pollfd
+    int32_t fd;
+    int32_t ret;
+    int32_t error;      // errno after the call
+    uint32_t payloads;  // the number of payloads, each one is its uint32_t size and data
+    int64_t startNs;    // since the first record
+    int64_t durationNs;
+};
+
+// Memory region of one payload
+struct Payload {
+    void* data;
+    uint32_t size;
+};
+
+}  // namespace SysCallTrace
+
+/**
+ * \class SysCallRecorder
+ *
+ * Calls the system and writes every call with its argument payloads and timing to the trace.
+ * It's created by SysCall::getInstance when the cameraSysCallRecord env is set to the path of
+ * the trace.
+ */
+class SysCallRecorder : public SysCall {
+ public:
+    explicit SysCallRecorder(const char* tracePath);
+    virtual ~SysCallRecorder();
+
+    virtual int open(const char* pathname, int flags);
+    virtual int close(int fd);
+
+    virtual int ioctl(int fd, int request, struct media_entity_desc* arg);
+    virtual int ioctl(int fd, int request, struct media_links_enum* arg);
+    virtual int ioctl(int fd, int request, struct v4l2_buffer* arg);
+    virtual int ioctl(int fd, int request, struct v4l2_ext_controls* arg);
+    virtual int ioctl(int fd, int request, struct v4l2_subdev_routing* arg);
+    virtual int ioctl(int fd, int request, void* arg);
+
+    virtual int poll(struct pollfd* pfd, nfds_t nfds, int timeout);
+
+ private:
+    void writeRecord(SysCallTrace::CallType type, uint32_t request, int fd, int ret, int error,
+                     nsecs_t start, const std::vector<SysCallTrace::Payload>& payloads);
+
+ private:
+    Mutex mLock;  // protect the members below
+    FILE* mFile;
+    nsecs_t mStartTime;
+    // key: entity id, value: the number of pads and links, to record media_links_enum
+    std::map<uint32_t, std::pair<uint32_t, uint32_t>> mEntityLinks;
+
+    DISALLOW_COPY_AND_ASSIGN(SysCallRecorder);
+};
+
+/**
+ * \class SysCallReplayer
+ *
+ * Feeds the callers from the trace without calling the system. The calls are matched with
+ * the records of the same type and request in order, so the calls from different threads
+ * don't need to be in the recorded order. Each call takes its recorded duration divided by
+ * the speed, 0 means no waiting.
+ * Only the calls through SysCall are replayed: the media device, the PSYS device and the
+ * batched sensor controls of SensorHwCtrl. The V4L2 library opens the sub-devices and the
+ * video nodes and sets their formats, selections, routing and single controls with the system
+ * calls directly, so those still need the devices.
+ * It's created by SysCall::getInstance when the cameraSysCallReplay env is set to the path of
+ * the trace, and the speed is set by the cameraSysCallReplaySpeed env, 1.0 by default.
+ */
+class SysCallReplayer : public SysCall {
+ public:
+    SysCallReplayer(const char* tracePath, float speed);
+    virtual ~SysCallReplayer();
+
+    virtual int open(const char* pathname, int flags);
+    virtual int close(int fd);
+    virtual void* mmap(void* addr, size_t len, int prot, int flag, int filedes, off_t off);
+    virtual int munmap(void* addr, size_t len);
+
+    virtual int ioctl(int fd, int request, struct media_entity_desc* arg);
+    virtual int ioctl(int fd, int request, struct media_links_enum* arg);
+    virtual int ioctl(int fd, int request, struct v4l2_buffer* arg);
+    virtual int ioctl(int fd, int request, struct v4l2_ext_controls* arg);
+    virtual int ioctl(int fd, int request, struct v4l2_subdev_routing* arg);
+    virtual int ioctl(int fd, int request, void* arg);
+
+    virtual int poll(struct pollfd* pfd, nfds_t nfds, int timeout);
+
+ private:
+    struct Record {
+        SysCallTrace::RecordHeader header;
+        std::vector<std::vector<uint8_t>> payloads;
+    };
+    typedef std::pair<uint32_t, uint32_t> RecordKey;  // type, request
+
+    int loadTrace(const char* tracePath);
+    /**
+     * Take the next record of the call, copy its payloads to the caller and wait for its
+     * duration. Only the payloads read by the caller are copied for ioctl. The recorded
+     * payloads are returned by recordedPayloads if it isn't nullptr.
+     *
+     * \return the recorded return value, or -1 with ENODATA if there is no record left
+     */
+    int replay(SysCallTrace::CallType type, uint32_t request,
+               const std::vector<SysCallTrace::Payload>& payloads, bool copyOut,
+               std::vector<std::vector<uint8_t>>* recordedPayloads = nullptr);
+    int replayPsysCommand(int request, struct ipu_psys_command* cmd);
+    int replayPsysManifest(int request, struct ipu_psys_manifest* manifest);
+    int replayPsysEvent(int request, struct ipu_psys_event* event);
+
+ private:
+    float mSpeed;
+    Mutex mLock;  // protect the records, mEntityLinks and mIssueIds
+    std::map<RecordKey, std::deque<Record>> mRecords;
+    size_t mReplayedCount;
+    size_t mMissedCount;
+    // key: entity id, value: the number of pads and links, to replay media_links_enum
+    std::map<uint32_t, std::pair<uint32_t, uint32_t>> mEntityLinks;
+    // key: the recorded PSYS command issue id, value: the one of this process
+    std::map<uint64_t, uint64_t> mIssueIds;
+
+    DISALLOW_COPY_AND_ASSIGN(SysCallReplayer);
+};
+
+}  // namespace icamera
@@ -26,6 +26,16 @@
 
 namespace icamera {
 
+namespace {
+
+// fd_ of V4L2Device is protected and only V4L2DevicePoller is its friend, read it through
+// a derived class so the local and the cros V4L2Device are both supported.
+struct V4l2DeviceFd : public V4L2Device {
+    static int get(V4L2Device* device) { return device->*(&V4l2DeviceFd::fd_); }
+};
+
+}  // namespace
+
 std::map<int, V4l2DeviceFactory*> V4l2DeviceFactory::sInstances;
 Mutex V4l2DeviceFactory::sLock;
 
@@ -108,6 +118,10 @@ void V4l2DeviceFactory::releaseSubDev(int cameraId, const std::string& devName)
     }
 }
 
+int V4l2DeviceFactory::getDeviceFd(V4L2Device* device) {
+    return device ? V4l2DeviceFd::get(device) : -1;
+}
+
 /**
  * Release all sub devices in device map
  *
@@ -45,6 +45,12 @@ class V4l2DeviceFactory {
     static V4L2Subdevice* getSubDev(int cameraId, const std::string& devName);
     static void releaseSubDev(int cameraId, const std::string& devName);
 
+    /**
+     * Get the fd of an opened device, for the system calls which V4L2Device doesn't wrap,
+     * such as epoll and the grouped control writes. -1 is returned if it isn't opened.
+     */
+    static int getDeviceFd(V4L2Device* device);
+
  private:
     V4l2DeviceFactory(int cameraId);
     ~V4l2DeviceFactory();
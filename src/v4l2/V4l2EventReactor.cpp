@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG V4l2EventReactor
+
+#include "V4l2EventReactor.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "V4l2DeviceFactory.h"
+#include "iutils/CameraLog.h"
+
+namespace icamera {
+
+V4l2EventReactor* V4l2EventReactor::sInstance = nullptr;
+Mutex V4l2EventReactor::sLock;
+
+V4l2EventReactor* V4l2EventReactor::getInstance() {
+    AutoMutex lock(sLock);
+    if (!sInstance) {
+        sInstance = new V4l2EventReactor();
+    }
+    return sInstance;
+}
+
+void V4l2EventReactor::releaseInstance() {
+    AutoMutex lock(sLock);
+    if (sInstance) {
+        delete sInstance;
+        sInstance = nullptr;
+    }
+}
+
+V4l2EventReactor::V4l2EventReactor()
+        : mEpollFd(-1),
+          mWakeFd(-1),
+          mThread(nullptr),
+          mDispatching(nullptr),
+          mExiting(false) {
+    mEpollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    CheckAndLogError(mEpollFd < 0, VOID_VALUE, "failed to create epoll: %s", strerror(errno));
+
+    mWakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event event;
+    CLEAR(event);
+    event.events = EPOLLIN;
+    event.data.fd = mWakeFd;
+    if (mWakeFd < 0 || ::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFd, &event) < 0) {
+        LOGE("failed to create the wake up fd: %s", strerror(errno));
+        if (mWakeFd >= 0) ::close(mWakeFd);
+        ::close(mEpollFd);
+        mWakeFd = -1;
+        mEpollFd = -1;
+        return;
+    }
+
+    mThread = new ReactorThread(this);
+    mThread->run("V4l2Reactor", PRIORITY_URGENT_AUDIO);
+    LOG1("%s, epoll fd %d, wake fd %d", __func__, mEpollFd, mWakeFd);
+}
+
+V4l2EventReactor::~V4l2EventReactor() {
+    LOG1("%s, %zu handlers left", __func__, mHandlers.size());
+
+    if (mThread) {
+        {
+            AutoMutex l(mLock);
+            mExiting = true;
+        }
+        mThread->requestExit();
+        wakeUp();
+        mThread->requestExitAndWait();
+        delete mThread;
+    }
+
+    if (mWakeFd >= 0) ::close(mWakeFd);
+    if (mEpollFd >= 0) ::close(mEpollFd);
+}
+
+int V4l2EventReactor::addHandler(Handler* handler, const std::vector<V4L2Device*>& devices,
+                                 int timeoutMs) {
+    CheckAndLogError(!handler || devices.empty(), BAD_VALUE, "%s: invalid handler or devices",
+                     __func__);
+    CheckAndLogError(mEpollFd < 0, NO_INIT, "%s: reactor isn't initialized", __func__);
+
+    AutoMutex l(mLock);
+    CheckAndLogError(mHandlers.find(handler) != mHandlers.end(), INVALID_OPERATION,
+                     "%s: handler %p is already added", __func__, handler);
+
+    HandlerInfo& info = mHandlers[handler];
+    info.timeoutMs = timeoutMs;
+    info.lastActive = CameraUtils::systemTime();
+
+    for (auto device : devices) {
+        int fd = V4l2DeviceFactory::getDeviceFd(device);
+        struct epoll_event event;
+        CLEAR(event);
+        // The ISYS devices are all capture devices, EPOLLOUT would keep them ready
+        event.events = EPOLLIN | EPOLLPRI;
+        event.data.fd = fd;
+        if (fd < 0 || mDevices.find(fd) != mDevices.end() ||
+            ::epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            LOGE("%s: failed to watch device fd %d: %s", __func__, fd, strerror(errno));
+            removeHandlerLocked(handler);
+            return UNKNOWN_ERROR;
+        }
+        info.fds.push_back(fd);
+        mDevices[fd] = std::make_pair(handler, device);
+    }
+    LOG1("%s: handler %p, %zu devices, timeout %dms", __func__, handler, devices.size(),
+         timeoutMs);
+
+    // Wake up the reactor thread to count the timeout of the new handler
+    wakeUp();
+    return OK;
+}
+
+void V4l2EventReactor::removeHandler(Handler* handler) {
+    ConditionLock l(mLock);
+    removeHandlerLocked(handler);
+
+    // The handler stops watching itself in its callback, no need to wait.
+    if (std::this_thread::get_id() == mDispatchThreadId) return;
+
+    while (mDispatching == handler) {
+        mDispatchCondition.wait(l);
+    }
+    LOG1("%s: handler %p", __func__, handler);
+}
+
+void V4l2EventReactor::removeHandlerLocked(Handler* handler) {
+    auto it = mHandlers.find(handler);
+    if (it == mHandlers.end()) return;
+
+    for (auto fd : it->second.fds) {
+        ::epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+        mDevices.erase(fd);
+    }
+    mHandlers.erase(it);
+}
+
+void V4l2EventReactor::wakeUp() {
+    uint64_t value = 1;
+    int size = ::write(mWakeFd, &value, sizeof(value));
+    if (size != sizeof(value)) LOGW("%s: write wake fd failed: %s", __func__, strerror(errno));
+}
+
+int V4l2EventReactor::getWaitTimeoutLocked(nsecs_t now) {
+    int timeoutMs = -1;
+    for (const auto& item : mHandlers) {
+        if (item.second.timeoutMs <= 0) continue;
+
+        nsecs_t left = item.second.lastActive + item.second.timeoutMs * 1000000LL - now;
+        // Round up, or the timeout is checked earlier and waits again for less than 1ms.
+        int leftMs = left > 0 ? static_cast<int>((left + 999999) / 1000000) : 0;
+        if (timeoutMs < 0 || leftMs < timeoutMs) timeoutMs = leftMs;
+    }
+    return timeoutMs;
+}
+
+bool V4l2EventReactor::waitAndDispatch() {
+    int timeoutMs = -1;
+    {
+        AutoMutex l(mLock);
+        if (mExiting) return false;
+
+        mDispatchThreadId = std::this_thread::get_id();
+        timeoutMs = getWaitTimeoutLocked(CameraUtils::systemTime());
+    }
+
+    struct epoll_event events[kMaxEvents];
+    int num = ::epoll_wait(mEpollFd, events, kMaxEvents, timeoutMs);
+    if (num < 0) {
+        if (errno == EINTR) return true;
+        LOGE("%s: epoll wait error: %s", __func__, strerror(errno));
+        return false;
+    }
+
+    for (int i = 0; i < num; i++) {
+        if (events[i].data.fd == mWakeFd) {
+            uint64_t value = 0;
+            int size = ::read(mWakeFd, &value, sizeof(value));
+            LOG2("%s: woken up, read size %d", __func__, size);
+            continue;
+        }
+        dispatchDevice(events[i].data.fd, events[i].events);
+    }
+    dispatchTimeout();
+
+    return true;
+}
+
+void V4l2EventReactor::dispatchDevice(int fd, uint32_t events) {
+    Handler* handler = nullptr;
+    V4L2Device* device = nullptr;
+    {
+        AutoMutex l(mLock);
+        // The handler may be removed by the callbacks before it in the same wait.
+        auto it = mDevices.find(fd);
+        if (it == mDevices.end()) return;
+
+        handler = it->second.first;
+        device = it->second.second;
+        mHandlers[handler].lastActive = CameraUtils::systemTime();
+        mDispatching = handler;
+    }
+
+    LOG2("%s: fd %d, events 0x%x", __func__, fd, events);
+    finishDispatch(handler, handler->onDeviceReady(device, events));
+}
+
+void V4l2EventReactor::dispatchTimeout() {
+    while (true) {
+        Handler* handler = nullptr;
+        {
+            AutoMutex l(mLock);
+            nsecs_t now = CameraUtils::systemTime();
+            for (auto& item : mHandlers) {
+                HandlerInfo& info = item.second;
+                if (info.timeoutMs > 0 && now - info.lastActive >= info.timeoutMs * 1000000LL) {
+                    info.lastActive = now;
+                    handler = item.first;
+                    break;
+                }
+            }
+            if (!handler) return;
+
+            mDispatching = handler;
+        }
+
+        LOG2("%s: handler %p", __func__, handler);
+        finishDispatch(handler, handler->onDeviceTimeout());
+    }
+}
+
+void V4l2EventReactor::finishDispatch(Handler* handler, bool keep) {
+    AutoMutex l(mLock);
+    mDispatching = nullptr;
+    if (!keep) removeHandlerLocked(handler);
+    mDispatchCondition.broadcast();
+}
+
+}  // namespace icamera
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#ifdef HAVE_CHROME_OS
+#include <cros-camera/v4l2_device.h>
+#else
+#include <v4l2_device.h>
+#endif
+
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "iutils/Errors.h"
+#include "iutils/Thread.h"
+#include "iutils/Utils.h"
+
+namespace icamera {
+
+/**
+ * \class V4l2EventReactor
+ *
+ * One epoll thread shared by all the cameras, which waits for the V4L2 video nodes and
+ * sub devices of the ISYS capture instead of one poll thread per device.
+ *
+ * The users register their devices with a Handler, which is called in the reactor thread
+ * when one of the devices is ready. The handlers run one by one, so they should only
+ * dequeue the buffer or event and hand it over, like the poll threads did.
+ */
+class V4l2EventReactor {
+ public:
+    class Handler {
+     public:
+        virtual ~Handler() {}
+
+        /**
+         * \brief Called when the device is ready, the events are EPOLLIN, EPOLLPRI, EPOLLERR...
+         *
+         * \return false to stop watching the devices of the handler, like Thread::threadLoop
+         */
+        virtual bool onDeviceReady(V4L2Device* device, uint32_t events) = 0;
+
+        /**
+         * \brief Called when none of the devices is ready within the timeout of the handler.
+         *
+         * \return false to stop watching the devices of the handler
+         */
+        virtual bool onDeviceTimeout() { return true; }
+    };
+
+    static V4l2EventReactor* getInstance();
+    static void releaseInstance();
+
+    /**
+     * \brief Start watching the devices, the handler is called in the reactor thread.
+     *
+     * \param[in] handler: the handler of the devices, a handler can only be added once
+     * \param[in] devices: the opened devices
+     * \param[in] timeoutMs: call onDeviceTimeout after it without any device ready, 0 to disable
+     *
+     * \return OK if succeed, other value indicates failed
+     */
+    int addHandler(Handler* handler, const std::vector<V4L2Device*>& devices, int timeoutMs);
+
+    /**
+     * \brief Stop watching the devices of the handler.
+     *
+     * It waits for the running callback of the handler if it's not called in the callback,
+     * so the handler can be released after it.
+     */
+    void removeHandler(Handler* handler);
+
+ private:
+    V4l2EventReactor();
+    ~V4l2EventReactor();
+
+    class ReactorThread : public Thread {
+        V4l2EventReactor* mReactor;
+
+     public:
+        explicit ReactorThread(V4l2EventReactor* reactor) : mReactor(reactor) {}
+
+        virtual bool threadLoop() { return mReactor->waitAndDispatch(); }
+    };
+
+    struct HandlerInfo {
+        std::vector<int> fds;
+        int timeoutMs;
+        nsecs_t lastActive;
+    };
+
+    bool waitAndDispatch();
+    int getWaitTimeoutLocked(nsecs_t now);
+    void dispatchDevice(int fd, uint32_t events);
+    void dispatchTimeout();
+    void finishDispatch(Handler* handler, bool keep);
+    void removeHandlerLocked(Handler* handler);
+    void wakeUp();
+
+ private:
+    static V4l2EventReactor* sInstance;
+    static Mutex sLock;
+
+    static const int kMaxEvents = 16;
+
+    int mEpollFd;
+    int mWakeFd;  // eventfd to wake up the reactor thread
+    ReactorThread* mThread;
+
+    Mutex mLock;  // protect the members below
+    Condition mDispatchCondition;
+    std::map<Handler*, HandlerInfo> mHandlers;
+    std::map<int, std::pair<Handler*, V4L2Device*>> mDevices;  // key: fd
+    Handler* mDispatching;                                     // the handler being called
+    std::thread::id mDispatchThreadId;
+    bool mExiting;
+
+    DISALLOW_COPY_AND_ASSIGN(V4l2EventReactor);
+};
+
+}  // namespace icamera
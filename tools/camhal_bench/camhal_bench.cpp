@@ -0,0 +1,572 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * camhal_bench drives N cameras x M streams through the libcamhal API at the maximum rate:
+ * all the buffers are queued, and each group of buffers is queued again as soon as it's
+ * dequeued. It reports the qbuf to dqbuf latency, the API call timings, the CPU time and the
+ * heap allocations per frame in JSON.
+ *
+ * Without the sensor, the frames can be injected with cameraInjectFile, and the PSYS calls
+ * can be replayed with cameraSysCallReplay.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <linux/videodev2.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ICamera.h"
+#include "Parameters.h"
+
+using icamera::camera_buffer_t;
+using icamera::stream_config_t;
+using icamera::stream_t;
+
+// The heap allocations of the whole process, including libcamhal and the C libraries it uses.
+// They are counted in the malloc family, which replaces the glibc one and allocates with its
+// __libc_ entries, and operator new allocates with malloc, so each allocation counts once.
+static std::atomic<uint64_t> gAllocCount(0);
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) noexcept {
+    gAllocCount++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size) noexcept {
+    gAllocCount++;
+    return __libc_calloc(num, size);
+}
+
+// Shrinking or freeing by realloc isn't an allocation, but it's rare enough to count anyway
+void* realloc(void* ptr, size_t size) noexcept {
+    gAllocCount++;
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    gAllocCount++;
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) return EINVAL;
+    void* mem = memalign(alignment, size);
+    if (!mem) return ENOMEM;
+    *ptr = mem;
+    return 0;
+}
+}  // extern "C"
+
+void* operator new(size_t size) {
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* ptr = memalign(static_cast<size_t>(alignment), size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return memalign(static_cast<size_t>(alignment), size ? size : 1);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return memalign(static_cast<size_t>(alignment), size ? size : 1);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+#endif
+
+namespace {
+
+int64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t cpuUs() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL + usage.ru_utime.tv_usec +
+           usage.ru_stime.tv_usec;
+}
+
+struct Options {
+    std::vector<int> cameras = {0};
+    int streams = 1;
+    int width = 1920;
+    int height = 1080;
+    int format = V4L2_PIX_FMT_NV12;
+    int buffers = 6;
+    int frames = 300;
+    int warmup = 30;
+    const char* output = nullptr;
+};
+
+class Samples {
+ public:
+    void reserve(size_t size) { mValues.reserve(size); }
+    void add(int64_t ns) { mValues.push_back(ns); }
+
+    // Write the percentiles in microseconds
+    void writeJson(FILE* file, const char* name) {
+        std::sort(mValues.begin(), mValues.end());
+        double sum = 0;
+        for (auto value : mValues) sum += value;
+
+        fprintf(file, "\"%s\": {\"count\": %zu, \"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, "
+                      "\"p99\": %.1f, \"max\": %.1f}",
+                name, mValues.size(), mValues.empty() ? 0 : sum / mValues.size() / 1000,
+                percentile(50), percentile(90), percentile(99), percentile(100));
+    }
+
+ private:
+    double percentile(int p) const {
+        if (mValues.empty()) return 0;
+        size_t index = (mValues.size() - 1) * p / 100;
+        return mValues[index] / 1000.0;
+    }
+
+    std::vector<int64_t> mValues;
+};
+
+struct CameraContext {
+    int id = 0;
+    int status = 0;
+    bool opened = false;
+    std::vector<stream_t> streams;
+    std::vector<std::vector<camera_buffer_t>> buffers;  // [stream][buffer]
+    std::map<camera_buffer_t*, int64_t> qbufTime;
+
+    int frames = 0;
+    int64_t streamingNs = 0;
+    int64_t openNs = 0;
+    int64_t configNs = 0;
+    int64_t startNs = 0;
+    int64_t stopNs = 0;
+    int64_t closeNs = 0;
+    Samples qbufCall;
+    Samples dqbufCall;
+    Samples latency;
+};
+
+void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -c, --cameras <ids>     camera ids separated by ',', default 0\n"
+            "  -s, --streams <num>     streams per camera, default 1\n"
+            "  -w, --width <width>     default 1920\n"
+            "  -h, --height <height>   default 1080\n"
+            "  -f, --format <fourcc>   default NV12\n"
+            "  -b, --buffers <num>     buffers per stream, default 6\n"
+            "  -n, --frames <num>      frames per camera, default 300\n"
+            "  -u, --warmup <num>      frames excluded from the latency, default 30\n"
+            "  -o, --output <file>     the JSON report, default stdout\n",
+            name);
+}
+
+bool parseOptions(int argc, char* argv[], Options* options) {
+    static const struct option longOptions[] = {
+        {"cameras", required_argument, nullptr, 'c'}, {"streams", required_argument, nullptr, 's'},
+        {"width", required_argument, nullptr, 'w'},   {"height", required_argument, nullptr, 'h'},
+        {"format", required_argument, nullptr, 'f'},  {"buffers", required_argument, nullptr, 'b'},
+        {"frames", required_argument, nullptr, 'n'},  {"warmup", required_argument, nullptr, 'u'},
+        {"output", required_argument, nullptr, 'o'},  {nullptr, 0, nullptr, 0}};
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "c:s:w:h:f:b:n:u:o:", longOptions, nullptr)) != -1) {
+        switch (opt) {
+            case 'c': {
+                options->cameras.clear();
+                std::string ids = optarg;
+                size_t pos = 0;
+                while (pos <= ids.size()) {
+                    size_t end = ids.find(',', pos);
+                    if (end == std::string::npos) end = ids.size();
+                    options->cameras.push_back(atoi(ids.substr(pos, end - pos).c_str()));
+                    pos = end + 1;
+                }
+                break;
+            }
+            case 's':
+                options->streams = atoi(optarg);
+                break;
+            case 'w':
+                options->width = atoi(optarg);
+                break;
+            case 'h':
+                options->height = atoi(optarg);
+                break;
+            case 'f':
+                if (strlen(optarg) != 4) return false;
+                options->format = v4l2_fourcc(optarg[0], optarg[1], optarg[2], optarg[3]);
+                break;
+            case 'b':
+                options->buffers = atoi(optarg);
+                break;
+            case 'n':
+                options->frames = atoi(optarg);
+                break;
+            case 'u':
+                options->warmup = atoi(optarg);
+                break;
+            case 'o':
+                options->output = optarg;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    return !options->cameras.empty() && options->streams > 0 && options->buffers > 0 &&
+           options->frames > options->warmup && options->warmup >= 0 &&
+           options->frames >= options->buffers;
+}
+
+int setupCamera(const Options& options, CameraContext* ctx) {
+    int64_t start = nowNs();
+    int ret = icamera::camera_device_open(ctx->id);
+    ctx->openNs = nowNs() - start;
+    if (ret != 0) {
+        fprintf(stderr, "camera %d: open failed %d\n", ctx->id, ret);
+        return ret;
+    }
+    ctx->opened = true;
+
+    // Keep the allocations of the bench itself out of the streaming
+    ctx->qbufCall.reserve(options.frames);
+    ctx->dqbufCall.reserve(options.frames * options.streams);
+    ctx->latency.reserve(options.frames * options.streams);
+
+    ctx->streams.resize(options.streams);
+    for (auto& stream : ctx->streams) {
+        memset(&stream, 0, sizeof(stream));
+        stream.format = options.format;
+        stream.width = options.width;
+        stream.height = options.height;
+        stream.field = V4L2_FIELD_ANY;
+        stream.memType = V4L2_MEMORY_USERPTR;
+        stream.usage = icamera::CAMERA_STREAM_PREVIEW;
+        stream.streamType = icamera::CAMERA_STREAM_OUTPUT;
+    }
+    stream_config_t streamList;
+    memset(&streamList, 0, sizeof(streamList));
+    streamList.num_streams = options.streams;
+    streamList.streams = ctx->streams.data();
+    streamList.operation_mode = icamera::CAMERA_STREAM_CONFIGURATION_MODE_AUTO;
+
+    start = nowNs();
+    ret = icamera::camera_device_config_streams(ctx->id, &streamList);
+    ctx->configNs = nowNs() - start;
+    if (ret != 0) {
+        fprintf(stderr, "camera %d: config streams failed %d\n", ctx->id, ret);
+        return ret;
+    }
+
+    ctx->buffers.resize(options.streams);
+    for (int s = 0; s < options.streams; s++) {
+        const stream_t& stream = ctx->streams[s];
+        int bpp = 0;
+        int size = icamera::get_frame_size(ctx->id, stream.format, stream.width, stream.height,
+                                           stream.field, &bpp);
+        if (size <= 0) {
+            fprintf(stderr, "camera %d: invalid frame size %d\n", ctx->id, size);
+            return -1;
+        }
+
+        ctx->buffers[s].resize(options.buffers);
+        for (auto& buffer : ctx->buffers[s]) {
+            memset(&buffer, 0, sizeof(buffer));
+            buffer.s = stream;
+            buffer.s.size = size;
+            if (posix_memalign(&buffer.addr, getpagesize(), size) != 0) {
+                fprintf(stderr, "camera %d: failed to allocate %d bytes\n", ctx->id, size);
+                return -1;
+            }
+        }
+    }
+
+    // Queue all the buffers, one buffer of each stream per request
+    for (int b = 0; b < options.buffers; b++) {
+        std::vector<camera_buffer_t*> group;
+        for (int s = 0; s < options.streams; s++) group.push_back(&ctx->buffers[s][b]);
+
+        int64_t qbufTime = nowNs();
+        ret = icamera::camera_stream_qbuf(ctx->id, group.data(), group.size());
+        if (ret != 0) {
+            fprintf(stderr, "camera %d: qbuf failed %d\n", ctx->id, ret);
+            return ret;
+        }
+        for (auto buffer : group) ctx->qbufTime[buffer] = qbufTime;
+    }
+
+    start = nowNs();
+    ret = icamera::camera_device_start(ctx->id);
+    ctx->startNs = nowNs() - start;
+    if (ret != 0) fprintf(stderr, "camera %d: start failed %d\n", ctx->id, ret);
+    return ret;
+}
+
+void runCamera(const Options& options, CameraContext* ctx) {
+    std::vector<camera_buffer_t*> group(options.streams);
+    int64_t streamingStart = nowNs();
+
+    for (int frame = 0; frame < options.frames; frame++) {
+        bool measured = frame >= options.warmup;
+        for (int s = 0; s < options.streams; s++) {
+            camera_buffer_t* buffer = nullptr;
+            int64_t start = nowNs();
+            int ret = icamera::camera_stream_dqbuf(ctx->id, ctx->streams[s].id, &buffer);
+            int64_t end = nowNs();
+            if (ret != 0 || !buffer) {
+                fprintf(stderr, "camera %d: dqbuf stream %d failed %d\n", ctx->id, s, ret);
+                ctx->status = ret ? ret : -1;
+                return;
+            }
+
+            if (measured) {
+                ctx->dqbufCall.add(end - start);
+                ctx->latency.add(end - ctx->qbufTime[buffer]);
+            }
+            group[s] = buffer;
+        }
+        ctx->frames++;
+
+        // The buffers in flight are enough for the remaining frames
+        if (frame + options.buffers >= options.frames) continue;
+
+        int64_t start = nowNs();
+        int ret = icamera::camera_stream_qbuf(ctx->id, group.data(), group.size());
+        int64_t end = nowNs();
+        if (ret != 0) {
+            fprintf(stderr, "camera %d: qbuf failed %d\n", ctx->id, ret);
+            ctx->status = ret;
+            return;
+        }
+        if (measured) ctx->qbufCall.add(end - start);
+        for (auto buffer : group) ctx->qbufTime[buffer] = start;
+    }
+
+    ctx->streamingNs = nowNs() - streamingStart;
+}
+
+void teardownCamera(CameraContext* ctx) {
+    if (!ctx->opened) return;
+
+    int64_t start = nowNs();
+    icamera::camera_device_stop(ctx->id);
+    ctx->stopNs = nowNs() - start;
+
+    start = nowNs();
+    icamera::camera_device_close(ctx->id);
+    ctx->closeNs = nowNs() - start;
+
+    for (auto& buffers : ctx->buffers) {
+        for (auto& buffer : buffers) free(buffer.addr);
+    }
+}
+
+void writeReport(FILE* file, const Options& options, std::vector<CameraContext>* cameras,
+                 int64_t wallNs, int64_t cpuTimeUs, uint64_t allocs) {
+    int totalFrames = 0;
+    for (auto& ctx : *cameras) totalFrames += ctx.frames;
+    char format[5] = {static_cast<char>(options.format & 0xff),
+                      static_cast<char>((options.format >> 8) & 0xff),
+                      static_cast<char>((options.format >> 16) & 0xff),
+                      static_cast<char>((options.format >> 24) & 0xff), '\0'};
+
+    fprintf(file, "{\n  \"config\": {\"cameras\": %zu, \"streams\": %d, \"width\": %d, "
+                  "\"height\": %d, \"format\": \"%s\", \"buffers\": %d, \"frames\": %d, "
+                  "\"warmup\": %d},\n",
+            cameras->size(), options.streams, options.width, options.height, format,
+            options.buffers, options.frames, options.warmup);
+    fprintf(file, "  \"wall_ms\": %.3f,\n  \"frames\": %d,\n  \"fps\": %.2f,\n", wallNs / 1e6,
+            totalFrames, wallNs > 0 ? totalFrames * 1e9 / wallNs : 0);
+    fprintf(file, "  \"cpu_us_per_frame\": %.1f,\n  \"allocs_per_frame\": %.1f,\n",
+            totalFrames ? static_cast<double>(cpuTimeUs) / totalFrames : 0,
+            totalFrames ? static_cast<double>(allocs) / totalFrames : 0);
+    fprintf(file, "  \"cameras\": [\n");
+
+    for (size_t i = 0; i < cameras->size(); i++) {
+        CameraContext& ctx = (*cameras)[i];
+        fprintf(file, "    {\"id\": %d, \"status\": %d, \"frames\": %d, \"fps\": %.2f,\n", ctx.id,
+                ctx.status, ctx.frames,
+                ctx.streamingNs > 0 ? ctx.frames * 1e9 / ctx.streamingNs : 0);
+        fprintf(file, "     \"stages_ms\": {\"open\": %.3f, \"config\": %.3f, \"start\": %.3f, "
+                      "\"stop\": %.3f, \"close\": %.3f},\n     ",
+                ctx.openNs / 1e6, ctx.configNs / 1e6, ctx.startNs / 1e6, ctx.stopNs / 1e6,
+                ctx.closeNs / 1e6);
+        ctx.latency.writeJson(file, "latency_us");
+        fprintf(file, ",\n     ");
+        ctx.qbufCall.writeJson(file, "qbuf_us");
+        fprintf(file, ",\n     ");
+        ctx.dqbufCall.writeJson(file, "dqbuf_us");
+        fprintf(file, "}%s\n", i + 1 < cameras->size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int ret = icamera::camera_hal_init();
+    if (ret != 0) {
+        fprintf(stderr, "camera_hal_init failed %d\n", ret);
+        return 1;
+    }
+
+    int cameraNum = icamera::get_number_of_cameras();
+    std::vector<CameraContext> cameras(options.cameras.size());
+    for (size_t i = 0; i < cameras.size(); i++) {
+        cameras[i].id = options.cameras[i];
+        if (cameras[i].id < 0 || cameras[i].id >= cameraNum) {
+            fprintf(stderr, "invalid camera %d, %d cameras found\n", cameras[i].id, cameraNum);
+            icamera::camera_hal_deinit();
+            return 1;
+        }
+    }
+
+    int failed = 0;
+    for (auto& ctx : cameras) {
+        ctx.status = setupCamera(options, &ctx);
+        if (ctx.status != 0) failed++;
+    }
+
+    int64_t cpuStart = cpuUs();
+    uint64_t allocStart = gAllocCount;
+    int64_t wallStart = nowNs();
+    if (failed == 0) {
+        std::vector<std::thread> threads;
+        for (auto& ctx : cameras) threads.emplace_back(runCamera, std::cref(options), &ctx);
+        for (auto& thread : threads) thread.join();
+    }
+    int64_t wallNs = nowNs() - wallStart;
+    uint64_t allocs = gAllocCount - allocStart;
+    int64_t cpuTimeUs = cpuUs() - cpuStart;
+
+    for (auto& ctx : cameras) {
+        teardownCamera(&ctx);
+        if (ctx.status != 0) failed++;
+    }
+    icamera::camera_hal_deinit();
+
+    FILE* file = options.output ? fopen(options.output, "w") : stdout;
+    if (!file) {
+        fprintf(stderr, "failed to open %s\n", options.output);
+        return 1;
+    }
+    writeReport(file, options, &cameras, wallNs, cpuTimeUs, allocs);
+    if (file != stdout) fclose(file);
+
+    return failed ? 1 : 0;
+}
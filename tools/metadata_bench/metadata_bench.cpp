@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * metadata_bench measures the tag lookups of CameraMetadata, which go through its tag slot
+ * index, against the entry search of icamera_metadata_base on the same buffer: the linear
+ * scan of the unsorted buffer that the updates leave, and the binary search of the sorted
+ * one. The metadata is filled with the defined tags in random order, like the request
+ * metadata of Parameters. It reports the nanoseconds per call in JSON.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "src/metadata/CameraMetadata.h"
+#include "src/metadata/icamera_metadata_base.h"
+
+using icamera::CameraMetadata;
+
+namespace {
+
+int64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct Options {
+    int entries = 0;  // 0 means all the defined tags
+    int lookups = 1000000;
+    unsigned int seed = 1;
+    const char* output = nullptr;
+};
+
+// Keeps the results of the lookups alive, so they aren't optimized out
+volatile size_t gSink = 0;
+
+void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -e, --entries <num>     the entries in the metadata, default all the tags\n"
+            "  -n, --lookups <num>     the calls of each case, default 1000000\n"
+            "  -s, --seed <num>        the seed of the tag order, default 1\n"
+            "  -o, --output <file>     the JSON report, default stdout\n",
+            name);
+}
+
+bool parseOptions(int argc, char* argv[], Options* options) {
+    static const struct option longOptions[] = {
+        {"entries", required_argument, nullptr, 'e'}, {"lookups", required_argument, nullptr, 'n'},
+        {"seed", required_argument, nullptr, 's'},    {"output", required_argument, nullptr, 'o'},
+        {nullptr, 0, nullptr, 0}};
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "e:n:s:o:", longOptions, nullptr)) != -1) {
+        switch (opt) {
+            case 'e':
+                options->entries = atoi(optarg);
+                break;
+            case 'n':
+                options->lookups = atoi(optarg);
+                break;
+            case 's':
+                options->seed = strtoul(optarg, nullptr, 0);
+                break;
+            case 'o':
+                options->output = optarg;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    return options->entries >= 0 && options->lookups > 0;
+}
+
+// All the defined tags, the camera sections and then the vendor sections
+std::vector<uint32_t> getDefinedTags() {
+    std::vector<uint32_t> tags;
+    for (uint32_t section = 0; section < CAMERA_SECTION_COUNT; section++) {
+        for (uint32_t tag = icamera_metadata_section_bounds[section][0];
+             tag < icamera_metadata_section_bounds[section][1]; tag++) {
+            tags.push_back(tag);
+        }
+    }
+    for (uint32_t section = INTEL_VENDOR_CAMERA_SECTION; section < INTEL_VENDOR_CAMERA_SECTION_END;
+         section++) {
+        for (uint32_t tag = section << 16; get_icamera_metadata_tag_type(tag) >= 0; tag++) {
+            tags.push_back(tag);
+        }
+    }
+    return tags;
+}
+
+// One value of the type of the tag
+void addEntry(CameraMetadata* metadata, uint32_t tag) {
+    const uint8_t u8 = 1;
+    const int32_t i32 = 1;
+    const float f = 1.0f;
+    const int64_t i64 = 1;
+    const double d = 1.0;
+    const icamera_metadata_rational_t r = {1, 1};
+    switch (get_icamera_metadata_tag_type(tag)) {
+        case ICAMERA_TYPE_BYTE:
+            metadata->update(tag, &u8, 1);
+            break;
+        case ICAMERA_TYPE_INT32:
+            metadata->update(tag, &i32, 1);
+            break;
+        case ICAMERA_TYPE_FLOAT:
+            metadata->update(tag, &f, 1);
+            break;
+        case ICAMERA_TYPE_INT64:
+            metadata->update(tag, &i64, 1);
+            break;
+        case ICAMERA_TYPE_DOUBLE:
+            metadata->update(tag, &d, 1);
+            break;
+        case ICAMERA_TYPE_RATIONAL:
+            metadata->update(tag, &r, 1);
+            break;
+        default:
+            break;
+    }
+}
+
+// Run func on the tags in turn for the number of lookups, return the nanoseconds per call
+template <typename Func>
+double measure(const std::vector<uint32_t>& tags, int lookups, Func func) {
+    size_t sink = 0;
+    int64_t start = nowNs();
+    for (int i = 0; i < lookups; i++) {
+        sink += func(tags[i % tags.size()]);
+    }
+    int64_t ns = nowNs() - start;
+    gSink = gSink + sink;
+    return static_cast<double>(ns) / lookups;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<uint32_t> tags = getDefinedTags();
+    std::mt19937 random(options.seed);
+    std::shuffle(tags.begin(), tags.end(), random);
+    size_t entries = options.entries ? std::min<size_t>(options.entries, tags.size()) : tags.size();
+    std::vector<uint32_t> present(tags.begin(), tags.begin() + entries);
+    std::vector<uint32_t> missing(tags.begin() + entries, tags.end());
+
+    CameraMetadata metadata;
+    for (auto tag : present) addEntry(&metadata, tag);
+
+    CameraMetadata sorted(metadata);
+    sorted.sort();
+
+    // The lookups run in another random order than the insertions
+    std::vector<uint32_t> lookupTags(present);
+    std::shuffle(lookupTags.begin(), lookupTags.end(), random);
+
+    const CameraMetadata& constMetadata = metadata;
+    const icamera_metadata_t* buffer = constMetadata.getBuffer();
+    const icamera_metadata_t* sortedBuffer = static_cast<const CameraMetadata&>(sorted).getBuffer();
+
+    double indexFindNs = measure(lookupTags, options.lookups, [&](uint32_t tag) {
+        return constMetadata.find(tag).count;
+    });
+    double linearFindNs = measure(lookupTags, options.lookups, [&](uint32_t tag) {
+        icamera_metadata_ro_entry_t entry;
+        return find_icamera_metadata_ro_entry(buffer, tag, &entry) == 0 ? entry.count : 0;
+    });
+    double sortedFindNs = measure(lookupTags, options.lookups, [&](uint32_t tag) {
+        icamera_metadata_ro_entry_t entry;
+        return find_icamera_metadata_ro_entry(sortedBuffer, tag, &entry) == 0 ? entry.count : 0;
+    });
+    double missingNs = missing.empty() ? 0 : measure(missing, options.lookups, [&](uint32_t tag) {
+        return static_cast<size_t>(constMetadata.exists(tag));
+    });
+    // The same values are written again, so the buffer doesn't change
+    double updateNs = measure(lookupTags, options.lookups, [&](uint32_t tag) {
+        addEntry(&metadata, tag);
+        return static_cast<size_t>(1);
+    });
+
+    FILE* file = options.output ? fopen(options.output, "w") : stdout;
+    if (!file) {
+        fprintf(stderr, "failed to open %s\n", options.output);
+        return 1;
+    }
+    fprintf(file, "{\n  \"config\": {\"entries\": %zu, \"tags\": %zu, \"lookups\": %d, "
+                  "\"seed\": %u},\n",
+            entries, tags.size(), options.lookups, options.seed);
+    fprintf(file, "  \"find_index_ns\": %.2f,\n  \"find_linear_ns\": %.2f,\n"
+                  "  \"find_sorted_ns\": %.2f,\n  \"exists_missing_ns\": %.2f,\n"
+                  "  \"update_ns\": %.2f\n}\n",
+            indexFindNs, linearFindNs, sortedFindNs, missingNs, updateNs);
+    if (file != stdout) fclose(file);
+
+    return 0;
+}
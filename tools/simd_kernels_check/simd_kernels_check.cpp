@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2024 Intel Corporation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * simd_kernels_check compares every SimdKernels kernel with the scalar formula documented in
+ * SimdKernels.h on random rows, widths and parameters. The bytes written by a kernel must be
+ * the same as the scalar ones, and the bytes after the returned count must be untouched.
+ * The source rows end right before an inaccessible page, so reading beyond the readable size
+ * crashes.
+ *
+ * The kernels of the SIMD level of the CPU are checked, the SSE4.2 ones run at the AVX2 level
+ * too. With cameraSimd=0 all the kernels must return 0.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "src/image_process/SimdKernels.h"
+
+using icamera::SimdKernels;
+
+static const unsigned char kGuard = 0xa5;
+static const short kGuardShort = 0x5a5a;
+
+static std::mt19937 gRandom;
+
+static int randomInt(int minValue, int maxValue) {
+    return std::uniform_int_distribution<int>(minValue, maxValue)(gRandom);
+}
+
+/**
+ * A source row of random samples, which ends right before an inaccessible page. Reading
+ * beyond the row crashes, even by the gathers which AddressSanitizer doesn't check.
+ */
+template <typename T>
+class GuardedRow {
+ public:
+    GuardedRow(size_t size, int maxValue) {
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t bytes = size * sizeof(T);
+        mMapSize = (bytes + page - 1) / page * page + page;
+        void* map = mmap(nullptr, mMapSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED || mprotect(static_cast<unsigned char*>(map) + mMapSize - page,
+                                          page, PROT_NONE) != 0) {
+            perror("simd_kernels_check: failed to map the row");
+            exit(1);
+        }
+        mMap = static_cast<unsigned char*>(map);
+        mData = reinterpret_cast<T*>(mMap + mMapSize - page - bytes);
+        for (size_t i = 0; i < size; i++) mData[i] = static_cast<T>(randomInt(0, maxValue));
+    }
+    ~GuardedRow() { munmap(mMap, mMapSize); }
+
+    const T* data() const { return mData; }
+    const T& operator[](size_t i) const { return mData[i]; }
+
+ private:
+    GuardedRow(const GuardedRow&) = delete;
+    GuardedRow& operator=(const GuardedRow&) = delete;
+
+    unsigned char* mMap;
+    size_t mMapSize;
+    T* mData;
+};
+
+static inline unsigned char clampByte(int val) {
+    return static_cast<unsigned char>(std::min(std::max(val, 0), 255));
+}
+
+struct KernelResult {
+    const char* name;
+    int cases;
+    int simdCases;  // The cases where the kernel has written something
+    int failures;
+};
+
+/**
+ * Compare the output of a kernel with the scalar reference, the kernel must have written
+ * [0, done) exactly as the reference and nothing from done on.
+ */
+template <typename T>
+static bool checkRow(KernelResult* result, const char* row, int done, int count,
+                     const std::vector<T>& out, const std::vector<T>& ref, T guard) {
+    result->cases++;
+    if (done > 0) result->simdCases++;
+
+    const char* error = nullptr;
+    int at = 0;
+    if (done < 0 || done > count) {
+        error = "invalid count";
+    } else if (SimdKernels::getSimdLevel() == icamera::SIMD_LEVEL_NONE && done != 0) {
+        error = "SIMD is disabled";
+    } else {
+        for (at = 0; at < static_cast<int>(out.size()); at++) {
+            if (at < done && out[at] != ref[at]) {
+                error = "mismatch";
+                break;
+            }
+            if (at >= done && out[at] != guard) {
+                error = "written beyond the count";
+                break;
+            }
+        }
+    }
+    if (!error) return true;
+
+    if (result->failures++ < 8) {
+        fprintf(stderr, "%s %s: %s at %d, count %d, done %d", result->name, row, error, at,
+                count, done);
+        if (at < static_cast<int>(out.size())) {
+            fprintf(stderr, ", got %d expected %d", out[at], ref[at]);
+        }
+        fprintf(stderr, "\n");
+    }
+    return false;
+}
+
+static void checkBilinearRow(KernelResult* result) {
+    // The layouts of the callers: YUY2, Y plane and interleaved UV plane
+    static const int kLayouts[][2] = {{2, 4}, {0, 1}, {1, 2}};
+    const int* layout = kLayouts[randomInt(0, 2)];
+    int groupShift = layout[0];
+    int step = layout[1];
+    int channels = 1 << groupShift;
+    int count = randomInt(1, 160) * channels;
+    int offset = randomInt(0, 4);
+    int scale = randomInt(32, 1024);
+    int dy = randomInt(0, 255);
+    // The scalar code reads x + step of the last output byte
+    int groups = count >> groupShift;
+    int limit = ((((groups - 1) * scale) >> 8) + offset + 1) * step + channels + randomInt(0, 8);
+
+    GuardedRow<unsigned char> row0(limit, 255);
+    GuardedRow<unsigned char> row1(limit, 255);
+    std::vector<unsigned char> ref(count);
+    for (int j = 0; j < count; j++) {
+        int p = (j >> groupShift) * scale;
+        int dx = p & 0xff;
+        int x = ((p >> 8) + offset) * step + (j & (channels - 1));
+        int h0 = (row0[x] * (256 - dx) + row0[x + step] * dx) >> 8;
+        int h1 = (row1[x] * (256 - dx) + row1[x + step] * dx) >> 8;
+        ref[j] = (h0 * (256 - dy) + h1 * dy) >> 8;
+    }
+
+    std::vector<unsigned char> out(count, kGuard);
+    int done = SimdKernels::bilinearRow(out.data(), row0.data(), row1.data(), count, groupShift,
+                                        step, offset, scale, dy, limit);
+    checkRow(result, "dst", done, count, out, ref, kGuard);
+}
+
+static void checkBilinearRowQ16(KernelResult* result) {
+    int count = randomInt(1, 400);
+    unsigned int sx0 = randomInt(0, 8 << 16);
+    unsigned int sxd = randomInt(1 << 12, 3 << 16);
+    unsigned int fy = randomInt(0, 0xffff);
+    int limit = static_cast<int>((sx0 + (count - 1) * sxd) >> 16) + 2 + randomInt(0, 8);
+
+    GuardedRow<unsigned char> row0(limit, 255);
+    GuardedRow<unsigned char> row1(limit, 255);
+    std::vector<unsigned char> ref(count);
+    for (int j = 0; j < count; j++) {
+        unsigned int sx = sx0 + j * sxd;
+        unsigned int x = sx >> 16;
+        unsigned int fx = sx & 0xffff;
+        unsigned int h0 = (row0[x] * (0x10000 - fx) + row0[x + 1] * fx) >> 16;
+        unsigned int h1 = (row1[x] * (0x10000 - fx) + row1[x + 1] * fx) >> 16;
+        ref[j] = (h0 * (0x10000 - fy) + h1 * fy) >> 16;
+    }
+
+    std::vector<unsigned char> out(count, kGuard);
+    int done = SimdKernels::bilinearRowQ16(out.data(), row0.data(), row1.data(), count, sx0, sxd,
+                                           fy, limit);
+    checkRow(result, "dst", done, count, out, ref, kGuard);
+}
+
+static void checkAverage2x2Row(KernelResult* result) {
+    bool interleaved = randomInt(0, 1);
+    int count = randomInt(1, 200) * (interleaved ? 2 : 1);
+
+    GuardedRow<unsigned char> row0(count * 2, 255);
+    GuardedRow<unsigned char> row1(count * 2, 255);
+    std::vector<unsigned char> ref(count);
+    for (int j = 0; j < count; j++) {
+        // The UV pairs of NV12: the samples of U0 are at 0 and 2, V0 at 1 and 3
+        int x = interleaved ? (j & ~1) * 2 + (j & 1) : j * 2;
+        int next = interleaved ? x + 2 : x + 1;
+        ref[j] = (row0[x] + row0[next] + row1[x] + row1[next] + 2) / 4;
+    }
+
+    std::vector<unsigned char> out(count, kGuard);
+    int done =
+        SimdKernels::average2x2Row(out.data(), row0.data(), row1.data(), count, interleaved);
+    checkRow(result, "dst", done, count, out, ref, kGuard);
+}
+
+static void checkSwapBytePairsRow(KernelResult* result) {
+    int count = randomInt(1, 400) * 2;
+
+    GuardedRow<unsigned char> src(count, 255);
+    std::vector<unsigned char> ref(count);
+    for (int j = 0; j < count; j += 2) {
+        ref[j] = src[j + 1];
+        ref[j + 1] = src[j];
+    }
+
+    std::vector<unsigned char> out(count, kGuard);
+    int done = SimdKernels::swapBytePairsRow(out.data(), src.data(), count);
+    if (done % 2) done = -1;
+    checkRow(result, "dst", done, count, out, ref, kGuard);
+}
+
+static void checkDeinterleaveRow(KernelResult* result) {
+    int count = randomInt(1, 400);
+    int outputs = randomInt(1, 3);  // bit 0: even, bit 1: odd
+
+    GuardedRow<unsigned char> src(count * 2, 255);
+    std::vector<unsigned char> refEven(count), refOdd(count);
+    for (int j = 0; j < count; j++) {
+        refEven[j] = src[2 * j];
+        refOdd[j] = src[2 * j + 1];
+    }
+
+    std::vector<unsigned char> even(count, kGuard), odd(count, kGuard);
+    int done = SimdKernels::deinterleaveRow((outputs & 1) ? even.data() : nullptr,
+                                            (outputs & 2) ? odd.data() : nullptr, src.data(),
+                                            count);
+    // The unused output is left untouched, as if nothing has been written
+    checkRow(result, "even", (outputs & 1) ? done : 0, count, even, refEven, kGuard);
+    checkRow(result, "odd", (outputs & 2) ? done : 0, count, odd, refOdd, kGuard);
+}
+
+static void checkInterleaveRow(KernelResult* result) {
+    int count = randomInt(1, 400);
+
+    GuardedRow<unsigned char> even(count, 255);
+    GuardedRow<unsigned char> odd(count, 255);
+    std::vector<unsigned char> ref(count * 2);
+    for (int j = 0; j < count; j++) {
+        ref[2 * j] = even[j];
+        ref[2 * j + 1] = odd[j];
+    }
+
+    std::vector<unsigned char> out(count * 2, kGuard);
+    int done = SimdKernels::interleaveRow(out.data(), even.data(), odd.data(), count);
+    // Compare the pairs
+    checkRow(result, "dst", done * 2, count * 2, out, ref, kGuard);
+}
+
+static void checkDemosaicRow(KernelResult* result) {
+    int count = randomInt(2, 400);
+    bool siteEven = randomInt(0, 1);
+
+    // The columns -1 and count are readable
+    GuardedRow<short> above(count + 2, 1023);
+    GuardedRow<short> cur(count + 2, 1023);
+    GuardedRow<short> below(count + 2, 1023);
+    const short* a = above.data() + 1;
+    const short* c = cur.data() + 1;
+    const short* b = below.data() + 1;
+    std::vector<short> refOwn(count), refG(count), refOther(count);
+    for (int x = 0; x < count; x++) {
+        int lr = c[x - 1] + c[x + 1];
+        int ud = a[x] + b[x];
+        if (((x & 1) == 0) == siteEven) {
+            refOwn[x] = c[x];
+            refG[x] = (lr + ud + 2) >> 2;
+            refOther[x] = (a[x - 1] + a[x + 1] + b[x - 1] + b[x + 1] + 2) >> 2;
+        } else {
+            refOwn[x] = (lr + 1) >> 1;
+            refG[x] = c[x];
+            refOther[x] = (ud + 1) >> 1;
+        }
+    }
+
+    std::vector<short> own(count, kGuardShort), g(count, kGuardShort), other(count, kGuardShort);
+    int done = SimdKernels::demosaicRow(own.data(), g.data(), other.data(), a, c, b, count,
+                                        siteEven);
+    checkRow(result, "own", done, count, own, refOwn, kGuardShort);
+    checkRow(result, "g", done, count, g, refG, kGuardShort);
+    checkRow(result, "other", done, count, other, refOther, kGuardShort);
+}
+
+static void checkRgbToYRow(KernelResult* result) {
+    int count = randomInt(1, 400);
+
+    GuardedRow<short> r(count, 1023);
+    GuardedRow<short> g(count, 1023);
+    GuardedRow<short> b(count, 1023);
+    std::vector<unsigned char> ref(count);
+    for (int j = 0; j < count; j++) {
+        ref[j] = clampByte(((2105 * r[j] + 4129 * g[j] + 803 * b[j] + 16384) >> 15) + 16);
+    }
+
+    std::vector<unsigned char> out(count, kGuard);
+    int done = SimdKernels::rgbToYRow(out.data(), r.data(), g.data(), b.data(), count);
+    checkRow(result, "y", done, count, out, ref, kGuard);
+}
+
+static void checkRgbToUVRow(KernelResult* result) {
+    int count = randomInt(1, 200);
+    bool twoRows = randomInt(0, 1);
+
+    GuardedRow<short> r0(count * 2, 1023);
+    GuardedRow<short> g0(count * 2, 1023);
+    GuardedRow<short> b0(count * 2, 1023);
+    GuardedRow<short> r1(count * 2, 1023);
+    GuardedRow<short> g1(count * 2, 1023);
+    GuardedRow<short> b1(count * 2, 1023);
+    std::vector<unsigned char> ref(count * 2);
+    for (int j = 0; j < count; j++) {
+        int r = r0[2 * j] + r0[2 * j + 1];
+        int g = g0[2 * j] + g0[2 * j + 1];
+        int b = b0[2 * j] + b0[2 * j + 1];
+        if (twoRows) {
+            r = (r + r1[2 * j] + r1[2 * j + 1] + 2) >> 2;
+            g = (g + g1[2 * j] + g1[2 * j + 1] + 2) >> 2;
+            b = (b + b1[2 * j] + b1[2 * j + 1] + 2) >> 2;
+        } else {
+            r = (r + 1) >> 1;
+            g = (g + 1) >> 1;
+            b = (b + 1) >> 1;
+        }
+        ref[2 * j] = clampByte(((-1212 * r - 2384 * g + 3596 * b + 16384) >> 15) + 128);
+        ref[2 * j + 1] = clampByte(((3596 * r - 3015 * g - 582 * b + 16384) >> 15) + 128);
+    }
+
+    std::vector<unsigned char> out(count * 2, kGuard);
+    int done = SimdKernels::rgbToUVRow(out.data(), r0.data(), g0.data(), b0.data(),
+                                       twoRows ? r1.data() : nullptr,
+                                       twoRows ? g1.data() : nullptr,
+                                       twoRows ? b1.data() : nullptr, count);
+    // Compare the UV pairs
+    checkRow(result, "uv", done * 2, count * 2, out, ref, kGuard);
+}
+
+static void usage(const char* name) {
+    printf("Usage: %s [-n iterations] [-s seed]\n", name);
+    printf("  -n  the random cases of each kernel, 10000 by default\n");
+    printf("  -s  the seed of the random cases, 1 by default\n");
+}
+
+int main(int argc, char** argv) {
+    int iterations = 10000;
+    unsigned int seed = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 's':
+                seed = strtoul(optarg, nullptr, 0);
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    gRandom.seed(seed);
+
+    static const char* kLevelNames[] = {"none", "sse4.2", "avx2"};
+    printf("SIMD level: %s, iterations: %d, seed: %u\n",
+           kLevelNames[SimdKernels::getSimdLevel()], iterations, seed);
+    fflush(stdout);
+
+    struct {
+        KernelResult result;
+        void (*check)(KernelResult* result);
+    } kernels[] = {
+        {{"bilinearRow", 0, 0, 0}, checkBilinearRow},
+        {{"bilinearRowQ16", 0, 0, 0}, checkBilinearRowQ16},
+        {{"average2x2Row", 0, 0, 0}, checkAverage2x2Row},
+        {{"swapBytePairsRow", 0, 0, 0}, checkSwapBytePairsRow},
+        {{"deinterleaveRow", 0, 0, 0}, checkDeinterleaveRow},
+        {{"interleaveRow", 0, 0, 0}, checkInterleaveRow},
+        {{"demosaicRow", 0, 0, 0}, checkDemosaicRow},
+        {{"rgbToYRow", 0, 0, 0}, checkRgbToYRow},
+        {{"rgbToUVRow", 0, 0, 0}, checkRgbToUVRow},
+    };
+
+    int failures = 0;
+    for (auto& kernel : kernels) {
+        for (int i = 0; i < iterations; i++) kernel.check(&kernel.result);
+        printf("%-18s %8d rows, %8d with SIMD, %d failed\n", kernel.result.name,
+               kernel.result.cases, kernel.result.simdCases, kernel.result.failures);
+        // Keep the passed kernels in the output if the next one crashes
+        fflush(stdout);
+        failures += kernel.result.failures;
+    }
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}